@@ -0,0 +1,255 @@
+#ifdef HEAP_TRACE
+
+#define HEAP_TRACE_IMPL
+#include "heap_trace.h"
+
+#include <string.h>
+
+// Fixed tables, so tracing takes no heap of its own
+#define MAX_SITES 32
+#define MAX_LIVE 64
+
+typedef struct {
+	const char *site;
+	int32_t live_bytes;
+	int32_t peak_bytes;
+	uint16_t allocs;
+	uint16_t frees;
+} Site;
+
+typedef struct {
+	const void *ptr;
+	int32_t bytes;
+	uint8_t site;
+} Live;
+
+static Site s_sites[MAX_SITES];
+static int s_num_sites;
+static Live s_live[MAX_LIVE];
+static int s_num_live;
+// heap_bytes_used() at its highest, as seen after each create and before
+// each destroy. What the SDK takes and gives back within one of its own
+// calls does not show.
+static size_t s_peak_used;
+// Allocations the tables had no room for
+static uint16_t s_dropped;
+
+// ---- Bookkeeping ----
+
+static void sample_peak(void)
+{
+	size_t used = heap_bytes_used();
+	if (used > s_peak_used)
+		s_peak_used = used;
+}
+
+static int find_site(const char *site)
+{
+	for (int i = 0; i < s_num_sites; i++) {
+		if (s_sites[i].site == site || !strcmp(s_sites[i].site, site))
+			return i;
+	}
+	if (s_num_sites == MAX_SITES)
+		return -1;
+	s_sites[s_num_sites] = (Site){.site = site};
+	return s_num_sites++;
+}
+
+static void *created(const char *site, size_t used_before, void *ptr)
+{
+	sample_peak();
+	if (!ptr)
+		return NULL;
+
+	int index = find_site(site);
+	if (index < 0 || s_num_live == MAX_LIVE) {
+		s_dropped++;
+		return ptr;
+	}
+	Site *s = &s_sites[index];
+	int32_t bytes = (int32_t)heap_bytes_used() - (int32_t)used_before;
+	s->allocs++;
+	s->live_bytes += bytes;
+	if (s->live_bytes > s->peak_bytes)
+		s->peak_bytes = s->live_bytes;
+	s_live[s_num_live++] =
+		(Live){.ptr = ptr, .bytes = bytes, .site = index};
+	return ptr;
+}
+
+static void destroyed(const void *ptr)
+{
+	sample_peak();
+	for (int i = 0; i < s_num_live; i++) {
+		if (s_live[i].ptr != ptr)
+			continue;
+		Site *s = &s_sites[s_live[i].site];
+		s->live_bytes -= s_live[i].bytes;
+		s->frees++;
+		s_live[i] = s_live[--s_num_live];
+		return;
+	}
+}
+
+// ---- Create ----
+
+Window *heap_trace_window_create(const char *site)
+{
+	size_t before = heap_bytes_used();
+	return created(site, before, window_create());
+}
+
+Layer *heap_trace_layer_create(const char *site, GRect frame)
+{
+	size_t before = heap_bytes_used();
+	return created(site, before, layer_create(frame));
+}
+
+Layer *heap_trace_layer_create_with_data(const char *site, GRect frame,
+					 size_t data_size)
+{
+	size_t before = heap_bytes_used();
+	return created(site, before, layer_create_with_data(frame, data_size));
+}
+
+TextLayer *heap_trace_text_layer_create(const char *site, GRect frame)
+{
+	size_t before = heap_bytes_used();
+	return created(site, before, text_layer_create(frame));
+}
+
+BitmapLayer *heap_trace_bitmap_layer_create(const char *site, GRect frame)
+{
+	size_t before = heap_bytes_used();
+	return created(site, before, bitmap_layer_create(frame));
+}
+
+GBitmap *heap_trace_gbitmap_create_with_resource(const char *site,
+						 uint32_t resource_id)
+{
+	size_t before = heap_bytes_used();
+	return created(site, before, gbitmap_create_with_resource(resource_id));
+}
+
+GBitmap *heap_trace_gbitmap_create_blank(const char *site, GSize size,
+					 GBitmapFormat format)
+{
+	size_t before = heap_bytes_used();
+	return created(site, before, gbitmap_create_blank(size, format));
+}
+
+GBitmap *heap_trace_gbitmap_create_as_sub_bitmap(const char *site,
+						 const GBitmap *base_bitmap,
+						 GRect sub_rect)
+{
+	size_t before = heap_bytes_used();
+	return created(site, before,
+		       gbitmap_create_as_sub_bitmap(base_bitmap, sub_rect));
+}
+
+GBitmapSequence *
+heap_trace_gbitmap_sequence_create_with_resource(const char *site,
+						 uint32_t resource_id)
+{
+	size_t before = heap_bytes_used();
+	return created(site, before,
+		       gbitmap_sequence_create_with_resource(resource_id));
+}
+
+GPath *heap_trace_gpath_create(const char *site, const GPathInfo *init)
+{
+	size_t before = heap_bytes_used();
+	return created(site, before, gpath_create(init));
+}
+
+// ---- Destroy ----
+
+void heap_trace_window_destroy(Window *window)
+{
+	destroyed(window);
+	window_destroy(window);
+}
+
+void heap_trace_layer_destroy(Layer *layer)
+{
+	destroyed(layer);
+	layer_destroy(layer);
+}
+
+void heap_trace_text_layer_destroy(TextLayer *text_layer)
+{
+	destroyed(text_layer);
+	text_layer_destroy(text_layer);
+}
+
+void heap_trace_bitmap_layer_destroy(BitmapLayer *bitmap_layer)
+{
+	destroyed(bitmap_layer);
+	bitmap_layer_destroy(bitmap_layer);
+}
+
+void heap_trace_gbitmap_destroy(GBitmap *bitmap)
+{
+	destroyed(bitmap);
+	gbitmap_destroy(bitmap);
+}
+
+void heap_trace_gbitmap_sequence_destroy(GBitmapSequence *sequence)
+{
+	destroyed(sequence);
+	gbitmap_sequence_destroy(sequence);
+}
+
+void heap_trace_gpath_destroy(GPath *path)
+{
+	destroyed(path);
+	gpath_destroy(path);
+}
+
+// ---- Dump ----
+
+// The largest block malloc() returns, found by bisection. Free bytes
+// outside it are fragmentation.
+static size_t largest_free_block(void)
+{
+	size_t lo = 0, hi = heap_bytes_free();
+	while (lo < hi) {
+		size_t mid = lo + (hi - lo + 1) / 2;
+		void *p = malloc(mid);
+		if (p) {
+			free(p);
+			lo = mid;
+		} else {
+			hi = mid - 1;
+		}
+	}
+	return lo;
+}
+
+void heap_trace_dump(void)
+{
+	sample_peak();
+	size_t used = heap_bytes_used();
+
+	int32_t tracked = 0;
+	for (int i = 0; i < s_num_live; i++)
+		tracked += s_live[i].bytes;
+
+	APP_LOG(APP_LOG_LEVEL_INFO,
+		"heap: used %d peak %d free %d largest %d untracked %d "
+		"dropped %d",
+		(int)used, (int)s_peak_used, (int)heap_bytes_free(),
+		(int)largest_free_block(), (int)used - (int)tracked,
+		s_dropped);
+	APP_LOG(APP_LOG_LEVEL_INFO, "heap: %-24s %6s %6s %6s %6s", "site",
+		"live", "peak", "allocs", "frees");
+	for (int i = 0; i < s_num_sites; i++) {
+		const Site *s = &s_sites[i];
+		const char *name = strrchr(s->site, '/');
+		APP_LOG(APP_LOG_LEVEL_INFO, "heap: %-24s %6d %6d %6d %6d",
+			name ? name + 1 : s->site, (int)s->live_bytes,
+			(int)s->peak_bytes, s->allocs, s->frees);
+	}
+}
+
+#endif
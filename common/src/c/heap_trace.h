@@ -0,0 +1,89 @@
+#pragma once
+
+#include <pebble.h>
+
+// Heap telemetry for development builds, compiled in by defining
+// HEAP_TRACE (HEAP_TRACE=1 pebble build, or see host/README.md).
+//
+// Included after pebble.h, it routes the SDK calls that create and destroy
+// heap objects through counters kept per call site: live bytes, the most
+// live at once, and allocation and free counts. Bytes are what
+// heap_bytes_used() moved by across the call. heap_trace_dump() logs them
+// with the heap's high-water mark and its largest free block; the faces
+// call it from deinit, and it can be called from anywhere else to see the
+// heap at that point.
+//
+// Without HEAP_TRACE none of this is compiled: the calls are the SDK's own
+// and heap_trace_dump() is empty.
+
+#ifdef HEAP_TRACE
+
+#define HEAP_TRACE_STR_(x) #x
+#define HEAP_TRACE_STR(x) HEAP_TRACE_STR_(x)
+// "file:line" of the call
+#define HEAP_TRACE_SITE __FILE__ ":" HEAP_TRACE_STR(__LINE__)
+
+void heap_trace_dump(void);
+
+Window *heap_trace_window_create(const char *site);
+Layer *heap_trace_layer_create(const char *site, GRect frame);
+Layer *heap_trace_layer_create_with_data(const char *site, GRect frame,
+					 size_t data_size);
+TextLayer *heap_trace_text_layer_create(const char *site, GRect frame);
+BitmapLayer *heap_trace_bitmap_layer_create(const char *site, GRect frame);
+GBitmap *heap_trace_gbitmap_create_with_resource(const char *site,
+						 uint32_t resource_id);
+GBitmap *heap_trace_gbitmap_create_blank(const char *site, GSize size,
+					 GBitmapFormat format);
+GBitmap *heap_trace_gbitmap_create_as_sub_bitmap(const char *site,
+						 const GBitmap *base_bitmap,
+						 GRect sub_rect);
+GBitmapSequence *
+heap_trace_gbitmap_sequence_create_with_resource(const char *site,
+						 uint32_t resource_id);
+GPath *heap_trace_gpath_create(const char *site, const GPathInfo *init);
+
+void heap_trace_window_destroy(Window *window);
+void heap_trace_layer_destroy(Layer *layer);
+void heap_trace_text_layer_destroy(TextLayer *text_layer);
+void heap_trace_bitmap_layer_destroy(BitmapLayer *bitmap_layer);
+void heap_trace_gbitmap_destroy(GBitmap *bitmap);
+void heap_trace_gbitmap_sequence_destroy(GBitmapSequence *sequence);
+void heap_trace_gpath_destroy(GPath *path);
+
+// heap_trace.c itself calls the SDK
+#ifndef HEAP_TRACE_IMPL
+#define window_create() heap_trace_window_create(HEAP_TRACE_SITE)
+#define layer_create(frame) heap_trace_layer_create(HEAP_TRACE_SITE, frame)
+#define layer_create_with_data(frame, data_size)                               \
+	heap_trace_layer_create_with_data(HEAP_TRACE_SITE, frame, data_size)
+#define text_layer_create(frame)                                               \
+	heap_trace_text_layer_create(HEAP_TRACE_SITE, frame)
+#define bitmap_layer_create(frame)                                             \
+	heap_trace_bitmap_layer_create(HEAP_TRACE_SITE, frame)
+#define gbitmap_create_with_resource(resource_id)                              \
+	heap_trace_gbitmap_create_with_resource(HEAP_TRACE_SITE, resource_id)
+#define gbitmap_create_blank(size, format)                                     \
+	heap_trace_gbitmap_create_blank(HEAP_TRACE_SITE, size, format)
+#define gbitmap_create_as_sub_bitmap(base_bitmap, sub_rect)                    \
+	heap_trace_gbitmap_create_as_sub_bitmap(HEAP_TRACE_SITE, base_bitmap,  \
+						sub_rect)
+#define gbitmap_sequence_create_with_resource(resource_id)                     \
+	heap_trace_gbitmap_sequence_create_with_resource(HEAP_TRACE_SITE,      \
+							 resource_id)
+#define gpath_create(init) heap_trace_gpath_create(HEAP_TRACE_SITE, init)
+
+#define window_destroy heap_trace_window_destroy
+#define layer_destroy heap_trace_layer_destroy
+#define text_layer_destroy heap_trace_text_layer_destroy
+#define bitmap_layer_destroy heap_trace_bitmap_layer_destroy
+#define gbitmap_destroy heap_trace_gbitmap_destroy
+#define gbitmap_sequence_destroy heap_trace_gbitmap_sequence_destroy
+#define gpath_destroy heap_trace_gpath_destroy
+#endif
+
+#else
+
+#define heap_trace_dump() ((void)0)
+
+#endif
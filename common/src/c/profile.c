@@ -0,0 +1,231 @@
+#ifdef PROFILE
+
+#define PROFILE_IMPL
+#include "profile.h"
+
+#include <string.h>
+
+// Fixed tables, so profiling takes no heap of its own
+#define MAX_ENTRIES 12
+#define MAX_PENDING_TIMERS 8
+
+#if defined(PBL_PLATFORM_APLITE)
+#define PLATFORM "aplite"
+#elif defined(PBL_PLATFORM_BASALT)
+#define PLATFORM "basalt"
+#elif defined(PBL_PLATFORM_CHALK)
+#define PLATFORM "chalk"
+#elif defined(PBL_PLATFORM_DIORITE)
+#define PLATFORM "diorite"
+#elif defined(PBL_PLATFORM_EMERY)
+#define PLATFORM "emery"
+#elif defined(PBL_PLATFORM_FLINT)
+#define PLATFORM "flint"
+#else
+#define PLATFORM "unknown"
+#endif
+
+static const char *const PRIMITIVE_NAMES[PROFILE_NUM_PRIMITIVES] = {
+	[PROFILE_DRAW_PIXEL] = "draw_pixel",
+	[PROFILE_DRAW_LINE] = "draw_line",
+	[PROFILE_DRAW_RECT] = "draw_rect",
+	[PROFILE_FILL_RECT] = "fill_rect",
+	[PROFILE_DRAW_ROUND_RECT] = "draw_round_rect",
+	[PROFILE_DRAW_CIRCLE] = "draw_circle",
+	[PROFILE_FILL_CIRCLE] = "fill_circle",
+	[PROFILE_DRAW_BITMAP] = "draw_bitmap",
+	[PROFILE_DRAW_TEXT] = "draw_text",
+	[PROFILE_GPATH_DRAW_FILLED] = "gpath_draw_filled",
+	[PROFILE_GPATH_DRAW_OUTLINE] = "gpath_draw_outline",
+};
+
+// One update proc, keyed by its layer, or one timer callback
+typedef struct {
+	const char *name;
+	const void *key;
+	LayerUpdateProc update_proc;
+	AppTimerCallback callback;
+	// The current window: ms of each call, clamped to 255, and the
+	// drawing calls made in them
+	uint8_t samples[PROFILE_WINDOW];
+	uint8_t num_samples;
+	uint16_t draws[PROFILE_NUM_PRIMITIVES];
+} Entry;
+
+typedef struct {
+	AppTimer *timer;
+	Entry *entry;
+	void *data;
+} PendingTimer;
+
+static Entry s_entries[MAX_ENTRIES];
+static int s_num_entries;
+static PendingTimer s_pending[MAX_PENDING_TIMERS];
+// The entry running, which drawing calls count against
+static Entry *s_running;
+
+// ---- Windows ----
+
+static void log_window(Entry *e)
+{
+	int n = e->num_samples;
+	if (!n)
+		return;
+
+	// Insertion sort: 100 bytes at most
+	uint8_t sorted[PROFILE_WINDOW];
+	uint32_t sum = 0;
+	for (int i = 0; i < n; i++) {
+		int j = i;
+		for (; j > 0 && sorted[j - 1] > e->samples[i]; j--)
+			sorted[j] = sorted[j - 1];
+		sorted[j] = e->samples[i];
+		sum += e->samples[i];
+	}
+	// The smallest sample at or above 99% of them
+	int p99 = sorted[(99 * n + 99) / 100 - 1];
+	int avg10 = (sum * 10 + n / 2) / n;
+
+	APP_LOG(APP_LOG_LEVEL_INFO,
+		"prof " PLATFORM " %s: %d calls, ms min %d avg %d.%d p99 %d "
+		"max %d",
+		e->name, n, sorted[0], avg10 / 10, avg10 % 10, p99,
+		sorted[n - 1]);
+
+	char line[160];
+	int len = 0;
+	for (int i = 0; i < PROFILE_NUM_PRIMITIVES; i++) {
+		if (!e->draws[i] || len >= (int)sizeof(line))
+			continue;
+		len += snprintf(line + len, sizeof(line) - len, " %s %d",
+				PRIMITIVE_NAMES[i], e->draws[i]);
+	}
+	if (len) {
+		APP_LOG(APP_LOG_LEVEL_INFO, "prof " PLATFORM " %s: drew%s",
+			e->name, line);
+	}
+
+	e->num_samples = 0;
+	memset(e->draws, 0, sizeof(e->draws));
+}
+
+static int64_t now_ms(void)
+{
+	time_t s;
+	uint16_t ms;
+	time_ms(&s, &ms);
+	return (int64_t)s * 1000 + ms;
+}
+
+// Run an entry's update proc or callback, timed, with drawing calls
+// counted against it
+#define RUN(e, call)                                                           \
+	do {                                                                   \
+		Entry *outer = s_running;                                      \
+		s_running = (e);                                               \
+		int64_t start = now_ms();                                      \
+		call;                                                          \
+		int64_t ms = now_ms() - start;                                 \
+		s_running = outer;                                             \
+		(e)->samples[(e)->num_samples++] = ms > 255 ? 255 : ms;        \
+		if ((e)->num_samples == PROFILE_WINDOW)                        \
+			log_window(e);                                         \
+	} while (0)
+
+static Entry *lookup(const void *key)
+{
+	for (int i = 0; i < s_num_entries; i++) {
+		if (s_entries[i].key == key)
+			return &s_entries[i];
+	}
+	return NULL;
+}
+
+static Entry *find_entry(const void *key, const char *name)
+{
+	Entry *e = lookup(key);
+	if (e || s_num_entries == MAX_ENTRIES)
+		return e;
+	e = &s_entries[s_num_entries++];
+	*e = (Entry){.name = name, .key = key};
+	return e;
+}
+
+void profile_count(ProfilePrimitive primitive)
+{
+	if (s_running)
+		s_running->draws[primitive]++;
+}
+
+// ---- Update procs ----
+
+static void profiled_update_proc(Layer *layer, GContext *ctx)
+{
+	Entry *e = lookup(layer);
+	if (e && e->update_proc)
+		RUN(e, e->update_proc(layer, ctx));
+}
+
+void profile_layer_set_update_proc(Layer *layer, LayerUpdateProc update_proc,
+				   const char *name)
+{
+	Entry *e = find_entry(layer, name);
+	if (!e) {
+		layer_set_update_proc(layer, update_proc);
+		return;
+	}
+	e->name = name;
+	e->update_proc = update_proc;
+	layer_set_update_proc(layer, profiled_update_proc);
+}
+
+// ---- Timers ----
+
+static void profiled_timer(void *context)
+{
+	PendingTimer *p = context;
+	Entry *e = p->entry;
+	void *data = p->data;
+	p->timer = NULL;
+	RUN(e, e->callback(data));
+}
+
+AppTimer *profile_app_timer_register(uint32_t timeout_ms,
+				     AppTimerCallback callback,
+				     void *callback_data, const char *name)
+{
+	// Timers are keyed by callback, so each callback is one entry
+	Entry *e = find_entry((const void *)callback, name);
+	PendingTimer *p = NULL;
+	for (int i = 0; i < MAX_PENDING_TIMERS && !p; i++) {
+		if (!s_pending[i].timer)
+			p = &s_pending[i];
+	}
+	if (!e || !p)
+		return app_timer_register(timeout_ms, callback, callback_data);
+
+	e->callback = callback;
+	p->entry = e;
+	p->data = callback_data;
+	p->timer = app_timer_register(timeout_ms, profiled_timer, p);
+	return p->timer;
+}
+
+void profile_app_timer_cancel(AppTimer *timer)
+{
+	for (int i = 0; i < MAX_PENDING_TIMERS; i++) {
+		if (s_pending[i].timer == timer)
+			s_pending[i].timer = NULL;
+	}
+	app_timer_cancel(timer);
+}
+
+// ---- Dump ----
+
+void profile_dump(void)
+{
+	for (int i = 0; i < s_num_entries; i++)
+		log_window(&s_entries[i]);
+}
+
+#endif
@@ -0,0 +1,100 @@
+#pragma once
+
+#include <pebble.h>
+
+// Render-time profiler for development builds, compiled in by defining
+// PROFILE (PROFILE=1 pebble build, or see host/README.md).
+//
+// Included after pebble.h, it times every layer update proc and app timer
+// callback with time_ms() and counts the drawing calls each one makes.
+// Every PROFILE_WINDOW calls of one it logs their min, average, 99th
+// percentile and max in ms and the drawing calls they made, then starts a
+// new window:
+//
+//   prof basalt sky_update_proc: 100 calls, ms min 2 avg 3.4 p99 6 max 9
+//   prof basalt sky_update_proc: drew fill_rect 2 draw_bitmap 100
+//
+// profile_dump() logs every window so far, however short; the faces call
+// it from deinit. Include it in every source file that draws, so the
+// counts cover helpers called from an update proc.
+//
+// Without PROFILE none of this is compiled and profile_dump() is empty.
+
+#ifdef PROFILE
+
+#define PROFILE_WINDOW 100
+
+typedef enum {
+	PROFILE_DRAW_PIXEL,
+	PROFILE_DRAW_LINE,
+	PROFILE_DRAW_RECT,
+	PROFILE_FILL_RECT,
+	PROFILE_DRAW_ROUND_RECT,
+	PROFILE_DRAW_CIRCLE,
+	PROFILE_FILL_CIRCLE,
+	PROFILE_DRAW_BITMAP,
+	PROFILE_DRAW_TEXT,
+	PROFILE_GPATH_DRAW_FILLED,
+	PROFILE_GPATH_DRAW_OUTLINE,
+	PROFILE_NUM_PRIMITIVES,
+} ProfilePrimitive;
+
+void profile_dump(void);
+// Count a drawing call against the update proc or timer running
+void profile_count(ProfilePrimitive primitive);
+
+void profile_layer_set_update_proc(Layer *layer, LayerUpdateProc update_proc,
+				   const char *name);
+AppTimer *profile_app_timer_register(uint32_t timeout_ms,
+				     AppTimerCallback callback,
+				     void *callback_data, const char *name);
+void profile_app_timer_cancel(AppTimer *timer);
+
+// profile.c itself calls the SDK
+#ifndef PROFILE_IMPL
+#undef layer_set_update_proc
+#define layer_set_update_proc(layer, update_proc)                              \
+	profile_layer_set_update_proc(layer, update_proc, #update_proc)
+#undef app_timer_register
+#define app_timer_register(timeout_ms, callback, callback_data)                \
+	profile_app_timer_register(timeout_ms, callback, callback_data,        \
+				   #callback)
+#define app_timer_cancel profile_app_timer_cancel
+
+#define PROFILE_COUNTED(primitive, call) (profile_count(primitive), call)
+#define graphics_draw_pixel(...)                                               \
+	PROFILE_COUNTED(PROFILE_DRAW_PIXEL, graphics_draw_pixel(__VA_ARGS__))
+#define graphics_draw_line(...)                                                \
+	PROFILE_COUNTED(PROFILE_DRAW_LINE, graphics_draw_line(__VA_ARGS__))
+#define graphics_draw_rect(...)                                                \
+	PROFILE_COUNTED(PROFILE_DRAW_RECT, graphics_draw_rect(__VA_ARGS__))
+#define graphics_fill_rect(...)                                                \
+	PROFILE_COUNTED(PROFILE_FILL_RECT, graphics_fill_rect(__VA_ARGS__))
+#define graphics_draw_round_rect(...)                                          \
+	PROFILE_COUNTED(PROFILE_DRAW_ROUND_RECT,                               \
+			graphics_draw_round_rect(__VA_ARGS__))
+#define graphics_draw_circle(...)                                              \
+	PROFILE_COUNTED(PROFILE_DRAW_CIRCLE, graphics_draw_circle(__VA_ARGS__))
+#define graphics_fill_circle(...)                                              \
+	PROFILE_COUNTED(PROFILE_FILL_CIRCLE, graphics_fill_circle(__VA_ARGS__))
+#define graphics_draw_bitmap_in_rect(...)                                      \
+	PROFILE_COUNTED(PROFILE_DRAW_BITMAP,                                   \
+			graphics_draw_bitmap_in_rect(__VA_ARGS__))
+#define graphics_draw_text(...)                                                \
+	PROFILE_COUNTED(PROFILE_DRAW_TEXT, graphics_draw_text(__VA_ARGS__))
+#define gpath_draw_filled(...)                                                 \
+	PROFILE_COUNTED(PROFILE_GPATH_DRAW_FILLED,                             \
+			gpath_draw_filled(__VA_ARGS__))
+#define gpath_draw_outline(...)                                                \
+	PROFILE_COUNTED(PROFILE_GPATH_DRAW_OUTLINE,                            \
+			gpath_draw_outline(__VA_ARGS__))
+#define gpath_draw_outline_open(...)                                           \
+	PROFILE_COUNTED(PROFILE_GPATH_DRAW_OUTLINE,                            \
+			gpath_draw_outline_open(__VA_ARGS__))
+#endif
+
+#else
+
+#define profile_dump() ((void)0)
+
+#endif
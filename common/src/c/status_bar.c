@@ -0,0 +1,100 @@
+#include "status_bar.h"
+
+#include "heap_trace.h"
+
+// Must match ICONS and ICON_SIZE in tools/battery_atlas.py
+typedef enum {
+	ICON_CHARGING,
+	ICON_FULL,
+	ICON_HEALTHY,
+	ICON_HALF,
+	ICON_LOW,
+} StatusBarIcon;
+
+#define ICON_SIZE 20
+
+static BitmapLayer *s_icon_layer;
+static TextLayer *s_text_layer;
+static GBitmap *s_atlas;
+// Shows one icon of the atlas; moving its bounds switches icon without
+// reading flash or allocating
+static GBitmap *s_icon;
+// What is on screen, -1 before the first battery state
+static int s_shown_icon = -1;
+static int s_shown_percent = -1;
+
+static StatusBarIcon icon_for(BatteryChargeState state)
+{
+	if (state.is_charging) {
+		return ICON_CHARGING;
+	} else if (state.charge_percent == 100) {
+		return ICON_FULL;
+	} else if (state.charge_percent >= 60) {
+		return ICON_HEALTHY;
+	} else if (state.charge_percent >= 40) {
+		return ICON_HALF;
+	}
+	return ICON_LOW;
+}
+
+static void battery_handler(BatteryChargeState state)
+{
+	// Many battery events change nothing the bar shows
+	StatusBarIcon icon = icon_for(state);
+	if ((int)icon != s_shown_icon && s_icon) {
+		gbitmap_set_bounds(s_icon, GRect(0, icon * ICON_SIZE, ICON_SIZE,
+						 ICON_SIZE));
+		layer_mark_dirty(bitmap_layer_get_layer(s_icon_layer));
+		s_shown_icon = icon;
+	}
+
+	if (state.charge_percent != s_shown_percent) {
+		static char s_text[8];
+		snprintf(s_text, sizeof(s_text), "%d%%", state.charge_percent);
+		text_layer_set_text(s_text_layer, s_text);
+		s_shown_percent = state.charge_percent;
+	}
+}
+
+void status_bar_init(Layer *parent, GRect icon_frame, GRect text_frame)
+{
+	s_atlas = gbitmap_create_with_resource(RESOURCE_ID_BATTERY_ATLAS);
+	if (s_atlas) {
+		s_icon = gbitmap_create_as_sub_bitmap(
+			s_atlas, GRect(0, 0, ICON_SIZE, ICON_SIZE));
+	}
+
+	s_icon_layer = bitmap_layer_create(icon_frame);
+	bitmap_layer_set_compositing_mode(s_icon_layer, GCompOpSet);
+	bitmap_layer_set_bitmap(s_icon_layer, s_icon);
+	layer_add_child(parent, bitmap_layer_get_layer(s_icon_layer));
+
+	s_text_layer = text_layer_create(text_frame);
+	text_layer_set_background_color(s_text_layer, GColorClear);
+	text_layer_set_text_color(s_text_layer, GColorBlack);
+	text_layer_set_font(s_text_layer,
+			    fonts_get_system_font(FONT_KEY_GOTHIC_14_BOLD));
+	text_layer_set_text_alignment(s_text_layer, GTextAlignmentRight);
+	layer_add_child(parent, text_layer_get_layer(s_text_layer));
+
+	battery_state_service_subscribe(battery_handler);
+	battery_handler(battery_state_service_peek());
+}
+
+void status_bar_deinit(void)
+{
+	battery_state_service_unsubscribe();
+
+	text_layer_destroy(s_text_layer);
+	bitmap_layer_destroy(s_icon_layer);
+	if (s_icon) {
+		gbitmap_destroy(s_icon);
+	}
+	if (s_atlas) {
+		gbitmap_destroy(s_atlas);
+	}
+	s_icon = NULL;
+	s_atlas = NULL;
+	s_shown_icon = -1;
+	s_shown_percent = -1;
+}
@@ -0,0 +1,11 @@
+#pragma once
+
+#include <pebble.h>
+
+// Battery icon and charge percentage, kept up to date from the battery
+// state service. Shared by the faces that show it; each places the icon
+// and the text itself. The face must declare the BATTERY_ATLAS resource
+// that tools/battery_atlas.py generates.
+
+void status_bar_init(Layer *parent, GRect icon_frame, GRect text_frame);
+void status_bar_deinit(void);
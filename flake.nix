@@ -23,6 +23,24 @@
           perryverse = pkgs.callPackage ./watchface { };
         });
 
+      # nix flake check: the host renderer's golden-image and footprint
+      # regression check (make -C host check), offline in the build sandbox.
+      # Its code sizes are read from ELF objects, hence Linux only; they are
+      # reported unchecked until code_sizes.json has nixpkgs' gcc recorded.
+      checks.x86_64-linux.host =
+        let
+          pkgs = nixpkgs.legacyPackages.x86_64-linux;
+        in
+        pkgs.stdenv.mkDerivation {
+          name = "pebble-faces-host-check";
+          src = ./.;
+          nativeBuildInputs = [ pkgs.python3 ];
+          buildInputs = [ pkgs.zlib ];
+          dontConfigure = true;
+          buildPhase = "make -C host check";
+          installPhase = "touch $out";
+        };
+
       devShells = forEachSystem (system:
         let
           pkgs = nixpkgs.legacyPackages.${system};
@@ -46,6 +64,7 @@
                   clang-tools
                   imagemagick
                   ffmpeg
+                  zlib
                 ];
 
                 git-hooks.hooks = {
@@ -0,0 +1,809 @@
+#pragma once
+
+// Host shim for the subset of the Pebble SDK 3 C API used by the watch faces
+// in this repository. Declarations mirror the SDK so the face sources compile
+// unchanged; the implementation in host/src renders into an in-memory
+// framebuffer laid out like the watch's. See host/README.md.
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+// ---- Platform ----
+
+#if defined(PBL_PLATFORM_APLITE)
+#define PBL_BW
+#define PBL_RECT
+#define PBL_DISPLAY_WIDTH 144
+#define PBL_DISPLAY_HEIGHT 168
+#elif defined(PBL_PLATFORM_BASALT)
+#define PBL_COLOR
+#define PBL_RECT
+#define PBL_HEALTH
+#define PBL_DISPLAY_WIDTH 144
+#define PBL_DISPLAY_HEIGHT 168
+#elif defined(PBL_PLATFORM_CHALK)
+#define PBL_COLOR
+#define PBL_ROUND
+#define PBL_HEALTH
+#define PBL_DISPLAY_WIDTH 180
+#define PBL_DISPLAY_HEIGHT 180
+#elif defined(PBL_PLATFORM_DIORITE) || defined(PBL_PLATFORM_FLINT)
+#define PBL_BW
+#define PBL_RECT
+#define PBL_HEALTH
+#define PBL_DISPLAY_WIDTH 144
+#define PBL_DISPLAY_HEIGHT 168
+#elif defined(PBL_PLATFORM_EMERY)
+#define PBL_COLOR
+#define PBL_RECT
+#define PBL_HEALTH
+#define PBL_DISPLAY_WIDTH 200
+#define PBL_DISPLAY_HEIGHT 228
+#else
+#error "Define one of PBL_PLATFORM_{APLITE,BASALT,CHALK,DIORITE,EMERY,FLINT}"
+#endif
+
+#ifdef PBL_COLOR
+#define PBL_IF_COLOR_ELSE(if_true, if_false) (if_true)
+#define PBL_IF_BW_ELSE(if_true, if_false) (if_false)
+#define COLOR_FALLBACK(color, bw) (color)
+#else
+#define PBL_IF_COLOR_ELSE(if_true, if_false) (if_false)
+#define PBL_IF_BW_ELSE(if_true, if_false) (if_true)
+#define COLOR_FALLBACK(color, bw) (bw)
+#endif
+
+#ifdef PBL_ROUND
+#define PBL_IF_ROUND_ELSE(if_true, if_false) (if_true)
+#define PBL_IF_RECT_ELSE(if_true, if_false) (if_false)
+#else
+#define PBL_IF_ROUND_ELSE(if_true, if_false) (if_false)
+#define PBL_IF_RECT_ELSE(if_true, if_false) (if_true)
+#endif
+
+#ifdef PBL_HEALTH
+#define PBL_IF_HEALTH_ELSE(if_true, if_false) (if_true)
+#else
+#define PBL_IF_HEALTH_ELSE(if_true, if_false) (if_false)
+#endif
+
+#define ARRAY_LENGTH(array) (sizeof(array) / sizeof((array)[0]))
+
+// ---- Logging ----
+
+typedef enum {
+	APP_LOG_LEVEL_ERROR = 1,
+	APP_LOG_LEVEL_WARNING = 50,
+	APP_LOG_LEVEL_INFO = 100,
+	APP_LOG_LEVEL_DEBUG = 200,
+	APP_LOG_LEVEL_DEBUG_VERBOSE = 255,
+} AppLogLevel;
+
+void app_log(uint8_t log_level, const char *src_filename, int src_line_number,
+	     const char *fmt, ...) __attribute__((format(printf, 4, 5)));
+
+#define APP_LOG(level, fmt, ...) \
+	app_log(level, __FILE__, __LINE__, fmt, ##__VA_ARGS__)
+
+// ---- Time ----
+
+// The faces read the clock through time() and localtime(); both are bound to
+// the simulated clock, which runs in UTC.
+time_t host_time(time_t *tloc);
+struct tm *host_localtime(const time_t *timep);
+#define time(tloc) host_time(tloc)
+#define localtime(timep) host_localtime(timep)
+
+uint16_t time_ms(time_t *tloc, uint16_t *out_ms);
+bool clock_is_24h_style(void);
+
+typedef enum {
+	SECOND_UNIT = 1 << 0,
+	MINUTE_UNIT = 1 << 1,
+	HOUR_UNIT = 1 << 2,
+	DAY_UNIT = 1 << 3,
+	MONTH_UNIT = 1 << 4,
+	YEAR_UNIT = 1 << 5,
+} TimeUnits;
+
+typedef void (*TickHandler)(struct tm *tick_time, TimeUnits units_changed);
+
+// Subscriptions, like update procs and timers, record the handler's name for
+// the host's report
+void host_tick_timer_service_subscribe(TimeUnits tick_units,
+				       TickHandler handler, const char *name);
+#define tick_timer_service_subscribe(tick_units, handler) \
+	host_tick_timer_service_subscribe(tick_units, handler, #handler)
+void tick_timer_service_unsubscribe(void);
+
+// ---- Math ----
+
+#define TRIG_MAX_ANGLE 0x10000
+#define TRIG_MAX_RATIO 0xffff
+#define DEG_TO_TRIGANGLE(angle) (((angle) * TRIG_MAX_ANGLE) / 360)
+#define TRIGANGLE_TO_DEG(trig_angle) (((trig_angle) * 360) / TRIG_MAX_ANGLE)
+
+int32_t sin_lookup(int32_t angle);
+int32_t cos_lookup(int32_t angle);
+int32_t atan2_lookup(int16_t y, int16_t x);
+
+// ---- Graphics types ----
+
+typedef struct GPoint {
+	int16_t x;
+	int16_t y;
+} GPoint;
+
+typedef struct GSize {
+	int16_t w;
+	int16_t h;
+} GSize;
+
+typedef struct GRect {
+	GPoint origin;
+	GSize size;
+} GRect;
+
+#define GPoint(x, y) ((GPoint){(x), (y)})
+#define GPointZero GPoint(0, 0)
+#define GSize(w, h) ((GSize){(w), (h)})
+#define GSizeZero GSize(0, 0)
+#define GRect(x, y, w, h) ((GRect){{(x), (y)}, {(w), (h)}})
+#define GRectZero GRect(0, 0, 0, 0)
+
+bool gpoint_equal(const GPoint *const point_a, const GPoint *const point_b);
+bool gsize_equal(const GSize *size_a, const GSize *size_b);
+bool grect_equal(const GRect *const rect_a, const GRect *const rect_b);
+bool grect_contains_point(const GRect *rect, const GPoint *point);
+GPoint grect_center_point(const GRect *rect);
+GRect grect_inset(GRect rect, int16_t inset);
+
+typedef union GColor8 {
+	uint8_t argb;
+	struct {
+		uint8_t b : 2;
+		uint8_t g : 2;
+		uint8_t r : 2;
+		uint8_t a : 2;
+	};
+} GColor8;
+
+typedef GColor8 GColor;
+
+bool gcolor_equal(GColor8 x, GColor8 y);
+GColor8 gcolor_legible_over(GColor8 background_color);
+
+#define GColorFromARGB8(v) ((GColor8){.argb = (v)})
+#define GColorFromRGB(r, g, b)                                        \
+	((GColor8){.argb = 0xC0 | (((r) >> 6) << 4) | (((g) >> 6) << 2) | \
+			   ((b) >> 6)})
+#define GColorFromHEX(v) \
+	GColorFromRGB(((v) >> 16) & 0xff, ((v) >> 8) & 0xff, (v) & 0xff)
+
+#define GColorClearARGB8 0x00
+#define GColorClear GColorFromARGB8(GColorClearARGB8)
+#define GColorBlackARGB8 0xC0
+#define GColorOxfordBlueARGB8 0xC1
+#define GColorDukeBlueARGB8 0xC2
+#define GColorBlueARGB8 0xC3
+#define GColorDarkGreenARGB8 0xC4
+#define GColorMidnightGreenARGB8 0xC5
+#define GColorCobaltBlueARGB8 0xC6
+#define GColorBlueMoonARGB8 0xC7
+#define GColorIslamicGreenARGB8 0xC8
+#define GColorJaegerGreenARGB8 0xC9
+#define GColorTiffanyBlueARGB8 0xCA
+#define GColorVividCeruleanARGB8 0xCB
+#define GColorGreenARGB8 0xCC
+#define GColorMalachiteARGB8 0xCD
+#define GColorMediumSpringGreenARGB8 0xCE
+#define GColorCyanARGB8 0xCF
+#define GColorBulgarianRoseARGB8 0xD0
+#define GColorImperialPurpleARGB8 0xD1
+#define GColorIndigoARGB8 0xD2
+#define GColorElectricUltramarineARGB8 0xD3
+#define GColorArmyGreenARGB8 0xD4
+#define GColorDarkGrayARGB8 0xD5
+#define GColorLibertyARGB8 0xD6
+#define GColorVeryLightBlueARGB8 0xD7
+#define GColorKellyGreenARGB8 0xD8
+#define GColorMayGreenARGB8 0xD9
+#define GColorCadetBlueARGB8 0xDA
+#define GColorPictonBlueARGB8 0xDB
+#define GColorBrightGreenARGB8 0xDC
+#define GColorScreaminGreenARGB8 0xDD
+#define GColorMediumAquamarineARGB8 0xDE
+#define GColorElectricBlueARGB8 0xDF
+#define GColorDarkCandyAppleRedARGB8 0xE0
+#define GColorJazzberryJamARGB8 0xE1
+#define GColorPurpleARGB8 0xE2
+#define GColorVividVioletARGB8 0xE3
+#define GColorWindsorTanARGB8 0xE4
+#define GColorRoseValeARGB8 0xE5
+#define GColorPurpureusARGB8 0xE6
+#define GColorLavenderIndigoARGB8 0xE7
+#define GColorLimerickARGB8 0xE8
+#define GColorBrassARGB8 0xE9
+#define GColorLightGrayARGB8 0xEA
+#define GColorBabyBlueEyesARGB8 0xEB
+#define GColorSpringBudARGB8 0xEC
+#define GColorInchwormARGB8 0xED
+#define GColorMintGreenARGB8 0xEE
+#define GColorCelesteARGB8 0xEF
+#define GColorRedARGB8 0xF0
+#define GColorFollyARGB8 0xF1
+#define GColorFashionMagentaARGB8 0xF2
+#define GColorMagentaARGB8 0xF3
+#define GColorOrangeARGB8 0xF4
+#define GColorSunsetOrangeARGB8 0xF5
+#define GColorBrilliantRoseARGB8 0xF6
+#define GColorShockingPinkARGB8 0xF7
+#define GColorChromeYellowARGB8 0xF8
+#define GColorRajahARGB8 0xF9
+#define GColorMelonARGB8 0xFA
+#define GColorRichBrilliantLavenderARGB8 0xFB
+#define GColorYellowARGB8 0xFC
+#define GColorIcterineARGB8 0xFD
+#define GColorPastelYellowARGB8 0xFE
+#define GColorWhiteARGB8 0xFF
+
+#define GColorBlack GColorFromARGB8(GColorBlackARGB8)
+#define GColorOxfordBlue GColorFromARGB8(GColorOxfordBlueARGB8)
+#define GColorDukeBlue GColorFromARGB8(GColorDukeBlueARGB8)
+#define GColorBlue GColorFromARGB8(GColorBlueARGB8)
+#define GColorDarkGreen GColorFromARGB8(GColorDarkGreenARGB8)
+#define GColorMidnightGreen GColorFromARGB8(GColorMidnightGreenARGB8)
+#define GColorCobaltBlue GColorFromARGB8(GColorCobaltBlueARGB8)
+#define GColorBlueMoon GColorFromARGB8(GColorBlueMoonARGB8)
+#define GColorIslamicGreen GColorFromARGB8(GColorIslamicGreenARGB8)
+#define GColorJaegerGreen GColorFromARGB8(GColorJaegerGreenARGB8)
+#define GColorTiffanyBlue GColorFromARGB8(GColorTiffanyBlueARGB8)
+#define GColorVividCerulean GColorFromARGB8(GColorVividCeruleanARGB8)
+#define GColorGreen GColorFromARGB8(GColorGreenARGB8)
+#define GColorMalachite GColorFromARGB8(GColorMalachiteARGB8)
+#define GColorMediumSpringGreen GColorFromARGB8(GColorMediumSpringGreenARGB8)
+#define GColorCyan GColorFromARGB8(GColorCyanARGB8)
+#define GColorBulgarianRose GColorFromARGB8(GColorBulgarianRoseARGB8)
+#define GColorImperialPurple GColorFromARGB8(GColorImperialPurpleARGB8)
+#define GColorIndigo GColorFromARGB8(GColorIndigoARGB8)
+#define GColorElectricUltramarine \
+	GColorFromARGB8(GColorElectricUltramarineARGB8)
+#define GColorArmyGreen GColorFromARGB8(GColorArmyGreenARGB8)
+#define GColorDarkGray GColorFromARGB8(GColorDarkGrayARGB8)
+#define GColorLiberty GColorFromARGB8(GColorLibertyARGB8)
+#define GColorVeryLightBlue GColorFromARGB8(GColorVeryLightBlueARGB8)
+#define GColorKellyGreen GColorFromARGB8(GColorKellyGreenARGB8)
+#define GColorMayGreen GColorFromARGB8(GColorMayGreenARGB8)
+#define GColorCadetBlue GColorFromARGB8(GColorCadetBlueARGB8)
+#define GColorPictonBlue GColorFromARGB8(GColorPictonBlueARGB8)
+#define GColorBrightGreen GColorFromARGB8(GColorBrightGreenARGB8)
+#define GColorScreaminGreen GColorFromARGB8(GColorScreaminGreenARGB8)
+#define GColorMediumAquamarine GColorFromARGB8(GColorMediumAquamarineARGB8)
+#define GColorElectricBlue GColorFromARGB8(GColorElectricBlueARGB8)
+#define GColorDarkCandyAppleRed GColorFromARGB8(GColorDarkCandyAppleRedARGB8)
+#define GColorJazzberryJam GColorFromARGB8(GColorJazzberryJamARGB8)
+#define GColorPurple GColorFromARGB8(GColorPurpleARGB8)
+#define GColorVividViolet GColorFromARGB8(GColorVividVioletARGB8)
+#define GColorWindsorTan GColorFromARGB8(GColorWindsorTanARGB8)
+#define GColorRoseVale GColorFromARGB8(GColorRoseValeARGB8)
+#define GColorPurpureus GColorFromARGB8(GColorPurpureusARGB8)
+#define GColorLavenderIndigo GColorFromARGB8(GColorLavenderIndigoARGB8)
+#define GColorLimerick GColorFromARGB8(GColorLimerickARGB8)
+#define GColorBrass GColorFromARGB8(GColorBrassARGB8)
+#define GColorLightGray GColorFromARGB8(GColorLightGrayARGB8)
+#define GColorBabyBlueEyes GColorFromARGB8(GColorBabyBlueEyesARGB8)
+#define GColorSpringBud GColorFromARGB8(GColorSpringBudARGB8)
+#define GColorInchworm GColorFromARGB8(GColorInchwormARGB8)
+#define GColorMintGreen GColorFromARGB8(GColorMintGreenARGB8)
+#define GColorCeleste GColorFromARGB8(GColorCelesteARGB8)
+#define GColorRed GColorFromARGB8(GColorRedARGB8)
+#define GColorFolly GColorFromARGB8(GColorFollyARGB8)
+#define GColorFashionMagenta GColorFromARGB8(GColorFashionMagentaARGB8)
+#define GColorMagenta GColorFromARGB8(GColorMagentaARGB8)
+#define GColorOrange GColorFromARGB8(GColorOrangeARGB8)
+#define GColorSunsetOrange GColorFromARGB8(GColorSunsetOrangeARGB8)
+#define GColorBrilliantRose GColorFromARGB8(GColorBrilliantRoseARGB8)
+#define GColorShockingPink GColorFromARGB8(GColorShockingPinkARGB8)
+#define GColorChromeYellow GColorFromARGB8(GColorChromeYellowARGB8)
+#define GColorRajah GColorFromARGB8(GColorRajahARGB8)
+#define GColorMelon GColorFromARGB8(GColorMelonARGB8)
+#define GColorRichBrilliantLavender \
+	GColorFromARGB8(GColorRichBrilliantLavenderARGB8)
+#define GColorYellow GColorFromARGB8(GColorYellowARGB8)
+#define GColorIcterine GColorFromARGB8(GColorIcterineARGB8)
+#define GColorPastelYellow GColorFromARGB8(GColorPastelYellowARGB8)
+#define GColorWhite GColorFromARGB8(GColorWhiteARGB8)
+
+typedef enum {
+	GCompOpAssign,
+	GCompOpAssignInverted,
+	GCompOpOr,
+	GCompOpAnd,
+	GCompOpClear,
+	GCompOpSet,
+} GCompOp;
+
+typedef enum {
+	GCornerNone = 0,
+	GCornerTopLeft = 1 << 0,
+	GCornerTopRight = 1 << 1,
+	GCornerBottomLeft = 1 << 2,
+	GCornerBottomRight = 1 << 3,
+	GCornersAll = 0xf,
+	GCornersTop = GCornerTopLeft | GCornerTopRight,
+	GCornersBottom = GCornerBottomLeft | GCornerBottomRight,
+	GCornersLeft = GCornerTopLeft | GCornerBottomLeft,
+	GCornersRight = GCornerTopRight | GCornerBottomRight,
+} GCornerMask;
+
+typedef enum {
+	GAlignCenter,
+	GAlignTopLeft,
+	GAlignTopRight,
+	GAlignTop,
+	GAlignLeft,
+	GAlignBottom,
+	GAlignRight,
+	GAlignBottomRight,
+	GAlignBottomLeft,
+} GAlign;
+
+typedef enum {
+	GTextOverflowModeWordWrap,
+	GTextOverflowModeTrailingEllipsis,
+	GTextOverflowModeFill,
+} GTextOverflowMode;
+
+typedef enum {
+	GTextAlignmentLeft,
+	GTextAlignmentCenter,
+	GTextAlignmentRight,
+} GTextAlignment;
+
+typedef struct GTextAttributes GTextAttributes;
+
+typedef struct GContext GContext;
+typedef const struct HostFont *GFont;
+
+// ---- Bitmaps ----
+
+typedef enum {
+	GBitmapFormat1Bit,
+	GBitmapFormat8Bit,
+	GBitmapFormat1BitPalette,
+	GBitmapFormat2BitPalette,
+	GBitmapFormat4BitPalette,
+	GBitmapFormat8BitCircular,
+} GBitmapFormat;
+
+typedef struct {
+	uint8_t *data;
+	int16_t min_x;
+	int16_t max_x;
+} GBitmapDataRowInfo;
+
+typedef struct GBitmap GBitmap;
+typedef struct GBitmapSequence GBitmapSequence;
+
+GBitmap *gbitmap_create_with_resource(uint32_t resource_id);
+GBitmap *gbitmap_create_blank(GSize size, GBitmapFormat format);
+GBitmap *gbitmap_create_blank_with_palette(GSize size, GBitmapFormat format,
+					   GColor *palette,
+					   bool free_on_destroy);
+GBitmap *gbitmap_create_as_sub_bitmap(const GBitmap *base_bitmap,
+				      GRect sub_rect);
+void gbitmap_destroy(GBitmap *bitmap);
+
+uint8_t *gbitmap_get_data(const GBitmap *bitmap);
+void gbitmap_set_data(GBitmap *bitmap, uint8_t *data, GBitmapFormat format,
+		      uint16_t row_size_bytes, bool free_on_destroy);
+uint16_t gbitmap_get_bytes_per_row(const GBitmap *bitmap);
+GBitmapFormat gbitmap_get_format(const GBitmap *bitmap);
+GRect gbitmap_get_bounds(const GBitmap *bitmap);
+void gbitmap_set_bounds(GBitmap *bitmap, GRect bounds);
+GColor *gbitmap_get_palette(const GBitmap *bitmap);
+void gbitmap_set_palette(GBitmap *bitmap, GColor *palette,
+			 bool free_on_destroy);
+GBitmapDataRowInfo gbitmap_get_data_row_info(const GBitmap *bitmap,
+					     uint16_t y);
+
+GBitmapSequence *gbitmap_sequence_create_with_resource(uint32_t resource_id);
+void gbitmap_sequence_destroy(GBitmapSequence *bitmap_sequence);
+bool gbitmap_sequence_restart(GBitmapSequence *bitmap_sequence);
+bool gbitmap_sequence_update_bitmap_next_frame(
+	GBitmapSequence *bitmap_sequence, GBitmap *bitmap, uint32_t *delay_ms);
+int32_t gbitmap_sequence_get_current_frame_idx(
+	GBitmapSequence *bitmap_sequence);
+uint32_t gbitmap_sequence_get_total_num_frames(
+	GBitmapSequence *bitmap_sequence);
+uint32_t gbitmap_sequence_get_play_count(GBitmapSequence *bitmap_sequence);
+void gbitmap_sequence_set_play_count(GBitmapSequence *bitmap_sequence,
+				     uint32_t play_count);
+GSize gbitmap_sequence_get_bitmap_size(GBitmapSequence *bitmap_sequence);
+
+// ---- Drawing ----
+
+void graphics_context_set_stroke_color(GContext *ctx, GColor color);
+void graphics_context_set_fill_color(GContext *ctx, GColor color);
+void graphics_context_set_text_color(GContext *ctx, GColor color);
+void graphics_context_set_compositing_mode(GContext *ctx, GCompOp mode);
+void graphics_context_set_antialiased(GContext *ctx, bool enable);
+void graphics_context_set_stroke_width(GContext *ctx, uint8_t stroke_width);
+
+void graphics_draw_pixel(GContext *ctx, GPoint point);
+void graphics_draw_line(GContext *ctx, GPoint p0, GPoint p1);
+void graphics_draw_rect(GContext *ctx, GRect rect);
+void graphics_fill_rect(GContext *ctx, GRect rect, uint16_t corner_radius,
+			GCornerMask corner_mask);
+void graphics_draw_circle(GContext *ctx, GPoint p, uint16_t radius);
+void graphics_fill_circle(GContext *ctx, GPoint p, uint16_t radius);
+void graphics_draw_round_rect(GContext *ctx, GRect rect, uint16_t radius);
+void graphics_draw_bitmap_in_rect(GContext *ctx, const GBitmap *bitmap,
+				  GRect rect);
+void graphics_draw_text(GContext *ctx, const char *text, const GFont font,
+			const GRect box, const GTextOverflowMode overflow_mode,
+			const GTextAlignment alignment,
+			GTextAttributes *text_attributes);
+
+GBitmap *graphics_capture_frame_buffer(GContext *ctx);
+GBitmap *graphics_capture_frame_buffer_format(GContext *ctx,
+					      GBitmapFormat format);
+bool graphics_release_frame_buffer(GContext *ctx, GBitmap *buffer);
+bool graphics_frame_buffer_is_captured(GContext *ctx);
+
+typedef struct {
+	uint32_t num_points;
+	GPoint *points;
+} GPathInfo;
+
+typedef struct GPath {
+	uint32_t num_points;
+	GPoint *points;
+	int32_t rotation;
+	GPoint offset;
+} GPath;
+
+GPath *gpath_create(const GPathInfo *init);
+void gpath_destroy(GPath *path);
+void gpath_rotate_to(GPath *path, int32_t angle);
+void gpath_move_to(GPath *path, GPoint point);
+void gpath_draw_filled(GContext *ctx, GPath *path);
+void gpath_draw_outline(GContext *ctx, GPath *path);
+void gpath_draw_outline_open(GContext *ctx, GPath *path);
+
+// ---- Fonts ----
+
+#define FONT_KEY_GOTHIC_14 "RESOURCE_ID_GOTHIC_14"
+#define FONT_KEY_GOTHIC_14_BOLD "RESOURCE_ID_GOTHIC_14_BOLD"
+#define FONT_KEY_GOTHIC_18 "RESOURCE_ID_GOTHIC_18"
+#define FONT_KEY_GOTHIC_18_BOLD "RESOURCE_ID_GOTHIC_18_BOLD"
+#define FONT_KEY_GOTHIC_24 "RESOURCE_ID_GOTHIC_24"
+#define FONT_KEY_GOTHIC_24_BOLD "RESOURCE_ID_GOTHIC_24_BOLD"
+#define FONT_KEY_GOTHIC_28 "RESOURCE_ID_GOTHIC_28"
+#define FONT_KEY_GOTHIC_28_BOLD "RESOURCE_ID_GOTHIC_28_BOLD"
+#define FONT_KEY_BITHAM_30_BLACK "RESOURCE_ID_BITHAM_30_BLACK"
+#define FONT_KEY_BITHAM_42_BOLD "RESOURCE_ID_BITHAM_42_BOLD"
+#define FONT_KEY_BITHAM_42_LIGHT "RESOURCE_ID_BITHAM_42_LIGHT"
+#define FONT_KEY_LECO_42_NUMBERS "RESOURCE_ID_LECO_42_NUMBERS"
+
+GFont fonts_get_system_font(const char *font_key);
+
+// ---- Layers and windows ----
+
+typedef struct Layer Layer;
+typedef struct Window Window;
+typedef struct TextLayer TextLayer;
+typedef struct BitmapLayer BitmapLayer;
+
+typedef void (*LayerUpdateProc)(Layer *layer, GContext *ctx);
+
+// The host records the name of each update proc for its report
+void host_layer_set_update_proc(Layer *layer, LayerUpdateProc update_proc,
+				const char *name);
+#define layer_set_update_proc(layer, update_proc) \
+	host_layer_set_update_proc(layer, update_proc, #update_proc)
+
+Layer *layer_create(GRect frame);
+Layer *layer_create_with_data(GRect frame, size_t data_size);
+void layer_destroy(Layer *layer);
+void layer_mark_dirty(Layer *layer);
+void layer_set_frame(Layer *layer, GRect frame);
+GRect layer_get_frame(const Layer *layer);
+void layer_set_bounds(Layer *layer, GRect bounds);
+GRect layer_get_bounds(const Layer *layer);
+GRect layer_get_unobstructed_bounds(const Layer *layer);
+void layer_set_hidden(Layer *layer, bool hidden);
+bool layer_get_hidden(const Layer *layer);
+void layer_set_clips(Layer *layer, bool clips);
+void layer_add_child(Layer *parent, Layer *child);
+void layer_remove_from_parent(Layer *child);
+void layer_remove_child_layers(Layer *parent);
+Window *layer_get_window(const Layer *layer);
+void *layer_get_data(const Layer *layer);
+
+typedef void (*WindowHandler)(Window *window);
+
+typedef struct WindowHandlers {
+	WindowHandler load;
+	WindowHandler appear;
+	WindowHandler disappear;
+	WindowHandler unload;
+} WindowHandlers;
+
+Window *window_create(void);
+void window_destroy(Window *window);
+void window_set_window_handlers(Window *window, WindowHandlers handlers);
+Layer *window_get_root_layer(const Window *window);
+void window_set_background_color(Window *window, GColor background_color);
+void window_set_user_data(Window *window, void *data);
+void *window_get_user_data(const Window *window);
+void window_stack_push(Window *window, bool animated);
+Window *window_stack_pop(bool animated);
+bool window_stack_remove(Window *window, bool animated);
+
+TextLayer *text_layer_create(GRect frame);
+void text_layer_destroy(TextLayer *text_layer);
+Layer *text_layer_get_layer(TextLayer *text_layer);
+void text_layer_set_text(TextLayer *text_layer, const char *text);
+const char *text_layer_get_text(TextLayer *text_layer);
+void text_layer_set_background_color(TextLayer *text_layer, GColor color);
+void text_layer_set_text_color(TextLayer *text_layer, GColor color);
+void text_layer_set_font(TextLayer *text_layer, GFont font);
+void text_layer_set_text_alignment(TextLayer *text_layer,
+				   GTextAlignment text_alignment);
+void text_layer_set_overflow_mode(TextLayer *text_layer,
+				  GTextOverflowMode line_mode);
+
+BitmapLayer *bitmap_layer_create(GRect frame);
+void bitmap_layer_destroy(BitmapLayer *bitmap_layer);
+Layer *bitmap_layer_get_layer(const BitmapLayer *bitmap_layer);
+const GBitmap *bitmap_layer_get_bitmap(BitmapLayer *bitmap_layer);
+void bitmap_layer_set_bitmap(BitmapLayer *bitmap_layer,
+			     const GBitmap *bitmap);
+void bitmap_layer_set_alignment(BitmapLayer *bitmap_layer, GAlign alignment);
+void bitmap_layer_set_background_color(BitmapLayer *bitmap_layer,
+				       GColor color);
+void bitmap_layer_set_compositing_mode(BitmapLayer *bitmap_layer,
+				       GCompOp mode);
+
+// ---- Resources ----
+
+typedef const struct HostResource *ResHandle;
+
+ResHandle resource_get_handle(uint32_t resource_id);
+size_t resource_size(ResHandle h);
+size_t resource_load(ResHandle h, uint8_t *buffer, size_t max_length);
+size_t resource_load_byte_range(ResHandle h, uint32_t start_offset,
+				uint8_t *buffer, size_t num_bytes);
+
+// Generated per face and platform by host/tools/resources.py
+#include "resource_ids.auto.h"
+
+// ---- Timers ----
+
+typedef struct AppTimer AppTimer;
+typedef void (*AppTimerCallback)(void *data);
+
+// The host records the name of each timer callback for its report
+AppTimer *host_app_timer_register(uint32_t timeout_ms,
+				  AppTimerCallback callback,
+				  void *callback_data, const char *name);
+#define app_timer_register(timeout_ms, callback, callback_data) \
+	host_app_timer_register(timeout_ms, callback, callback_data, #callback)
+
+bool app_timer_reschedule(AppTimer *timer_handle, uint32_t new_timeout_ms);
+void app_timer_cancel(AppTimer *timer_handle);
+
+// ---- Services ----
+
+typedef struct {
+	uint8_t charge_percent;
+	bool is_charging;
+	bool is_plugged;
+} BatteryChargeState;
+
+typedef void (*BatteryStateHandler)(BatteryChargeState charge);
+void host_battery_state_service_subscribe(BatteryStateHandler handler,
+					  const char *name);
+#define battery_state_service_subscribe(handler) \
+	host_battery_state_service_subscribe(handler, #handler)
+void battery_state_service_unsubscribe(void);
+BatteryChargeState battery_state_service_peek(void);
+
+typedef struct {
+	int16_t x;
+	int16_t y;
+	int16_t z;
+	bool did_vibrate;
+	uint64_t timestamp;
+} AccelData;
+
+typedef enum {
+	ACCEL_AXIS_X = 0,
+	ACCEL_AXIS_Y = 1,
+	ACCEL_AXIS_Z = 2,
+} AccelAxisType;
+
+typedef enum {
+	ACCEL_SAMPLING_10HZ = 10,
+	ACCEL_SAMPLING_25HZ = 25,
+	ACCEL_SAMPLING_50HZ = 50,
+	ACCEL_SAMPLING_100HZ = 100,
+} AccelSamplingRate;
+
+typedef void (*AccelDataHandler)(AccelData *data, uint32_t num_samples);
+typedef void (*AccelTapHandler)(AccelAxisType axis, int32_t direction);
+
+void host_accel_data_service_subscribe(uint32_t samples_per_update,
+				       AccelDataHandler handler,
+				       const char *name);
+#define accel_data_service_subscribe(samples_per_update, handler) \
+	host_accel_data_service_subscribe(samples_per_update, handler, #handler)
+void accel_data_service_unsubscribe(void);
+int accel_service_set_sampling_rate(AccelSamplingRate rate);
+int accel_service_set_samples_per_update(uint32_t num_samples);
+int accel_service_peek(AccelData *data);
+void host_accel_tap_service_subscribe(AccelTapHandler handler,
+				      const char *name);
+#define accel_tap_service_subscribe(handler) \
+	host_accel_tap_service_subscribe(handler, #handler)
+void accel_tap_service_unsubscribe(void);
+
+typedef void (*AppFocusHandler)(bool in_focus);
+
+typedef struct {
+	// Before a notification or other modal window covers the app, or
+	// before it goes away
+	AppFocusHandler will_focus;
+	// Once the modal window's animation has finished
+	AppFocusHandler did_focus;
+} AppFocusHandlers;
+
+void app_focus_service_subscribe_handlers(AppFocusHandlers handlers);
+void app_focus_service_subscribe(AppFocusHandler handler);
+void app_focus_service_unsubscribe(void);
+
+bool quiet_time_is_active(void);
+
+#ifdef PBL_HEALTH
+typedef enum {
+	HealthActivityNone = 0,
+	HealthActivitySleep = 1 << 0,
+	HealthActivityRestfulSleep = 1 << 1,
+	HealthActivityWalk = 1 << 2,
+	HealthActivityRun = 1 << 3,
+	HealthActivityOpenWorkout = 1 << 4,
+} HealthActivity;
+
+typedef uint32_t HealthActivityMask;
+
+HealthActivityMask health_service_peek_current_activities(void);
+#endif
+
+// ---- Dictionaries and app messages ----
+
+typedef enum {
+	TUPLE_BYTE_ARRAY = 0,
+	TUPLE_CSTRING = 1,
+	TUPLE_UINT = 2,
+	TUPLE_INT = 3,
+} TupleType;
+
+// A key and value as laid out in a serialized dictionary
+typedef struct __attribute__((__packed__)) {
+	uint32_t key;
+	TupleType type : 8;
+	uint16_t length;
+	union {
+		uint8_t data[0];
+		char cstring[0];
+		uint8_t uint8;
+		uint16_t uint16;
+		uint32_t uint32;
+		int8_t int8;
+		int16_t int16;
+		int32_t int32;
+	} value[];
+} Tuple;
+
+typedef struct Dictionary Dictionary;
+
+typedef struct {
+	Dictionary *dictionary;
+	const void *end;
+	Tuple *cursor;
+} DictionaryIterator;
+
+// Bytes a dictionary of tuple_count tuples takes, given each value's size
+uint32_t dict_calc_buffer_size(const uint8_t tuple_count, ...);
+Tuple *dict_read_first(DictionaryIterator *iter);
+Tuple *dict_read_next(DictionaryIterator *iter);
+Tuple *dict_find(const DictionaryIterator *iter, const uint32_t key);
+
+typedef enum {
+	APP_MSG_OK = 0,
+	APP_MSG_SEND_TIMEOUT = 1 << 1,
+	APP_MSG_SEND_REJECTED = 1 << 2,
+	APP_MSG_NOT_CONNECTED = 1 << 3,
+	APP_MSG_APP_NOT_RUNNING = 1 << 4,
+	APP_MSG_INVALID_ARGS = 1 << 5,
+	APP_MSG_BUSY = 1 << 6,
+	APP_MSG_BUFFER_OVERFLOW = 1 << 7,
+	APP_MSG_ALREADY_RELEASED = 1 << 9,
+	APP_MSG_CALLBACK_ALREADY_REGISTERED = 1 << 10,
+	APP_MSG_CALLBACK_NOT_REGISTERED = 1 << 11,
+	APP_MSG_OUT_OF_MEMORY = 1 << 12,
+	APP_MSG_CLOSED = 1 << 13,
+	APP_MSG_INTERNAL_ERROR = 1 << 14,
+	APP_MSG_INVALID_STATE = 1 << 15,
+} AppMessageResult;
+
+typedef void (*AppMessageInboxReceived)(DictionaryIterator *iterator,
+					void *context);
+typedef void (*AppMessageInboxDropped)(AppMessageResult reason,
+				       void *context);
+
+// The inbox and outbox are allocated on the app heap
+AppMessageResult app_message_open(const uint32_t size_inbound,
+				  const uint32_t size_outbound);
+uint32_t app_message_inbox_size_maximum(void);
+AppMessageInboxReceived
+host_app_message_register_inbox_received(AppMessageInboxReceived callback,
+					 const char *name);
+#define app_message_register_inbox_received(callback) \
+	host_app_message_register_inbox_received(callback, #callback)
+AppMessageInboxDropped
+app_message_register_inbox_dropped(AppMessageInboxDropped callback);
+void app_message_deregister_callbacks(void);
+
+// MESSAGE_KEY_* for the face's messageKeys, generated per face by
+// host/tools/resources.py in the SDK's numbering
+#include "message_keys.auto.h"
+
+// ---- Persistent storage ----
+
+#define PERSIST_DATA_MAX_LENGTH 256
+
+typedef enum {
+	S_SUCCESS = 0,
+	E_ERROR = -1,
+	E_UNKNOWN = -2,
+	E_INTERNAL = -3,
+	E_INVALID_ARGUMENT = -4,
+	E_OUT_OF_MEMORY = -5,
+	E_OUT_OF_STORAGE = -6,
+	E_OUT_OF_RESOURCES = -7,
+	E_RANGE = -8,
+	E_DOES_NOT_EXIST = -9,
+	E_INVALID_OPERATION = -10,
+	E_BUSY = -11,
+	E_AGAIN = -12,
+	S_TRUE = 1,
+	S_FALSE = 0,
+	S_NO_MORE_ITEMS = 2,
+	S_NO_ACTION_REQUIRED = 3,
+} StatusCode;
+
+typedef int32_t status_t;
+
+bool persist_exists(const uint32_t key);
+int persist_get_size(const uint32_t key);
+int persist_read_data(const uint32_t key, void *buffer,
+		      const size_t buffer_size);
+int persist_write_data(const uint32_t key, const void *data,
+		       const size_t size);
+status_t persist_delete(const uint32_t key);
+
+// ---- Memory ----
+
+size_t heap_bytes_free(void);
+size_t heap_bytes_used(void);
+
+// ---- App lifecycle ----
+
+void app_event_loop(void);
@@ -0,0 +1,523 @@
+#include "host.h"
+
+// GBitmap storage formats, resource conversion and APNG sequences.
+//
+// Bitmap resources are converted when loaded, the way the SDK's build does
+// it ahead of time: colour platforms get the smallest palettized format that
+// holds every colour in the image, 8-bit otherwise; black-and-white platforms
+// get 1-bit, or a 2-bit palette when the image has transparency.
+
+// Bits per pixel of each format; palettized pixels are packed MSB first,
+// 1-bit pixels LSB first as in the framebuffer
+static int format_bpp(GBitmapFormat format)
+{
+	switch (format) {
+	case GBitmapFormat1Bit:
+	case GBitmapFormat1BitPalette:
+		return 1;
+	case GBitmapFormat2BitPalette:
+		return 2;
+	case GBitmapFormat4BitPalette:
+		return 4;
+	case GBitmapFormat8Bit:
+	case GBitmapFormat8BitCircular:
+		return 8;
+	}
+	return 8;
+}
+
+static int format_palette_size(GBitmapFormat format)
+{
+	switch (format) {
+	case GBitmapFormat1BitPalette:
+		return 2;
+	case GBitmapFormat2BitPalette:
+		return 4;
+	case GBitmapFormat4BitPalette:
+		return 16;
+	default:
+		return 0;
+	}
+}
+
+static uint16_t format_row_size(GBitmapFormat format, int width)
+{
+	if (format == GBitmapFormat1Bit)
+		return (width + 31) / 32 * 4;
+	return (width * format_bpp(format) + 7) / 8;
+}
+
+bool host_color_is_white(GColor color)
+{
+	return color.r + color.g + color.b > 4;
+}
+
+bool gcolor_equal(GColor8 x, GColor8 y)
+{
+	// Every fully transparent colour is the same colour
+	return x.argb == y.argb || (x.a == 0 && y.a == 0);
+}
+
+bool host_bitmap_contains(const GBitmap *bitmap, int x, int y)
+{
+	const GRect *b = &bitmap->bounds;
+
+	if (x < b->origin.x || y < b->origin.y ||
+	    x >= b->origin.x + b->size.w || y >= b->origin.y + b->size.h)
+		return false;
+	if (bitmap->format == GBitmapFormat8BitCircular) {
+		int min_x = bitmap->row_min_x[y];
+		return x >= min_x && x < b->size.w - min_x;
+	}
+	return true;
+}
+
+GColor host_bitmap_get_pixel(const GBitmap *bitmap, int x, int y)
+{
+	const uint8_t *row = bitmap->addr + y * bitmap->row_size_bytes;
+	int bpp = format_bpp(bitmap->format);
+
+	switch (bitmap->format) {
+	case GBitmapFormat1Bit:
+		return row[x / 8] & (1 << (x % 8)) ? GColorWhite : GColorBlack;
+	case GBitmapFormat8Bit:
+		return (GColor){.argb = row[x]};
+	case GBitmapFormat8BitCircular:
+		return (GColor){.argb = bitmap->addr[bitmap->row_offsets[y] +
+						     x - bitmap->row_min_x[y]]};
+	default: {
+		int bit = x * bpp;
+		int shift = 8 - bpp - bit % 8;
+		int index = (row[bit / 8] >> shift) & ((1 << bpp) - 1);
+		return bitmap->palette ? bitmap->palette[index] : GColorClear;
+	}
+	}
+}
+
+static int palette_index(const GBitmap *bitmap, GColor color)
+{
+	int n = format_palette_size(bitmap->format);
+	for (int i = 0; i < n; i++) {
+		if (bitmap->palette[i].argb == color.argb)
+			return i;
+	}
+	return 0;
+}
+
+void host_bitmap_set_pixel(GBitmap *bitmap, int x, int y, GColor color)
+{
+	uint8_t *row = bitmap->addr + y * bitmap->row_size_bytes;
+	int bpp = format_bpp(bitmap->format);
+
+	switch (bitmap->format) {
+	case GBitmapFormat1Bit:
+		if (host_color_is_white(color))
+			row[x / 8] |= 1 << (x % 8);
+		else
+			row[x / 8] &= ~(1 << (x % 8));
+		return;
+	case GBitmapFormat8Bit:
+		row[x] = color.argb;
+		return;
+	case GBitmapFormat8BitCircular:
+		bitmap->addr[bitmap->row_offsets[y] + x -
+			     bitmap->row_min_x[y]] = color.argb | 0xc0;
+		return;
+	default: {
+		int bit = x * bpp;
+		int shift = 8 - bpp - bit % 8;
+		int mask = ((1 << bpp) - 1) << shift;
+		row[bit / 8] = (row[bit / 8] & ~mask) |
+			       (palette_index(bitmap, color) << shift);
+		return;
+	}
+	}
+}
+
+// ---- Creation ----
+
+static GBitmap *bitmap_alloc(GSize size, GBitmapFormat format)
+{
+	uint16_t row_size = format_row_size(format, size.w);
+	GBitmap *bitmap = host_calloc(1, sizeof(GBitmap));
+	if (!bitmap)
+		return NULL;
+
+	bitmap->addr = host_calloc(size.h, row_size);
+	if (!bitmap->addr && size.h && row_size) {
+		host_free(bitmap);
+		return NULL;
+	}
+	bitmap->row_size_bytes = row_size;
+	bitmap->format = format;
+	bitmap->bounds = GRect(0, 0, size.w, size.h);
+	bitmap->free_data = true;
+	host_count(HOST_BITMAPS_CREATED);
+	return bitmap;
+}
+
+GBitmap *gbitmap_create_blank(GSize size, GBitmapFormat format)
+{
+	if (format == GBitmapFormat8BitCircular)
+		return NULL;
+
+	int n = format_palette_size(format);
+	GColor *palette = NULL;
+	if (n) {
+		palette = host_calloc(n, sizeof(GColor));
+		if (!palette)
+			return NULL;
+	}
+	GBitmap *bitmap = bitmap_alloc(size, format);
+	if (!bitmap) {
+		host_free(palette);
+		return NULL;
+	}
+	bitmap->palette = palette;
+	bitmap->free_palette = palette != NULL;
+	return bitmap;
+}
+
+GBitmap *gbitmap_create_blank_with_palette(GSize size, GBitmapFormat format,
+					   GColor *palette,
+					   bool free_on_destroy)
+{
+	GBitmap *bitmap = bitmap_alloc(size, format);
+	if (bitmap) {
+		bitmap->palette = palette;
+		bitmap->free_palette = free_on_destroy;
+	}
+	return bitmap;
+}
+
+GBitmap *gbitmap_create_as_sub_bitmap(const GBitmap *base_bitmap,
+				      GRect sub_rect)
+{
+	GBitmap *bitmap = host_malloc(sizeof(GBitmap));
+	if (!bitmap)
+		return NULL;
+
+	*bitmap = *base_bitmap;
+	bitmap->free_data = false;
+	bitmap->free_palette = false;
+
+	// Clip to the parent's bounds, in the parent's coordinates
+	const GRect *b = &base_bitmap->bounds;
+	int x0 = sub_rect.origin.x, y0 = sub_rect.origin.y;
+	int x1 = x0 + sub_rect.size.w, y1 = y0 + sub_rect.size.h;
+	if (x0 < b->origin.x)
+		x0 = b->origin.x;
+	if (y0 < b->origin.y)
+		y0 = b->origin.y;
+	if (x1 > b->origin.x + b->size.w)
+		x1 = b->origin.x + b->size.w;
+	if (y1 > b->origin.y + b->size.h)
+		y1 = b->origin.y + b->size.h;
+	bitmap->bounds = GRect(x0, y0, x1 > x0 ? x1 - x0 : 0,
+			       y1 > y0 ? y1 - y0 : 0);
+	host_count(HOST_BITMAPS_CREATED);
+	return bitmap;
+}
+
+void gbitmap_destroy(GBitmap *bitmap)
+{
+	if (!bitmap)
+		return;
+	if (bitmap->free_data)
+		host_free(bitmap->addr);
+	if (bitmap->free_palette)
+		host_free(bitmap->palette);
+	host_free(bitmap);
+}
+
+#if defined(PBL_COLOR)
+static GColor rgba_to_native(const uint8_t *p)
+{
+	// Round each channel to the nearest of the four levels
+	GColor c;
+	c.r = (p[0] + 42) / 85;
+	c.g = (p[1] + 42) / 85;
+	c.b = (p[2] + 42) / 85;
+	c.a = (p[3] + 42) / 85;
+	if (c.a == 0)
+		c.argb = GColorClearARGB8;
+	return c;
+}
+
+#else
+static GColor rgba_to_native(const uint8_t *p)
+{
+	if (p[3] < 128)
+		return GColorClear;
+	int luma = (p[0] * 299 + p[1] * 587 + p[2] * 114) / 1000;
+	return luma >= 128 ? GColorWhite : GColorBlack;
+}
+#endif
+
+static GBitmap *bitmap_from_image(const HostImage *image)
+{
+	const int n = image->width * image->height;
+	GColor palette[16];
+	int colors = 0;
+	bool overflow = false;
+	// Opaque images are plain 1-bit on black-and-white displays
+	bool one_bit = PBL_IF_BW_ELSE(true, false);
+
+	for (int i = 0; i < n; i++) {
+		const uint8_t *p = &image->rgba[i * 4];
+		GColor c = rgba_to_native(p);
+		if (c.a < 3)
+			one_bit = false;
+		int j = 0;
+		while (j < colors && palette[j].argb != c.argb)
+			j++;
+		if (j == colors) {
+			if (colors == 16) {
+				overflow = true;
+				break;
+			}
+			palette[colors++] = c;
+		}
+	}
+
+	GBitmapFormat format;
+	if (one_bit)
+		format = GBitmapFormat1Bit;
+	else if (overflow)
+		format = GBitmapFormat8Bit;
+	else if (colors <= 2)
+		format = GBitmapFormat1BitPalette;
+	else if (colors <= 4)
+		format = GBitmapFormat2BitPalette;
+	else
+		format = GBitmapFormat4BitPalette;
+
+	GBitmap *bitmap = gbitmap_create_blank(
+		GSize(image->width, image->height), format);
+	if (!bitmap)
+		return NULL;
+	if (bitmap->palette)
+		memcpy(bitmap->palette, palette, colors * sizeof(GColor));
+
+	for (int y = 0; y < image->height; y++) {
+		for (int x = 0; x < image->width; x++) {
+			const uint8_t *p =
+				&image->rgba[(y * image->width + x) * 4];
+			host_bitmap_set_pixel(bitmap, x, y, rgba_to_native(p));
+		}
+	}
+	return bitmap;
+}
+
+GBitmap *gbitmap_create_with_resource(uint32_t resource_id)
+{
+	size_t size;
+	const uint8_t *data =
+		host_resource_data(resource_get_handle(resource_id), &size);
+	HostImage image;
+
+	if (!data || !host_png_decode(data, size, &image))
+		return NULL;
+	host_count(HOST_RESOURCE_LOADS);
+	GBitmap *bitmap = bitmap_from_image(&image);
+	host_image_free(&image);
+	return bitmap;
+}
+
+// ---- Accessors ----
+
+uint8_t *gbitmap_get_data(const GBitmap *bitmap)
+{
+	return bitmap->addr;
+}
+
+void gbitmap_set_data(GBitmap *bitmap, uint8_t *data, GBitmapFormat format,
+		      uint16_t row_size_bytes, bool free_on_destroy)
+{
+	if (bitmap->free_data)
+		host_free(bitmap->addr);
+	bitmap->addr = data;
+	bitmap->format = format;
+	bitmap->row_size_bytes = row_size_bytes;
+	bitmap->free_data = free_on_destroy;
+}
+
+uint16_t gbitmap_get_bytes_per_row(const GBitmap *bitmap)
+{
+	return bitmap->row_size_bytes;
+}
+
+GBitmapFormat gbitmap_get_format(const GBitmap *bitmap)
+{
+	return bitmap->format;
+}
+
+GRect gbitmap_get_bounds(const GBitmap *bitmap)
+{
+	return bitmap->bounds;
+}
+
+void gbitmap_set_bounds(GBitmap *bitmap, GRect bounds)
+{
+	bitmap->bounds = bounds;
+}
+
+GColor *gbitmap_get_palette(const GBitmap *bitmap)
+{
+	return bitmap->palette;
+}
+
+void gbitmap_set_palette(GBitmap *bitmap, GColor *palette,
+			 bool free_on_destroy)
+{
+	if (bitmap->free_palette)
+		host_free(bitmap->palette);
+	bitmap->palette = palette;
+	bitmap->free_palette = free_on_destroy;
+}
+
+GBitmapDataRowInfo gbitmap_get_data_row_info(const GBitmap *bitmap,
+					     uint16_t y)
+{
+	if (bitmap->format == GBitmapFormat8BitCircular) {
+		int16_t min_x = bitmap->row_min_x[y];
+		return (GBitmapDataRowInfo){
+			.data = bitmap->addr + bitmap->row_offsets[y] - min_x,
+			.min_x = min_x,
+			.max_x = bitmap->bounds.size.w - 1 - min_x,
+		};
+	}
+	return (GBitmapDataRowInfo){
+		.data = bitmap->addr + y * bitmap->row_size_bytes,
+		.min_x = 0,
+		.max_x = bitmap->bounds.origin.x + bitmap->bounds.size.w - 1,
+	};
+}
+
+// ---- Sequences ----
+
+// Charged against the heap in place of the firmware decoder's working state
+#define SEQUENCE_DECODER_BYTES 1024
+
+struct GBitmapSequence {
+	HostAnimation *anim;
+	uint32_t play_count;
+	uint32_t plays;
+	int32_t frame_idx;
+	void *decoder_state;
+};
+
+GBitmapSequence *gbitmap_sequence_create_with_resource(uint32_t resource_id)
+{
+	size_t size;
+	const uint8_t *data =
+		host_resource_data(resource_get_handle(resource_id), &size);
+	if (!data)
+		return NULL;
+
+	GBitmapSequence *seq = host_calloc(1, sizeof(GBitmapSequence));
+	if (!seq)
+		return NULL;
+	seq->decoder_state = host_malloc(SEQUENCE_DECODER_BYTES);
+	seq->anim = host_apng_open(data, size);
+	if (!seq->decoder_state || !seq->anim) {
+		gbitmap_sequence_destroy(seq);
+		return NULL;
+	}
+	host_count(HOST_RESOURCE_LOADS);
+	seq->play_count = host_apng_num_plays(seq->anim);
+	return seq;
+}
+
+void gbitmap_sequence_destroy(GBitmapSequence *bitmap_sequence)
+{
+	if (!bitmap_sequence)
+		return;
+	host_apng_close(bitmap_sequence->anim);
+	host_free(bitmap_sequence->decoder_state);
+	host_free(bitmap_sequence);
+}
+
+bool gbitmap_sequence_restart(GBitmapSequence *bitmap_sequence)
+{
+	host_apng_rewind(bitmap_sequence->anim);
+	bitmap_sequence->plays = 0;
+	bitmap_sequence->frame_idx = 0;
+	return true;
+}
+
+bool gbitmap_sequence_update_bitmap_next_frame(
+	GBitmapSequence *bitmap_sequence, GBitmap *bitmap, uint32_t *delay_ms)
+{
+	GBitmapSequence *seq = bitmap_sequence;
+	GSize size = host_apng_size(seq->anim);
+
+	if (!bitmap || bitmap->bounds.size.w < size.w ||
+	    bitmap->bounds.size.h < size.h)
+		return false;
+
+	// A play count of zero loops forever
+	if ((uint32_t)seq->frame_idx >= host_apng_num_frames(seq->anim)) {
+		seq->plays++;
+		if (seq->play_count && seq->plays >= seq->play_count)
+			return false;
+		host_apng_rewind(seq->anim);
+		seq->frame_idx = 0;
+	}
+
+	uint32_t delay = 0;
+	GRect changed;
+	size_t zsize;
+	if (!host_apng_next_frame(seq->anim, &delay, &changed, &zsize))
+		return false;
+	seq->frame_idx++;
+	host_count_n(HOST_RESOURCE_BYTES, zsize);
+
+	// As in the firmware, only the part of the bitmap the frame covers is
+	// written; the rest still holds the frames before it. The first frame
+	// after a restart covers the whole image.
+	const uint8_t *canvas = host_apng_canvas(seq->anim);
+	if (seq->frame_idx == 1)
+		changed = GRect(0, 0, size.w, size.h);
+	for (int y = changed.origin.y; y < changed.origin.y + changed.size.h;
+	     y++) {
+		for (int x = changed.origin.x;
+		     x < changed.origin.x + changed.size.w; x++) {
+			const uint8_t *p = &canvas[(y * size.w + x) * 4];
+			host_bitmap_set_pixel(
+				bitmap, bitmap->bounds.origin.x + x,
+				bitmap->bounds.origin.y + y, rgba_to_native(p));
+		}
+	}
+	if (delay_ms)
+		*delay_ms = delay;
+	return true;
+}
+
+int32_t gbitmap_sequence_get_current_frame_idx(
+	GBitmapSequence *bitmap_sequence)
+{
+	return bitmap_sequence->frame_idx;
+}
+
+uint32_t gbitmap_sequence_get_total_num_frames(
+	GBitmapSequence *bitmap_sequence)
+{
+	return host_apng_num_frames(bitmap_sequence->anim);
+}
+
+uint32_t gbitmap_sequence_get_play_count(GBitmapSequence *bitmap_sequence)
+{
+	return bitmap_sequence->play_count;
+}
+
+void gbitmap_sequence_set_play_count(GBitmapSequence *bitmap_sequence,
+				     uint32_t play_count)
+{
+	bitmap_sequence->play_count = play_count;
+}
+
+GSize gbitmap_sequence_get_bitmap_size(GBitmapSequence *bitmap_sequence)
+{
+	return host_apng_size(bitmap_sequence->anim);
+}
@@ -0,0 +1,602 @@
+#include "host.h"
+
+// Software rasterizer for the GContext drawing calls.
+//
+// Everything is drawn pixel by pixel into a framebuffer laid out like the
+// watch's: 1 bit per pixel with 20-byte rows on black-and-white platforms,
+// one GColor8 per pixel on colour ones and a packed circular buffer on chalk.
+// Antialiasing and stroke widths other than 1 are approximated without
+// blending, so edges differ from the firmware by a pixel here and there.
+
+// ---- Framebuffer ----
+
+static uint32_t s_row_offsets[PBL_DISPLAY_HEIGHT];
+static int16_t s_row_min_x[PBL_DISPLAY_HEIGHT];
+
+// Visible span of each row of the round display
+static void round_rows(GContext *ctx)
+{
+	const int w = host_platform.size.w, h = host_platform.size.h;
+	const int r = w / 2;
+	uint32_t offset = 0;
+
+	for (int y = 0; y < h; y++) {
+		int dy2 = (2 * y + 1 - h) * (2 * y + 1 - h);
+		int half = 0;
+		while (half < r && 4 * (half + 1) * (half + 1) + dy2 <= 4 * r * r)
+			half++;
+		s_row_min_x[y] = r - half;
+		s_row_offsets[y] = offset;
+		offset += 2 * half;
+	}
+
+	ctx->frame_buffer.addr = calloc(offset, 1);
+	ctx->frame_buffer.format = GBitmapFormat8BitCircular;
+	ctx->frame_buffer.row_size_bytes = w;
+	ctx->frame_buffer.row_offsets = s_row_offsets;
+	ctx->frame_buffer.row_min_x = s_row_min_x;
+}
+
+void host_graphics_init(GContext *ctx)
+{
+	const GSize size = host_platform.size;
+
+	memset(ctx, 0, sizeof(*ctx));
+	ctx->frame_buffer.bounds = GRect(0, 0, size.w, size.h);
+	if (host_platform.round) {
+		round_rows(ctx);
+	} else if (PBL_IF_COLOR_ELSE(true, false)) {
+		ctx->frame_buffer.format = GBitmapFormat8Bit;
+		ctx->frame_buffer.row_size_bytes = size.w;
+	} else {
+		ctx->frame_buffer.format = GBitmapFormat1Bit;
+		// Rows are padded to a whole number of 32-bit words
+		ctx->frame_buffer.row_size_bytes = (size.w + 31) / 32 * 4;
+	}
+	if (!ctx->frame_buffer.addr)
+		ctx->frame_buffer.addr =
+			calloc(ctx->frame_buffer.row_size_bytes, size.h);
+}
+
+void host_graphics_deinit(GContext *ctx)
+{
+	free(ctx->frame_buffer.addr);
+	ctx->frame_buffer.addr = NULL;
+}
+
+void host_graphics_begin_layer(GContext *ctx, GPoint offset, GRect clip)
+{
+	ctx->offset = offset;
+	ctx->clip = clip;
+	ctx->stroke_color = GColorBlack;
+	ctx->fill_color = GColorBlack;
+	ctx->text_color = GColorBlack;
+	ctx->compositing_mode = GCompOpAssign;
+	ctx->stroke_width = 1;
+	ctx->antialiased = true;
+}
+
+bool host_graphics_write_png(GContext *ctx, const char *path)
+{
+	const int w = host_platform.size.w, h = host_platform.size.h;
+	uint8_t *rgb = calloc((size_t)w * h, 3);
+	if (!rgb)
+		return false;
+
+	for (int y = 0; y < h; y++) {
+		for (int x = 0; x < w; x++) {
+			uint8_t *p = &rgb[(y * w + x) * 3];
+			if (!host_bitmap_contains(&ctx->frame_buffer, x, y))
+				continue;
+			GColor c = host_bitmap_get_pixel(&ctx->frame_buffer,
+							  x, y);
+			p[0] = c.r * 85;
+			p[1] = c.g * 85;
+			p[2] = c.b * 85;
+		}
+	}
+
+	bool ok = host_png_write(path, w, h, rgb);
+	free(rgb);
+	return ok;
+}
+
+GBitmap *graphics_capture_frame_buffer(GContext *ctx)
+{
+	if (ctx->frame_buffer_captured)
+		return NULL;
+	host_count_draw(HOST_CAPTURE_FB);
+	ctx->frame_buffer_captured = true;
+	return &ctx->frame_buffer;
+}
+
+GBitmap *graphics_capture_frame_buffer_format(GContext *ctx,
+					      GBitmapFormat format)
+{
+	if (format != ctx->frame_buffer.format)
+		return NULL;
+	return graphics_capture_frame_buffer(ctx);
+}
+
+bool graphics_release_frame_buffer(GContext *ctx, GBitmap *buffer)
+{
+	if (!ctx->frame_buffer_captured || buffer != &ctx->frame_buffer)
+		return false;
+	ctx->frame_buffer_captured = false;
+	return true;
+}
+
+bool graphics_frame_buffer_is_captured(GContext *ctx)
+{
+	return ctx->frame_buffer_captured;
+}
+
+// ---- Context state ----
+
+void graphics_context_set_stroke_color(GContext *ctx, GColor color)
+{
+	ctx->stroke_color = color;
+}
+
+void graphics_context_set_fill_color(GContext *ctx, GColor color)
+{
+	ctx->fill_color = color;
+}
+
+void graphics_context_set_text_color(GContext *ctx, GColor color)
+{
+	ctx->text_color = color;
+}
+
+void graphics_context_set_compositing_mode(GContext *ctx, GCompOp mode)
+{
+	ctx->compositing_mode = mode;
+}
+
+void graphics_context_set_antialiased(GContext *ctx, bool enable)
+{
+	ctx->antialiased = enable;
+}
+
+void graphics_context_set_stroke_width(GContext *ctx, uint8_t stroke_width)
+{
+	ctx->stroke_width = stroke_width ? stroke_width : 1;
+}
+
+// ---- Pixels ----
+
+// Plot at absolute display coordinates, honouring the layer clip
+static void plot(GContext *ctx, int x, int y, GColor color)
+{
+	const GRect *clip = &ctx->clip;
+
+	if (color.a == 0 || ctx->frame_buffer_captured)
+		return;
+	if (x < clip->origin.x || y < clip->origin.y ||
+	    x >= clip->origin.x + clip->size.w ||
+	    y >= clip->origin.y + clip->size.h)
+		return;
+	if (!host_bitmap_contains(&ctx->frame_buffer, x, y))
+		return;
+
+	if (color.a < 3) {
+		GColor dst = host_bitmap_get_pixel(&ctx->frame_buffer, x, y);
+		color.r = (color.r * color.a + dst.r * (3 - color.a)) / 3;
+		color.g = (color.g * color.a + dst.g * (3 - color.a)) / 3;
+		color.b = (color.b * color.a + dst.b * (3 - color.a)) / 3;
+		color.a = 3;
+	}
+	host_bitmap_set_pixel(&ctx->frame_buffer, x, y, color);
+}
+
+static void span(GContext *ctx, int x0, int x1, int y, GColor color)
+{
+	for (int x = x0; x <= x1; x++)
+		plot(ctx, x, y, color);
+}
+
+// Disc of radius r around an absolute centre
+static void disc(GContext *ctx, int cx, int cy, int r, GColor color)
+{
+	for (int dy = -r; dy <= r; dy++) {
+		int dx = 0;
+		while ((dx + 1) * (dx + 1) + dy * dy <= r * r + r)
+			dx++;
+		if (dx * dx + dy * dy <= r * r + r)
+			span(ctx, cx - dx, cx + dx, cy + dy, color);
+	}
+}
+
+static void line(GContext *ctx, int x0, int y0, int x1, int y1, GColor color)
+{
+	int dx = abs(x1 - x0), sx = x0 < x1 ? 1 : -1;
+	int dy = -abs(y1 - y0), sy = y0 < y1 ? 1 : -1;
+	int err = dx + dy;
+	int radius = ctx->stroke_width / 2;
+
+	for (;;) {
+		if (radius)
+			disc(ctx, x0, y0, radius, color);
+		else
+			plot(ctx, x0, y0, color);
+		if (x0 == x1 && y0 == y1)
+			break;
+		int e2 = 2 * err;
+		if (e2 >= dy) {
+			err += dy;
+			x0 += sx;
+		}
+		if (e2 <= dx) {
+			err += dx;
+			y0 += sy;
+		}
+	}
+}
+
+// ---- Primitives ----
+
+void graphics_draw_pixel(GContext *ctx, GPoint point)
+{
+	host_count_draw(HOST_DRAW_PIXEL);
+	plot(ctx, ctx->offset.x + point.x, ctx->offset.y + point.y,
+	     ctx->stroke_color);
+}
+
+void graphics_draw_line(GContext *ctx, GPoint p0, GPoint p1)
+{
+	host_count_draw(HOST_DRAW_LINE);
+	line(ctx, ctx->offset.x + p0.x, ctx->offset.y + p0.y,
+	     ctx->offset.x + p1.x, ctx->offset.y + p1.y, ctx->stroke_color);
+}
+
+void graphics_draw_rect(GContext *ctx, GRect rect)
+{
+	host_count_draw(HOST_DRAW_RECT);
+	if (rect.size.w <= 0 || rect.size.h <= 0)
+		return;
+
+	int x0 = ctx->offset.x + rect.origin.x;
+	int y0 = ctx->offset.y + rect.origin.y;
+	int x1 = x0 + rect.size.w - 1, y1 = y0 + rect.size.h - 1;
+	span(ctx, x0, x1, y0, ctx->stroke_color);
+	span(ctx, x0, x1, y1, ctx->stroke_color);
+	for (int y = y0 + 1; y < y1; y++) {
+		plot(ctx, x0, y, ctx->stroke_color);
+		plot(ctx, x1, y, ctx->stroke_color);
+	}
+}
+
+// Columns to drop at row dy of a rounded corner of radius r
+static int corner_inset(int r, int dy)
+{
+	int inset = r;
+	while (inset > 0 && (r - inset + 1) * (r - inset + 1) +
+					(r - dy) * (r - dy) <= r * r)
+		inset--;
+	return inset;
+}
+
+void graphics_fill_rect(GContext *ctx, GRect rect, uint16_t corner_radius,
+			GCornerMask corner_mask)
+{
+	host_count_draw(HOST_FILL_RECT);
+	if (rect.size.w <= 0 || rect.size.h <= 0)
+		return;
+
+	int r = corner_mask ? corner_radius : 0;
+	if (r > rect.size.w / 2)
+		r = rect.size.w / 2;
+	if (r > rect.size.h / 2)
+		r = rect.size.h / 2;
+
+	int x0 = ctx->offset.x + rect.origin.x;
+	int y0 = ctx->offset.y + rect.origin.y;
+	for (int dy = 0; dy < rect.size.h; dy++) {
+		int left = 0, right = 0;
+		if (dy < r) {
+			int inset = corner_inset(r, dy);
+			left = corner_mask & GCornerTopLeft ? inset : 0;
+			right = corner_mask & GCornerTopRight ? inset : 0;
+		} else if (dy >= rect.size.h - r) {
+			int inset = corner_inset(r, rect.size.h - 1 - dy);
+			left = corner_mask & GCornerBottomLeft ? inset : 0;
+			right = corner_mask & GCornerBottomRight ? inset : 0;
+		}
+		span(ctx, x0 + left, x0 + rect.size.w - 1 - right, y0 + dy,
+		     ctx->fill_color);
+	}
+}
+
+void graphics_draw_round_rect(GContext *ctx, GRect rect, uint16_t radius)
+{
+	// Outline corners are drawn square
+	graphics_draw_rect(ctx, rect);
+}
+
+void graphics_draw_circle(GContext *ctx, GPoint p, uint16_t radius)
+{
+	host_count_draw(HOST_DRAW_CIRCLE);
+
+	int cx = ctx->offset.x + p.x, cy = ctx->offset.y + p.y;
+	int half = ctx->stroke_width / 2;
+	if (half) {
+		int inner = radius > half ? radius - half : 0;
+		int outer = radius + half;
+		for (int dy = -outer; dy <= outer; dy++) {
+			for (int dx = -outer; dx <= outer; dx++) {
+				int d2 = dx * dx + dy * dy;
+				if (d2 <= outer * outer + outer &&
+				    d2 >= inner * inner - inner)
+					plot(ctx, cx + dx, cy + dy,
+					     ctx->stroke_color);
+			}
+		}
+		return;
+	}
+
+	// Midpoint circle
+	int x = radius, y = 0, err = 1 - x;
+	while (x >= y) {
+		plot(ctx, cx + x, cy + y, ctx->stroke_color);
+		plot(ctx, cx + y, cy + x, ctx->stroke_color);
+		plot(ctx, cx - y, cy + x, ctx->stroke_color);
+		plot(ctx, cx - x, cy + y, ctx->stroke_color);
+		plot(ctx, cx - x, cy - y, ctx->stroke_color);
+		plot(ctx, cx - y, cy - x, ctx->stroke_color);
+		plot(ctx, cx + y, cy - x, ctx->stroke_color);
+		plot(ctx, cx + x, cy - y, ctx->stroke_color);
+		y++;
+		if (err < 0) {
+			err += 2 * y + 1;
+		} else {
+			x--;
+			err += 2 * (y - x) + 1;
+		}
+	}
+}
+
+void graphics_fill_circle(GContext *ctx, GPoint p, uint16_t radius)
+{
+	host_count_draw(HOST_FILL_CIRCLE);
+	disc(ctx, ctx->offset.x + p.x, ctx->offset.y + p.y, radius,
+	     ctx->fill_color);
+}
+
+// ---- Paths ----
+
+GPath *gpath_create(const GPathInfo *init)
+{
+	GPath *path = host_malloc(sizeof(GPath) +
+				  init->num_points * sizeof(GPoint));
+	if (!path)
+		return NULL;
+	path->num_points = init->num_points;
+	path->points = (GPoint *)(path + 1);
+	memcpy(path->points, init->points, init->num_points * sizeof(GPoint));
+	path->rotation = 0;
+	path->offset = GPointZero;
+	return path;
+}
+
+void gpath_destroy(GPath *path)
+{
+	host_free(path);
+}
+
+void gpath_rotate_to(GPath *path, int32_t angle)
+{
+	path->rotation = angle % TRIG_MAX_ANGLE;
+}
+
+void gpath_move_to(GPath *path, GPoint point)
+{
+	path->offset = point;
+}
+
+// Rotated and translated points, in absolute display coordinates
+static void path_points(GContext *ctx, const GPath *path, GPoint *out)
+{
+	int32_t c = cos_lookup(path->rotation), s = sin_lookup(path->rotation);
+
+	for (uint32_t i = 0; i < path->num_points; i++) {
+		GPoint p = path->points[i];
+		out[i].x = p.x * c / TRIG_MAX_RATIO - p.y * s / TRIG_MAX_RATIO +
+			   path->offset.x + ctx->offset.x;
+		out[i].y = p.y * c / TRIG_MAX_RATIO + p.x * s / TRIG_MAX_RATIO +
+			   path->offset.y + ctx->offset.y;
+	}
+}
+
+static int compare_int(const void *a, const void *b)
+{
+	return *(const int *)a - *(const int *)b;
+}
+
+void gpath_draw_filled(GContext *ctx, GPath *path)
+{
+	host_count_draw(HOST_FILL_PATH);
+	if (path->num_points < 2)
+		return;
+
+	GPoint pts[path->num_points];
+	int xs[path->num_points];
+	path_points(ctx, path, pts);
+
+	int min_y = pts[0].y, max_y = pts[0].y;
+	for (uint32_t i = 1; i < path->num_points; i++) {
+		if (pts[i].y < min_y)
+			min_y = pts[i].y;
+		if (pts[i].y > max_y)
+			max_y = pts[i].y;
+	}
+
+	// Even-odd scanline fill sampled at pixel centres
+	for (int y = min_y; y <= max_y; y++) {
+		int n = 0;
+		for (uint32_t i = 0; i < path->num_points; i++) {
+			GPoint a = pts[i];
+			GPoint b = pts[(i + 1) % path->num_points];
+			if (a.y == b.y)
+				continue;
+			if (a.y > b.y) {
+				GPoint t = a;
+				a = b;
+				b = t;
+			}
+			if (y < a.y || y >= b.y)
+				continue;
+			xs[n++] = a.x + (y - a.y) * (b.x - a.x) / (b.y - a.y);
+		}
+		qsort(xs, n, sizeof(xs[0]), compare_int);
+		for (int i = 0; i + 1 < n; i += 2)
+			span(ctx, xs[i], xs[i + 1], y, ctx->fill_color);
+	}
+}
+
+static void path_outline(GContext *ctx, GPath *path, bool closed)
+{
+	host_count_draw(HOST_DRAW_PATH);
+	if (!path->num_points)
+		return;
+
+	GPoint pts[path->num_points];
+	path_points(ctx, path, pts);
+	uint32_t edges = closed ? path->num_points : path->num_points - 1;
+	for (uint32_t i = 0; i < edges; i++) {
+		GPoint b = pts[(i + 1) % path->num_points];
+		line(ctx, pts[i].x, pts[i].y, b.x, b.y, ctx->stroke_color);
+	}
+}
+
+void gpath_draw_outline(GContext *ctx, GPath *path)
+{
+	path_outline(ctx, path, true);
+}
+
+void gpath_draw_outline_open(GContext *ctx, GPath *path)
+{
+	path_outline(ctx, path, false);
+}
+
+// ---- Bitmaps ----
+
+// Composite one source pixel the way the firmware's bitblt does. Set honours
+// source alpha; on black-and-white displays it also treats opaque 1-bit
+// sources as Assign, which is how the faces use it.
+static GColor composite(GCompOp op, GColor src, GColor dst)
+{
+	bool s = host_color_is_white(src), d = host_color_is_white(dst);
+
+	switch (op) {
+	case GCompOpAssign:
+		src.a = 3;
+		return src;
+	case GCompOpSet:
+		return src;
+	case GCompOpAssignInverted:
+		return s ? GColorBlack : GColorWhite;
+	case GCompOpOr:
+		return s || d ? GColorWhite : GColorBlack;
+	case GCompOpAnd:
+		return s && d ? GColorWhite : GColorBlack;
+	case GCompOpClear:
+		return d && !s ? GColorWhite : GColorBlack;
+	}
+	return src;
+}
+
+// An unclipped Assign of a bitmap in the frame buffer's own format is a
+// copy of whole rows, as in the firmware. Only byte-aligned 1-bit rows
+// are taken. On round displays, where 8-bit bitmaps also qualify, each
+// row copies only the part the display stores.
+static bool blit_rows(GContext *ctx, const GBitmap *bitmap, int x0, int y0,
+		      GSize size)
+{
+	const GBitmap *fb = &ctx->frame_buffer;
+	const GRect src = bitmap->bounds;
+	const GRect *clip = &ctx->clip;
+	const bool circular = fb->format == GBitmapFormat8BitCircular;
+
+	if (ctx->compositing_mode != GCompOpAssign ||
+	    ctx->frame_buffer_captured ||
+	    bitmap->format != (circular ? GBitmapFormat8Bit : fb->format) ||
+	    (fb->format != GBitmapFormat8Bit &&
+	     fb->format != GBitmapFormat1Bit && !circular))
+		return false;
+	if (size.w != src.size.w || size.h != src.size.h)
+		return false;
+	if (x0 < clip->origin.x || y0 < clip->origin.y ||
+	    x0 + size.w > clip->origin.x + clip->size.w ||
+	    y0 + size.h > clip->origin.y + clip->size.h ||
+	    x0 < 0 || y0 < 0 || x0 + size.w > fb->bounds.size.w ||
+	    y0 + size.h > fb->bounds.size.h)
+		return false;
+
+	if (circular) {
+		for (int y = 0; y < size.h; y++) {
+			int min_x = fb->row_min_x[y0 + y];
+			int from = x0 > min_x ? x0 : min_x;
+			int to = x0 + size.w;
+			if (to > fb->bounds.size.w - min_x)
+				to = fb->bounds.size.w - min_x;
+			if (from >= to)
+				continue;
+			memcpy(fb->addr + fb->row_offsets[y0 + y] + from - min_x,
+			       bitmap->addr + (src.origin.y + y) *
+					      bitmap->row_size_bytes +
+				       src.origin.x + from - x0,
+			       to - from);
+		}
+		return true;
+	}
+
+	size_t offset, bytes;
+	if (fb->format == GBitmapFormat1Bit) {
+		if (x0 % 8 || src.origin.x % 8 ||
+		    (size.w % 8 && x0 + size.w != fb->bounds.size.w))
+			return false;
+		offset = src.origin.x / 8;
+		bytes = (size.w + 7) / 8;
+		x0 /= 8;
+	} else {
+		offset = src.origin.x;
+		bytes = size.w;
+	}
+	for (int y = 0; y < size.h; y++)
+		memcpy(fb->addr + (y0 + y) * fb->row_size_bytes + x0,
+		       bitmap->addr + (src.origin.y + y) *
+				      bitmap->row_size_bytes + offset,
+		       bytes);
+	return true;
+}
+
+void graphics_draw_bitmap_in_rect(GContext *ctx, const GBitmap *bitmap,
+				  GRect rect)
+{
+	host_count_draw(HOST_DRAW_BITMAP);
+	if (!bitmap || bitmap->bounds.size.w <= 0 ||
+	    bitmap->bounds.size.h <= 0)
+		return;
+
+	const GRect src = bitmap->bounds;
+	int x0 = ctx->offset.x + rect.origin.x;
+	int y0 = ctx->offset.y + rect.origin.y;
+	if (blit_rows(ctx, bitmap, x0, y0, rect.size))
+		return;
+
+	// The bitmap is tiled to fill the rectangle
+	for (int dy = 0; dy < rect.size.h; dy++) {
+		int sy = src.origin.y + dy % src.size.h;
+		for (int dx = 0; dx < rect.size.w; dx++) {
+			int sx = src.origin.x + dx % src.size.w;
+			int x = x0 + dx, y = y0 + dy;
+			if (!host_bitmap_contains(&ctx->frame_buffer, x, y))
+				continue;
+			GColor s = host_bitmap_get_pixel(bitmap, sx, sy);
+			GColor d = host_bitmap_get_pixel(&ctx->frame_buffer,
+							 x, y);
+			plot(ctx, x, y,
+			     composite(ctx->compositing_mode, s, d));
+		}
+	}
+}
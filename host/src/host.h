@@ -0,0 +1,233 @@
+#pragma once
+
+// Internal interfaces shared by the host runtime's translation units
+
+#include <pebble.h>
+
+// ---- Platform ----
+
+typedef struct {
+	const char *name;
+	GSize size;
+	bool round;
+	// App heap as documented for the platform; the app binary, which shares
+	// it on the watch, is not subtracted
+	size_t heap_size;
+} HostPlatform;
+
+extern const HostPlatform host_platform;
+
+// ---- Heap ----
+
+// Allocations made on the app's behalf are charged against the platform's
+// heap and fail like the watch's allocator once it is exhausted.
+void *host_malloc(size_t size);
+void *host_calloc(size_t count, size_t size);
+void host_free(void *ptr);
+
+// ---- Profiling ----
+
+enum HostDrawCall {
+	HOST_DRAW_PIXEL,
+	HOST_DRAW_LINE,
+	HOST_DRAW_RECT,
+	HOST_FILL_RECT,
+	HOST_DRAW_CIRCLE,
+	HOST_FILL_CIRCLE,
+	HOST_DRAW_PATH,
+	HOST_FILL_PATH,
+	HOST_DRAW_TEXT,
+	HOST_DRAW_BITMAP,
+	HOST_CAPTURE_FB,
+	HOST_NUM_DRAW_CALLS,
+};
+
+enum HostCounter {
+	HOST_FRAMES,
+	HOST_TICKS,
+	HOST_TIMERS_REGISTERED,
+	HOST_TIMERS_FIRED,
+	HOST_ACCEL_BATCHES,
+	HOST_TAPS,
+	HOST_BATTERY_EVENTS,
+	HOST_FOCUS_EVENTS,
+	HOST_MESSAGES,
+	HOST_BITMAPS_CREATED,
+	HOST_RESOURCE_LOADS,
+	// Bytes copied by resource_load_byte_range() and resource_load()
+	HOST_RESOURCE_BYTES,
+	HOST_NUM_COUNTERS,
+};
+
+void host_count_draw(enum HostDrawCall call);
+void host_count(enum HostCounter counter);
+void host_count_n(enum HostCounter counter, uint64_t n);
+// A timer with the named callback was registered or rescheduled, or stopped
+// pending after ms, by firing or being cancelled
+void host_count_timer_armed(const char *name);
+void host_count_timer_pending(const char *name, int64_t ms);
+// Attribute draw calls and wall time to the named callback until the
+// matching host_profile_end()
+void host_profile_begin(const char *name);
+void host_profile_end(void);
+
+// ---- Runtime ----
+
+extern bool host_log_quiet;
+
+// Redraw the top window and attribute the time to each update proc
+void host_render(void);
+
+// ---- Clock and event dispatch ----
+
+// Simulated milliseconds since the Unix epoch
+extern int64_t host_clock_ms;
+
+void host_set_clock(int64_t ms);
+// Advance the clock to ms, delivering ticks, timers and sensor batches in
+// order and rendering after each event that dirtied a layer
+void host_run_until(int64_t ms);
+// Jump straight to ms, as after a watch sleep: one tick for every unit that
+// changed and any timers that fell due
+void host_jump_to(int64_t ms);
+void host_set_battery(BatteryChargeState state);
+// The accelerometer reads data from now until the next call; batches
+// delivered later still see the readings they cover
+void host_set_accel(const AccelData *data);
+void host_tap(AccelAxisType axis, int32_t direction);
+// Deliver a tap, then one accelerometer batch with the arm lowered; the
+// next scheduled batch has the watch back at rest, face up, as after
+// raising the wrist
+void host_flick(void);
+// A modal window covers the app or goes away, calling the focus handlers
+void host_set_focus(bool in_focus);
+// Quiet Time and the wearer's sleep, as the face finds them next time it
+// asks; neither sends an event
+void host_set_quiet_time(bool active);
+void host_set_asleep(bool asleep);
+
+// ---- App messages ----
+
+struct HostMessageKey {
+	uint32_t id;
+	const char *name;
+};
+
+// The face's messageKeys, generated by host/tools/resources.py
+extern const struct HostMessageKey host_message_keys[];
+
+// Send the face a message from the phone: comma-separated KEY=VALUE pairs,
+// each KEY one of its messageKeys. Integer values go as int32s, others as
+// strings. Returns what is wrong with spec, or NULL once it is delivered
+// or turned away.
+const char *host_send_message(const char *spec);
+// Free the inbox and outbox, as the system does when the app exits
+void host_app_message_close(void);
+
+// ---- Persistent storage ----
+
+// Load storage from the file at path, if it exists, or save it there
+void host_persist_load(const char *path);
+void host_persist_save(const char *path);
+
+// ---- Traces ----
+
+// The time on the trace's start line, or -1 if it has none
+int64_t host_trace_start(const char *path);
+// Replay the trace's events, timed from its start line if jump_to_start,
+// otherwise from the current time. Exits on a malformed trace.
+void host_trace_replay(const char *path, bool jump_to_start);
+
+// ---- Graphics ----
+
+struct GBitmap {
+	uint8_t *addr;
+	uint16_t row_size_bytes;
+	GBitmapFormat format;
+	GRect bounds;
+	GColor *palette;
+	bool free_data;
+	bool free_palette;
+	// GBitmapFormat8BitCircular: byte offset and first column of each row
+	const uint32_t *row_offsets;
+	const int16_t *row_min_x;
+};
+
+struct GContext {
+	GBitmap frame_buffer;
+	bool frame_buffer_captured;
+	// Absolute origin of the layer being drawn and the rectangle it may
+	// touch
+	GPoint offset;
+	GRect clip;
+	GColor stroke_color;
+	GColor fill_color;
+	GColor text_color;
+	GCompOp compositing_mode;
+	uint8_t stroke_width;
+	bool antialiased;
+};
+
+void host_graphics_init(GContext *ctx);
+void host_graphics_deinit(GContext *ctx);
+// Reset the drawing state before a layer's update proc runs
+void host_graphics_begin_layer(GContext *ctx, GPoint offset, GRect clip);
+// Write the display contents as an RGB PNG
+bool host_graphics_write_png(GContext *ctx, const char *path);
+
+GColor host_bitmap_get_pixel(const GBitmap *bitmap, int x, int y);
+void host_bitmap_set_pixel(GBitmap *bitmap, int x, int y, GColor color);
+bool host_bitmap_contains(const GBitmap *bitmap, int x, int y);
+// Nearest 1-bit value of a colour on black-and-white displays
+bool host_color_is_white(GColor color);
+
+// ---- Window stack ----
+
+void host_window_render(GContext *ctx);
+bool host_window_needs_render(void);
+void host_window_mark_all_dirty(void);
+void host_window_unload_all(void);
+
+// ---- Images ----
+
+typedef struct {
+	int width;
+	int height;
+	uint8_t *rgba;
+} HostImage;
+
+typedef struct HostAnimation HostAnimation;
+
+// Decode a PNG, or the default image of an APNG, to 8-bit RGBA
+bool host_png_decode(const uint8_t *data, size_t size, HostImage *image);
+void host_image_free(HostImage *image);
+bool host_png_write(const char *path, int width, int height,
+		    const uint8_t *rgb);
+
+// APNG playback: frames are composited onto a canvas the size of the image
+HostAnimation *host_apng_open(const uint8_t *data, size_t size);
+void host_apng_close(HostAnimation *anim);
+GSize host_apng_size(const HostAnimation *anim);
+uint32_t host_apng_num_frames(const HostAnimation *anim);
+uint32_t host_apng_num_plays(const HostAnimation *anim);
+// Render the next frame onto the canvas, returning its delay, the part of
+// the canvas that changed and how many compressed bytes it read
+bool host_apng_next_frame(HostAnimation *anim, uint32_t *delay_ms,
+			  GRect *changed, size_t *zsize);
+void host_apng_rewind(HostAnimation *anim);
+const uint8_t *host_apng_canvas(const HostAnimation *anim);
+
+// ---- Resources ----
+
+struct HostResource {
+	uint32_t id;
+	const char *name;
+	const char *path;
+};
+
+// Generated per face and platform by host/tools/resources.py
+extern const struct HostResource host_resources[];
+extern const size_t host_num_resources;
+
+// Load the resource's bytes; the data stays resident like flash
+const uint8_t *host_resource_data(ResHandle h, size_t *size);
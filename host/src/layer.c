@@ -0,0 +1,568 @@
+#include "host.h"
+
+// Layers, windows, TextLayer and BitmapLayer.
+//
+// As on the watch, marking any layer dirty redraws the whole layer tree of
+// the top window: background first, then every visible layer parent before
+// children, each clipped to its frame.
+
+struct Layer {
+	GRect frame;
+	GRect bounds;
+	LayerUpdateProc update_proc;
+	const char *update_proc_name;
+	Layer *parent;
+	Layer *first_child;
+	Layer *next_sibling;
+	Window *window;
+	bool hidden;
+	bool clips;
+	void *data;
+};
+
+struct Window {
+	Layer root;
+	GColor background_color;
+	WindowHandlers handlers;
+	void *user_data;
+	bool on_stack;
+};
+
+struct TextLayer {
+	Layer layer;
+	const char *text;
+	GFont font;
+	GColor text_color;
+	GColor background_color;
+	GTextAlignment alignment;
+	GTextOverflowMode overflow_mode;
+};
+
+struct BitmapLayer {
+	Layer layer;
+	const GBitmap *bitmap;
+	GColor background_color;
+	GAlign alignment;
+	GCompOp compositing_mode;
+};
+
+#define MAX_WINDOWS 4
+
+static Window *s_stack[MAX_WINDOWS];
+static int s_stack_depth;
+static bool s_dirty;
+
+// ---- Layers ----
+
+static void layer_init(Layer *layer, GRect frame)
+{
+	layer->frame = frame;
+	layer->bounds = GRect(0, 0, frame.size.w, frame.size.h);
+	layer->clips = true;
+}
+
+Layer *layer_create(GRect frame)
+{
+	return layer_create_with_data(frame, 0);
+}
+
+Layer *layer_create_with_data(GRect frame, size_t data_size)
+{
+	Layer *layer = host_calloc(1, sizeof(Layer) + data_size);
+	if (!layer)
+		return NULL;
+	layer_init(layer, frame);
+	if (data_size)
+		layer->data = layer + 1;
+	return layer;
+}
+
+void layer_destroy(Layer *layer)
+{
+	if (!layer)
+		return;
+	layer_remove_from_parent(layer);
+	host_free(layer);
+}
+
+void host_layer_set_update_proc(Layer *layer, LayerUpdateProc update_proc,
+				const char *name)
+{
+	layer->update_proc = update_proc;
+	layer->update_proc_name = name;
+}
+
+void layer_mark_dirty(Layer *layer)
+{
+	s_dirty = true;
+}
+
+void layer_set_frame(Layer *layer, GRect frame)
+{
+	layer->frame = frame;
+	layer->bounds.size = frame.size;
+	s_dirty = true;
+}
+
+GRect layer_get_frame(const Layer *layer)
+{
+	return layer->frame;
+}
+
+void layer_set_bounds(Layer *layer, GRect bounds)
+{
+	layer->bounds = bounds;
+	s_dirty = true;
+}
+
+GRect layer_get_bounds(const Layer *layer)
+{
+	return layer->bounds;
+}
+
+GRect layer_get_unobstructed_bounds(const Layer *layer)
+{
+	return layer->bounds;
+}
+
+void layer_set_hidden(Layer *layer, bool hidden)
+{
+	if (layer->hidden != hidden)
+		s_dirty = true;
+	layer->hidden = hidden;
+}
+
+bool layer_get_hidden(const Layer *layer)
+{
+	return layer->hidden;
+}
+
+void layer_set_clips(Layer *layer, bool clips)
+{
+	layer->clips = clips;
+}
+
+static void set_window(Layer *layer, Window *window)
+{
+	layer->window = window;
+	for (Layer *c = layer->first_child; c; c = c->next_sibling)
+		set_window(c, window);
+}
+
+void layer_add_child(Layer *parent, Layer *child)
+{
+	layer_remove_from_parent(child);
+	child->parent = parent;
+	Layer **link = &parent->first_child;
+	while (*link)
+		link = &(*link)->next_sibling;
+	*link = child;
+	set_window(child, parent->window);
+	s_dirty = true;
+}
+
+void layer_remove_from_parent(Layer *child)
+{
+	if (!child->parent)
+		return;
+	Layer **link = &child->parent->first_child;
+	while (*link != child)
+		link = &(*link)->next_sibling;
+	*link = child->next_sibling;
+	child->parent = NULL;
+	child->next_sibling = NULL;
+	set_window(child, NULL);
+	s_dirty = true;
+}
+
+void layer_remove_child_layers(Layer *parent)
+{
+	while (parent->first_child)
+		layer_remove_from_parent(parent->first_child);
+}
+
+Window *layer_get_window(const Layer *layer)
+{
+	return layer->window;
+}
+
+void *layer_get_data(const Layer *layer)
+{
+	return layer->data;
+}
+
+// ---- Windows ----
+
+Window *window_create(void)
+{
+	Window *window = host_calloc(1, sizeof(Window));
+	if (!window)
+		return NULL;
+	layer_init(&window->root, GRect(0, 0, host_platform.size.w,
+					host_platform.size.h));
+	window->root.window = window;
+	window->background_color = GColorWhite;
+	return window;
+}
+
+void window_destroy(Window *window)
+{
+	if (!window)
+		return;
+	window_stack_remove(window, false);
+	layer_remove_child_layers(&window->root);
+	host_free(window);
+}
+
+void window_set_window_handlers(Window *window, WindowHandlers handlers)
+{
+	window->handlers = handlers;
+}
+
+Layer *window_get_root_layer(const Window *window)
+{
+	return (Layer *)&window->root;
+}
+
+void window_set_background_color(Window *window, GColor background_color)
+{
+	window->background_color = background_color;
+	s_dirty = true;
+}
+
+void window_set_user_data(Window *window, void *data)
+{
+	window->user_data = data;
+}
+
+void *window_get_user_data(const Window *window)
+{
+	return window->user_data;
+}
+
+void window_stack_push(Window *window, bool animated)
+{
+	if (window->on_stack || s_stack_depth == MAX_WINDOWS)
+		return;
+
+	if (s_stack_depth && s_stack[s_stack_depth - 1]->handlers.disappear)
+		s_stack[s_stack_depth - 1]->handlers.disappear(
+			s_stack[s_stack_depth - 1]);
+	s_stack[s_stack_depth++] = window;
+	window->on_stack = true;
+	if (window->handlers.load)
+		window->handlers.load(window);
+	if (window->handlers.appear)
+		window->handlers.appear(window);
+	s_dirty = true;
+}
+
+bool window_stack_remove(Window *window, bool animated)
+{
+	int i = 0;
+	while (i < s_stack_depth && s_stack[i] != window)
+		i++;
+	if (i == s_stack_depth)
+		return false;
+
+	bool top = i == s_stack_depth - 1;
+	memmove(&s_stack[i], &s_stack[i + 1],
+		(s_stack_depth - i - 1) * sizeof(s_stack[0]));
+	s_stack_depth--;
+	window->on_stack = false;
+	if (top && window->handlers.disappear)
+		window->handlers.disappear(window);
+	if (window->handlers.unload)
+		window->handlers.unload(window);
+	if (top && s_stack_depth && s_stack[s_stack_depth - 1]->handlers.appear)
+		s_stack[s_stack_depth - 1]->handlers.appear(
+			s_stack[s_stack_depth - 1]);
+	s_dirty = true;
+	return true;
+}
+
+Window *window_stack_pop(bool animated)
+{
+	if (!s_stack_depth)
+		return NULL;
+	Window *window = s_stack[s_stack_depth - 1];
+	window_stack_remove(window, animated);
+	return window;
+}
+
+void host_window_unload_all(void)
+{
+	while (s_stack_depth)
+		window_stack_pop(false);
+}
+
+// ---- Rendering ----
+
+static GRect intersect(GRect a, GRect b)
+{
+	int x0 = a.origin.x > b.origin.x ? a.origin.x : b.origin.x;
+	int y0 = a.origin.y > b.origin.y ? a.origin.y : b.origin.y;
+	int x1 = a.origin.x + a.size.w < b.origin.x + b.size.w ?
+			 a.origin.x + a.size.w :
+			 b.origin.x + b.size.w;
+	int y1 = a.origin.y + a.size.h < b.origin.y + b.size.h ?
+			 a.origin.y + a.size.h :
+			 b.origin.y + b.size.h;
+	return GRect(x0, y0, x1 > x0 ? x1 - x0 : 0, y1 > y0 ? y1 - y0 : 0);
+}
+
+// parent_origin is the absolute position of the parent's bounds origin
+static void render_layer(GContext *ctx, Layer *layer, GPoint parent_origin,
+			 GRect parent_clip)
+{
+	if (layer->hidden)
+		return;
+
+	GRect frame = layer->frame;
+	frame.origin.x += parent_origin.x;
+	frame.origin.y += parent_origin.y;
+	GRect clip = layer->clips ? intersect(parent_clip, frame) : parent_clip;
+	GPoint origin = GPoint(frame.origin.x + layer->bounds.origin.x,
+			       frame.origin.y + layer->bounds.origin.y);
+
+	if (layer->update_proc) {
+		host_graphics_begin_layer(ctx, origin, clip);
+		host_profile_begin(layer->update_proc_name);
+		layer->update_proc(layer, ctx);
+		host_profile_end();
+		if (ctx->frame_buffer_captured) {
+			APP_LOG(APP_LOG_LEVEL_WARNING,
+				"%s returned without releasing the frame buffer",
+				layer->update_proc_name);
+			ctx->frame_buffer_captured = false;
+		}
+	}
+
+	for (Layer *c = layer->first_child; c; c = c->next_sibling)
+		render_layer(ctx, c, origin, clip);
+}
+
+void host_window_render(GContext *ctx)
+{
+	s_dirty = false;
+	if (!s_stack_depth)
+		return;
+
+	Window *window = s_stack[s_stack_depth - 1];
+	GRect screen = GRect(0, 0, host_platform.size.w, host_platform.size.h);
+
+	host_graphics_begin_layer(ctx, GPointZero, screen);
+	ctx->fill_color = window->background_color;
+	host_profile_begin(NULL);
+	graphics_fill_rect(ctx, screen, 0, GCornerNone);
+	host_profile_end();
+	render_layer(ctx, &window->root, GPointZero, screen);
+	host_count(HOST_FRAMES);
+}
+
+bool host_window_needs_render(void)
+{
+	return s_dirty && s_stack_depth;
+}
+
+void host_window_mark_all_dirty(void)
+{
+	s_dirty = true;
+}
+
+// ---- TextLayer ----
+
+static void text_layer_update_proc(Layer *layer, GContext *ctx)
+{
+	TextLayer *text_layer = (TextLayer *)layer;
+	GRect bounds = layer->bounds;
+
+	if (text_layer->background_color.a) {
+		graphics_context_set_fill_color(ctx,
+						text_layer->background_color);
+		graphics_fill_rect(ctx, bounds, 0, GCornerNone);
+	}
+	graphics_context_set_text_color(ctx, text_layer->text_color);
+	graphics_draw_text(ctx, text_layer->text, text_layer->font, bounds,
+			   text_layer->overflow_mode, text_layer->alignment,
+			   NULL);
+}
+
+TextLayer *text_layer_create(GRect frame)
+{
+	TextLayer *text_layer = host_calloc(1, sizeof(TextLayer));
+	if (!text_layer)
+		return NULL;
+	layer_init(&text_layer->layer, frame);
+	layer_set_update_proc(&text_layer->layer, text_layer_update_proc);
+	text_layer->font = fonts_get_system_font(FONT_KEY_GOTHIC_14);
+	text_layer->text_color = GColorBlack;
+	text_layer->background_color = GColorWhite;
+	text_layer->alignment = GTextAlignmentLeft;
+	text_layer->overflow_mode = GTextOverflowModeWordWrap;
+	return text_layer;
+}
+
+void text_layer_destroy(TextLayer *text_layer)
+{
+	if (!text_layer)
+		return;
+	layer_remove_from_parent(&text_layer->layer);
+	host_free(text_layer);
+}
+
+Layer *text_layer_get_layer(TextLayer *text_layer)
+{
+	return &text_layer->layer;
+}
+
+void text_layer_set_text(TextLayer *text_layer, const char *text)
+{
+	text_layer->text = text;
+	s_dirty = true;
+}
+
+const char *text_layer_get_text(TextLayer *text_layer)
+{
+	return text_layer->text;
+}
+
+void text_layer_set_background_color(TextLayer *text_layer, GColor color)
+{
+	text_layer->background_color = color;
+	s_dirty = true;
+}
+
+void text_layer_set_text_color(TextLayer *text_layer, GColor color)
+{
+	text_layer->text_color = color;
+	s_dirty = true;
+}
+
+void text_layer_set_font(TextLayer *text_layer, GFont font)
+{
+	text_layer->font = font;
+	s_dirty = true;
+}
+
+void text_layer_set_text_alignment(TextLayer *text_layer,
+				   GTextAlignment text_alignment)
+{
+	text_layer->alignment = text_alignment;
+	s_dirty = true;
+}
+
+void text_layer_set_overflow_mode(TextLayer *text_layer,
+				  GTextOverflowMode line_mode)
+{
+	text_layer->overflow_mode = line_mode;
+	s_dirty = true;
+}
+
+// ---- BitmapLayer ----
+
+static void bitmap_layer_update_proc(Layer *layer, GContext *ctx)
+{
+	BitmapLayer *bitmap_layer = (BitmapLayer *)layer;
+	GRect bounds = layer->bounds;
+
+	if (bitmap_layer->background_color.a) {
+		graphics_context_set_fill_color(ctx,
+						bitmap_layer->background_color);
+		graphics_fill_rect(ctx, bounds, 0, GCornerNone);
+	}
+	if (!bitmap_layer->bitmap)
+		return;
+
+	GSize size = gbitmap_get_bounds(bitmap_layer->bitmap).size;
+	GRect rect = GRect(0, 0, size.w, size.h);
+	int dx = bounds.size.w - size.w, dy = bounds.size.h - size.h;
+	switch (bitmap_layer->alignment) {
+	case GAlignCenter:
+		rect.origin = GPoint(dx / 2, dy / 2);
+		break;
+	case GAlignTopLeft:
+		break;
+	case GAlignTopRight:
+		rect.origin.x = dx;
+		break;
+	case GAlignTop:
+		rect.origin.x = dx / 2;
+		break;
+	case GAlignLeft:
+		rect.origin.y = dy / 2;
+		break;
+	case GAlignBottom:
+		rect.origin = GPoint(dx / 2, dy);
+		break;
+	case GAlignRight:
+		rect.origin = GPoint(dx, dy / 2);
+		break;
+	case GAlignBottomRight:
+		rect.origin = GPoint(dx, dy);
+		break;
+	case GAlignBottomLeft:
+		rect.origin.y = dy;
+		break;
+	}
+	graphics_context_set_compositing_mode(ctx,
+					      bitmap_layer->compositing_mode);
+	graphics_draw_bitmap_in_rect(ctx, bitmap_layer->bitmap, rect);
+}
+
+BitmapLayer *bitmap_layer_create(GRect frame)
+{
+	BitmapLayer *bitmap_layer = host_calloc(1, sizeof(BitmapLayer));
+	if (!bitmap_layer)
+		return NULL;
+	layer_init(&bitmap_layer->layer, frame);
+	layer_set_update_proc(&bitmap_layer->layer, bitmap_layer_update_proc);
+	bitmap_layer->background_color = GColorClear;
+	bitmap_layer->alignment = GAlignCenter;
+	bitmap_layer->compositing_mode = GCompOpAssign;
+	return bitmap_layer;
+}
+
+void bitmap_layer_destroy(BitmapLayer *bitmap_layer)
+{
+	if (!bitmap_layer)
+		return;
+	layer_remove_from_parent(&bitmap_layer->layer);
+	host_free(bitmap_layer);
+}
+
+Layer *bitmap_layer_get_layer(const BitmapLayer *bitmap_layer)
+{
+	return (Layer *)&bitmap_layer->layer;
+}
+
+const GBitmap *bitmap_layer_get_bitmap(BitmapLayer *bitmap_layer)
+{
+	return bitmap_layer->bitmap;
+}
+
+void bitmap_layer_set_bitmap(BitmapLayer *bitmap_layer, const GBitmap *bitmap)
+{
+	bitmap_layer->bitmap = bitmap;
+	s_dirty = true;
+}
+
+void bitmap_layer_set_alignment(BitmapLayer *bitmap_layer, GAlign alignment)
+{
+	bitmap_layer->alignment = alignment;
+	s_dirty = true;
+}
+
+void bitmap_layer_set_background_color(BitmapLayer *bitmap_layer,
+				       GColor color)
+{
+	bitmap_layer->background_color = color;
+	s_dirty = true;
+}
+
+void bitmap_layer_set_compositing_mode(BitmapLayer *bitmap_layer,
+				       GCompOp mode)
+{
+	bitmap_layer->compositing_mode = mode;
+	s_dirty = true;
+}
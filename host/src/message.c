@@ -0,0 +1,202 @@
+#include "host.h"
+
+#include <stdarg.h>
+
+// Dictionaries in the SDK's serialized layout, and an app message inbox
+// that messages from the phone are written into. The phone side does not
+// run here: scenarios send the messages its JavaScript would.
+
+// A count byte, then the tuples back to back
+#define DICT_HEADER_SIZE 1
+#define TUPLE_HEADER_SIZE 7
+// As the SDK reports it on colour platforms
+#define INBOX_SIZE_MAXIMUM 8200
+
+// ---- Dictionaries ----
+
+uint32_t dict_calc_buffer_size(const uint8_t tuple_count, ...)
+{
+	uint32_t size = DICT_HEADER_SIZE + tuple_count * TUPLE_HEADER_SIZE;
+	va_list args;
+	va_start(args, tuple_count);
+	// The value sizes, given with sizeof() as in the SDK's examples
+	for (int i = 0; i < tuple_count; i++)
+		size += (uint32_t)va_arg(args, size_t);
+	va_end(args);
+	return size;
+}
+
+static Tuple *tuple_at(const DictionaryIterator *iter, const uint8_t *p)
+{
+	if (p + TUPLE_HEADER_SIZE > (const uint8_t *)iter->end)
+		return NULL;
+	Tuple *tuple = (Tuple *)p;
+	if (p + TUPLE_HEADER_SIZE + tuple->length > (const uint8_t *)iter->end)
+		return NULL;
+	return tuple;
+}
+
+Tuple *dict_read_first(DictionaryIterator *iter)
+{
+	const uint8_t *dict = (const uint8_t *)iter->dictionary;
+	iter->cursor = dict[0] ? tuple_at(iter, dict + DICT_HEADER_SIZE) : NULL;
+	return iter->cursor;
+}
+
+Tuple *dict_read_next(DictionaryIterator *iter)
+{
+	if (!iter->cursor)
+		return NULL;
+	const uint8_t *next = (const uint8_t *)iter->cursor +
+			      TUPLE_HEADER_SIZE + iter->cursor->length;
+	iter->cursor = tuple_at(iter, next);
+	return iter->cursor;
+}
+
+Tuple *dict_find(const DictionaryIterator *iter, const uint32_t key)
+{
+	DictionaryIterator it = *iter;
+	for (Tuple *t = dict_read_first(&it); t; t = dict_read_next(&it)) {
+		if (t->key == key)
+			return t;
+	}
+	return NULL;
+}
+
+// ---- Inbox ----
+
+static AppMessageInboxReceived s_received;
+static const char *s_received_name;
+static AppMessageInboxDropped s_dropped;
+static uint8_t *s_inbox, *s_outbox;
+static uint32_t s_inbox_size;
+
+AppMessageResult app_message_open(const uint32_t size_inbound,
+				  const uint32_t size_outbound)
+{
+	if (s_inbox || s_outbox)
+		return APP_MSG_INVALID_STATE;
+	if (size_inbound > INBOX_SIZE_MAXIMUM)
+		return APP_MSG_INVALID_ARGS;
+	s_inbox = size_inbound ? host_malloc(size_inbound) : NULL;
+	s_outbox = size_outbound ? host_malloc(size_outbound) : NULL;
+	if ((size_inbound && !s_inbox) || (size_outbound && !s_outbox)) {
+		host_app_message_close();
+		return APP_MSG_OUT_OF_MEMORY;
+	}
+	s_inbox_size = size_inbound;
+	return APP_MSG_OK;
+}
+
+uint32_t app_message_inbox_size_maximum(void)
+{
+	return INBOX_SIZE_MAXIMUM;
+}
+
+AppMessageInboxReceived
+host_app_message_register_inbox_received(AppMessageInboxReceived callback,
+					 const char *name)
+{
+	AppMessageInboxReceived previous = s_received;
+	s_received = callback;
+	s_received_name = name;
+	return previous;
+}
+
+AppMessageInboxDropped
+app_message_register_inbox_dropped(AppMessageInboxDropped callback)
+{
+	AppMessageInboxDropped previous = s_dropped;
+	s_dropped = callback;
+	return previous;
+}
+
+void app_message_deregister_callbacks(void)
+{
+	s_received = NULL;
+	s_dropped = NULL;
+}
+
+void host_app_message_close(void)
+{
+	host_free(s_inbox);
+	host_free(s_outbox);
+	s_inbox = s_outbox = NULL;
+	s_inbox_size = 0;
+}
+
+static const struct HostMessageKey *find_key(const char *name, size_t len)
+{
+	for (const struct HostMessageKey *k = host_message_keys; k->name; k++) {
+		if (strlen(k->name) == len && !strncmp(k->name, name, len))
+			return k;
+	}
+	return NULL;
+}
+
+const char *host_send_message(const char *spec)
+{
+	uint8_t dict[INBOX_SIZE_MAXIMUM];
+	size_t size = DICT_HEADER_SIZE;
+	dict[0] = 0;
+
+	for (const char *p = spec; *p;) {
+		size_t len = strcspn(p, ",");
+		const char *eq = memchr(p, '=', len);
+		if (!eq)
+			return "expected KEY=VALUE";
+		const struct HostMessageKey *key = find_key(p, eq - p);
+		if (!key)
+			return "not one of the face's messageKeys";
+
+		// An integer goes as an int32, anything else as a string
+		char value[256];
+		size_t value_len = len - (eq + 1 - p);
+		if (value_len >= sizeof(value))
+			return "value too long";
+		memcpy(value, eq + 1, value_len);
+		value[value_len] = '\0';
+		char *end;
+		long n = strtol(value, &end, 10);
+		bool is_int = value_len && !*end;
+		uint16_t length = is_int ? sizeof(int32_t) : value_len + 1;
+		if (size + TUPLE_HEADER_SIZE + length > sizeof(dict) ||
+		    dict[0] == UINT8_MAX)
+			return "message too long";
+
+		Tuple *tuple = (Tuple *)(dict + size);
+		tuple->key = key->id;
+		tuple->type = is_int ? TUPLE_INT : TUPLE_CSTRING;
+		tuple->length = length;
+		if (is_int)
+			tuple->value->int32 = (int32_t)n;
+		else
+			memcpy(tuple->value->cstring, value, length);
+		size += TUPLE_HEADER_SIZE + length;
+		dict[0]++;
+
+		p += len;
+		if (*p == ',')
+			p++;
+	}
+
+	// Without a handler the watch turns the message away unread
+	if (!s_received)
+		return NULL;
+	host_count(HOST_MESSAGES);
+	if (size > s_inbox_size) {
+		if (s_dropped)
+			s_dropped(APP_MSG_BUFFER_OVERFLOW, NULL);
+		return NULL;
+	}
+
+	memcpy(s_inbox, dict, size);
+	DictionaryIterator iter = {
+		.dictionary = (Dictionary *)s_inbox,
+		.end = s_inbox + size,
+	};
+	host_profile_begin(s_received_name);
+	s_received(&iter, NULL);
+	host_profile_end();
+	return NULL;
+}
@@ -0,0 +1,140 @@
+#include "host.h"
+
+#include <errno.h>
+
+// The app's persistent storage, kept in memory for the run. --persist
+// loads it from a file before init() and writes it back at exit, so a
+// later run boots with what an earlier one stored.
+
+// The watch gives each app 4 KB
+#define PERSIST_MAX_KEYS 64
+#define PERSIST_TOTAL_BYTES 4096
+
+typedef struct {
+	uint32_t key;
+	uint16_t size;
+	uint8_t data[PERSIST_DATA_MAX_LENGTH];
+} Entry;
+
+static Entry s_entries[PERSIST_MAX_KEYS];
+static int s_num_entries;
+
+static Entry *find(uint32_t key)
+{
+	for (int i = 0; i < s_num_entries; i++) {
+		if (s_entries[i].key == key)
+			return &s_entries[i];
+	}
+	return NULL;
+}
+
+static size_t total_bytes(void)
+{
+	size_t total = 0;
+	for (int i = 0; i < s_num_entries; i++)
+		total += s_entries[i].size;
+	return total;
+}
+
+// ---- API ----
+
+bool persist_exists(const uint32_t key)
+{
+	return find(key) != NULL;
+}
+
+int persist_get_size(const uint32_t key)
+{
+	Entry *e = find(key);
+	return e ? e->size : E_DOES_NOT_EXIST;
+}
+
+int persist_read_data(const uint32_t key, void *buffer,
+		      const size_t buffer_size)
+{
+	Entry *e = find(key);
+	if (!e)
+		return E_DOES_NOT_EXIST;
+	size_t n = e->size < buffer_size ? e->size : buffer_size;
+	memcpy(buffer, e->data, n);
+	return (int)n;
+}
+
+// Values longer than PERSIST_DATA_MAX_LENGTH are cut short, as on the
+// watch; the return value says how much was kept
+int persist_write_data(const uint32_t key, const void *data, const size_t size)
+{
+	size_t n = size < PERSIST_DATA_MAX_LENGTH ? size :
+						    PERSIST_DATA_MAX_LENGTH;
+	Entry *e = find(key);
+	size_t others = total_bytes() - (e ? e->size : 0);
+	if (others + n > PERSIST_TOTAL_BYTES ||
+	    (!e && s_num_entries == PERSIST_MAX_KEYS))
+		return E_OUT_OF_STORAGE;
+
+	if (!e) {
+		e = &s_entries[s_num_entries++];
+		e->key = key;
+	}
+	memcpy(e->data, data, n);
+	e->size = (uint16_t)n;
+	return (int)n;
+}
+
+status_t persist_delete(const uint32_t key)
+{
+	Entry *e = find(key);
+	if (!e)
+		return E_DOES_NOT_EXIST;
+	*e = s_entries[--s_num_entries];
+	return S_SUCCESS;
+}
+
+// ---- Storage file ----
+//
+// One line per key: the key in decimal, a space and the value in hex, or
+// "-" if it is empty.
+
+void host_persist_load(const char *path)
+{
+	FILE *f = fopen(path, "r");
+	if (!f) {
+		if (errno == ENOENT)
+			return;
+		fprintf(stderr, "%s: %s\n", path, strerror(errno));
+		exit(2);
+	}
+
+	unsigned long key;
+	char hex[2 * PERSIST_DATA_MAX_LENGTH + 2];
+	while (fscanf(f, "%lu %513s", &key, hex) == 2) {
+		uint8_t data[PERSIST_DATA_MAX_LENGTH];
+		size_t n = strlen(hex) / 2;
+		for (size_t i = 0; i < n && i < sizeof(data); i++) {
+			unsigned byte;
+			sscanf(hex + 2 * i, "%2x", &byte);
+			data[i] = (uint8_t)byte;
+		}
+		persist_write_data((uint32_t)key, data, n);
+	}
+	fclose(f);
+}
+
+void host_persist_save(const char *path)
+{
+	FILE *f = fopen(path, "w");
+	if (!f) {
+		fprintf(stderr, "%s: %s\n", path, strerror(errno));
+		exit(2);
+	}
+	for (int i = 0; i < s_num_entries; i++) {
+		fprintf(f, "%lu ", (unsigned long)s_entries[i].key);
+		for (int j = 0; j < s_entries[i].size; j++)
+			fprintf(f, "%02x", s_entries[i].data[j]);
+		// An empty value
+		if (!s_entries[i].size)
+			fputc('-', f);
+		fputc('\n', f);
+	}
+	fclose(f);
+}
@@ -0,0 +1,509 @@
+#include "host.h"
+
+#include <zlib.h>
+
+// PNG and APNG decoding to RGBA, and RGB PNG output, on top of zlib.
+// Interlaced images and 16-bit channels beyond their high byte are not
+// supported; none of the faces' resources use them.
+
+static const uint8_t PNG_SIGNATURE[8] = {0x89, 'P', 'N', 'G',
+					 '\r', '\n', 0x1a, '\n'};
+
+static uint32_t be32(const uint8_t *p)
+{
+	return (uint32_t)p[0] << 24 | p[1] << 16 | p[2] << 8 | p[3];
+}
+
+static uint16_t be16(const uint8_t *p)
+{
+	return p[0] << 8 | p[1];
+}
+
+typedef struct {
+	uint32_t width, height;
+	uint8_t bit_depth, color_type;
+	uint8_t palette[256][4];
+	bool has_trns;
+	uint16_t trns_gray, trns_rgb[3];
+} PngHeader;
+
+static int channels(uint8_t color_type)
+{
+	switch (color_type) {
+	case 0:
+	case 3:
+		return 1;
+	case 2:
+		return 3;
+	case 4:
+		return 2;
+	default:
+		return 4;
+	}
+}
+
+// Paeth predictor, PNG spec 9.4
+static uint8_t paeth(int a, int b, int c)
+{
+	int p = a + b - c;
+	int pa = abs(p - a), pb = abs(p - b), pc = abs(p - c);
+	if (pa <= pb && pa <= pc)
+		return a;
+	return pb <= pc ? b : c;
+}
+
+static uint32_t sample(const uint8_t *row, int bit_depth, uint32_t index)
+{
+	if (bit_depth == 8)
+		return row[index];
+	if (bit_depth == 16)
+		return row[index * 2];
+	int per_byte = 8 / bit_depth;
+	int shift = 8 - bit_depth * (index % per_byte + 1);
+	return (row[index / per_byte] >> shift) & ((1 << bit_depth) - 1);
+}
+
+// Inflate and unfilter one image of w x h pixels into RGBA
+static bool decode_image(const PngHeader *hdr, const uint8_t *zdata,
+			 size_t zsize, uint32_t w, uint32_t h, uint8_t *rgba)
+{
+	int ch = channels(hdr->color_type);
+	size_t bits = (size_t)w * ch * hdr->bit_depth;
+	size_t stride = (bits + 7) / 8;
+	size_t bpp = (ch * hdr->bit_depth + 7) / 8;
+	uLongf raw_size = (stride + 1) * h;
+	uint8_t *raw = malloc(raw_size);
+	uint8_t *prev = calloc(stride, 1);
+	bool ok = raw && prev &&
+		  uncompress(raw, &raw_size, zdata, zsize) == Z_OK &&
+		  raw_size == (stride + 1) * h;
+
+	for (uint32_t y = 0; ok && y < h; y++) {
+		uint8_t filter = raw[y * (stride + 1)];
+		uint8_t *row = &raw[y * (stride + 1) + 1];
+
+		for (size_t i = 0; i < stride; i++) {
+			int a = i >= bpp ? row[i - bpp] : 0;
+			int b = prev[i];
+			int c = i >= bpp ? prev[i - bpp] : 0;
+			switch (filter) {
+			case 1:
+				row[i] += a;
+				break;
+			case 2:
+				row[i] += b;
+				break;
+			case 3:
+				row[i] += (a + b) / 2;
+				break;
+			case 4:
+				row[i] += paeth(a, b, c);
+				break;
+			}
+		}
+
+		int max = (1 << (hdr->bit_depth > 8 ? 8 : hdr->bit_depth)) - 1;
+		for (uint32_t x = 0; x < w; x++) {
+			uint8_t *out = &rgba[(y * w + x) * 4];
+			uint32_t v0 = sample(row, hdr->bit_depth, x * ch);
+			switch (hdr->color_type) {
+			case 0:
+				out[0] = out[1] = out[2] = v0 * 255 / max;
+				out[3] = hdr->has_trns &&
+						 v0 == hdr->trns_gray ? 0 : 255;
+				break;
+			case 2:
+				for (int k = 0; k < 3; k++)
+					out[k] = sample(row, hdr->bit_depth,
+							x * 3 + k);
+				out[3] = hdr->has_trns &&
+						 out[0] == hdr->trns_rgb[0] &&
+						 out[1] == hdr->trns_rgb[1] &&
+						 out[2] == hdr->trns_rgb[2] ?
+					 0 :
+					 255;
+				break;
+			case 3:
+				memcpy(out, hdr->palette[v0], 4);
+				break;
+			case 4:
+				out[0] = out[1] = out[2] = v0;
+				out[3] = sample(row, hdr->bit_depth, x * 2 + 1);
+				break;
+			default:
+				for (int k = 0; k < 4; k++)
+					out[k] = sample(row, hdr->bit_depth,
+							x * 4 + k);
+				break;
+			}
+		}
+		memcpy(prev, row, stride);
+	}
+
+	free(raw);
+	free(prev);
+	return ok;
+}
+
+// ---- APNG ----
+
+typedef struct {
+	uint32_t width, height, x, y;
+	uint32_t delay_ms;
+	uint8_t dispose_op, blend_op;
+	uint8_t *zdata;
+	size_t zsize;
+} Frame;
+
+struct HostAnimation {
+	PngHeader hdr;
+	Frame *frames;
+	uint32_t num_frames;
+	uint32_t num_plays;
+	// IDAT, which is also frame 0 when an fcTL precedes it
+	uint8_t *default_zdata;
+	size_t default_zsize;
+
+	uint32_t next;
+	uint8_t *canvas;
+	uint8_t *saved;
+	uint8_t *pixels;
+};
+
+static bool append(uint8_t **buf, size_t *size, const uint8_t *data,
+		   size_t n)
+{
+	uint8_t *grown = realloc(*buf, *size + n);
+	if (!grown)
+		return false;
+	memcpy(grown + *size, data, n);
+	*buf = grown;
+	*size += n;
+	return true;
+}
+
+static bool parse(HostAnimation *anim, const uint8_t *data, size_t size)
+{
+	PngHeader *hdr = &anim->hdr;
+	Frame *frame = NULL;
+	size_t pos = sizeof(PNG_SIGNATURE);
+	bool seen_fdat = false;
+
+	if (size < pos || memcmp(data, PNG_SIGNATURE, pos))
+		return false;
+
+	for (int i = 0; i < 256; i++)
+		hdr->palette[i][3] = 255;
+
+	while (pos + 12 <= size) {
+		uint32_t len = be32(&data[pos]);
+		const uint8_t *type = &data[pos + 4];
+		const uint8_t *body = &data[pos + 8];
+		if (pos + 12 + len > size)
+			return false;
+		pos += 12 + len;
+
+		if (!memcmp(type, "IHDR", 4)) {
+			hdr->width = be32(body);
+			hdr->height = be32(body + 4);
+			hdr->bit_depth = body[8];
+			hdr->color_type = body[9];
+			if (body[12])
+				return false; // interlaced
+		} else if (!memcmp(type, "PLTE", 4)) {
+			for (uint32_t i = 0; i < len / 3 && i < 256; i++)
+				memcpy(hdr->palette[i], body + i * 3, 3);
+		} else if (!memcmp(type, "tRNS", 4)) {
+			hdr->has_trns = true;
+			if (hdr->color_type == 3) {
+				for (uint32_t i = 0; i < len && i < 256; i++)
+					hdr->palette[i][3] = body[i];
+			} else if (hdr->color_type == 0) {
+				hdr->trns_gray = be16(body);
+			} else {
+				for (int k = 0; k < 3; k++)
+					hdr->trns_rgb[k] = be16(body + k * 2);
+			}
+		} else if (!memcmp(type, "acTL", 4)) {
+			anim->num_plays = be32(body + 4);
+		} else if (!memcmp(type, "fcTL", 4)) {
+			Frame *grown = realloc(anim->frames,
+					       (anim->num_frames + 1) *
+						       sizeof(Frame));
+			if (!grown)
+				return false;
+			anim->frames = grown;
+			frame = &anim->frames[anim->num_frames++];
+			memset(frame, 0, sizeof(*frame));
+			frame->width = be32(body + 4);
+			frame->height = be32(body + 8);
+			frame->x = be32(body + 12);
+			frame->y = be32(body + 16);
+			uint16_t num = be16(body + 20), den = be16(body + 22);
+			frame->delay_ms = num * 1000 / (den ? den : 100);
+			frame->dispose_op = body[24];
+			frame->blend_op = body[25];
+		} else if (!memcmp(type, "IDAT", 4)) {
+			if (!append(&anim->default_zdata, &anim->default_zsize,
+				    body, len))
+				return false;
+			if (frame && !seen_fdat &&
+			    !append(&frame->zdata, &frame->zsize, body, len))
+				return false;
+		} else if (!memcmp(type, "fdAT", 4)) {
+			seen_fdat = true;
+			if (!frame || len < 4 ||
+			    !append(&frame->zdata, &frame->zsize, body + 4,
+				    len - 4))
+				return false;
+		} else if (!memcmp(type, "IEND", 4)) {
+			break;
+		}
+	}
+	return hdr->width && hdr->height && anim->default_zdata;
+}
+
+void host_apng_close(HostAnimation *anim)
+{
+	if (!anim)
+		return;
+	for (uint32_t i = 0; i < anim->num_frames; i++)
+		free(anim->frames[i].zdata);
+	free(anim->frames);
+	free(anim->default_zdata);
+	free(anim->canvas);
+	free(anim->saved);
+	free(anim->pixels);
+	free(anim);
+}
+
+HostAnimation *host_apng_open(const uint8_t *data, size_t size)
+{
+	HostAnimation *anim = calloc(1, sizeof(HostAnimation));
+	if (!anim || !parse(anim, data, size)) {
+		host_apng_close(anim);
+		return NULL;
+	}
+
+	// A plain PNG plays as a single frame
+	if (!anim->num_frames) {
+		anim->frames = calloc(1, sizeof(Frame));
+		if (!anim->frames) {
+			host_apng_close(anim);
+			return NULL;
+		}
+		anim->num_frames = 1;
+		anim->num_plays = 1;
+		anim->frames[0] = (Frame){
+			.width = anim->hdr.width,
+			.height = anim->hdr.height,
+		};
+	}
+
+	size_t bytes = (size_t)anim->hdr.width * anim->hdr.height * 4;
+	anim->canvas = calloc(bytes, 1);
+	anim->saved = calloc(bytes, 1);
+	anim->pixels = calloc(bytes, 1);
+	if (!anim->canvas || !anim->saved || !anim->pixels) {
+		host_apng_close(anim);
+		return NULL;
+	}
+	return anim;
+}
+
+GSize host_apng_size(const HostAnimation *anim)
+{
+	return GSize(anim->hdr.width, anim->hdr.height);
+}
+
+uint32_t host_apng_num_frames(const HostAnimation *anim)
+{
+	return anim->num_frames;
+}
+
+uint32_t host_apng_num_plays(const HostAnimation *anim)
+{
+	return anim->num_plays;
+}
+
+const uint8_t *host_apng_canvas(const HostAnimation *anim)
+{
+	return anim->canvas;
+}
+
+void host_apng_rewind(HostAnimation *anim)
+{
+	anim->next = 0;
+	memset(anim->canvas, 0, (size_t)anim->hdr.width * anim->hdr.height * 4);
+}
+
+static void dispose(HostAnimation *anim, const Frame *f)
+{
+	const uint32_t w = anim->hdr.width;
+
+	for (uint32_t y = f->y; y < f->y + f->height; y++) {
+		uint8_t *row = &anim->canvas[(y * w + f->x) * 4];
+		if (f->dispose_op == 1)
+			memset(row, 0, f->width * 4);
+		else if (f->dispose_op == 2)
+			memcpy(row, &anim->saved[(y * w + f->x) * 4],
+			       f->width * 4);
+	}
+}
+
+static GRect frame_rect(const Frame *f)
+{
+	return GRect(f->x, f->y, f->width, f->height);
+}
+
+static GRect rect_union(GRect a, GRect b)
+{
+	int x0 = a.origin.x < b.origin.x ? a.origin.x : b.origin.x;
+	int y0 = a.origin.y < b.origin.y ? a.origin.y : b.origin.y;
+	int x1 = a.origin.x + a.size.w > b.origin.x + b.size.w ?
+			 a.origin.x + a.size.w : b.origin.x + b.size.w;
+	int y1 = a.origin.y + a.size.h > b.origin.y + b.size.h ?
+			 a.origin.y + a.size.h : b.origin.y + b.size.h;
+	return GRect(x0, y0, x1 - x0, y1 - y0);
+}
+
+bool host_apng_next_frame(HostAnimation *anim, uint32_t *delay_ms,
+			  GRect *changed, size_t *zsize_read)
+{
+	if (anim->next >= anim->num_frames)
+		return false;
+
+	const uint32_t w = anim->hdr.width;
+	Frame *f = &anim->frames[anim->next];
+	GRect rect = frame_rect(f);
+	if (anim->next > 0) {
+		const Frame *prev = &anim->frames[anim->next - 1];
+		dispose(anim, prev);
+		if (prev->dispose_op)
+			rect = rect_union(rect, frame_rect(prev));
+	}
+
+	const uint8_t *zdata = f->zdata ? f->zdata : anim->default_zdata;
+	size_t zsize = f->zdata ? f->zsize : anim->default_zsize;
+	if (f->x + f->width > w || f->y + f->height > anim->hdr.height ||
+	    !decode_image(&anim->hdr, zdata, zsize, f->width, f->height,
+			  anim->pixels))
+		return false;
+
+	if (f->dispose_op == 2)
+		memcpy(anim->saved, anim->canvas, (size_t)w * anim->hdr.height * 4);
+
+	for (uint32_t y = 0; y < f->height; y++) {
+		for (uint32_t x = 0; x < f->width; x++) {
+			const uint8_t *src = &anim->pixels[(y * f->width + x) * 4];
+			uint8_t *dst =
+				&anim->canvas[((f->y + y) * w + f->x + x) * 4];
+			if (f->blend_op == 0 || src[3] == 255) {
+				memcpy(dst, src, 4);
+			} else if (src[3]) {
+				int a = src[3], ia = 255 - a;
+				int out_a = a + dst[3] * ia / 255;
+				for (int k = 0; k < 3; k++)
+					dst[k] = (src[k] * a +
+						  dst[k] * dst[3] * ia / 255) /
+						 out_a;
+				dst[3] = out_a;
+			}
+		}
+	}
+
+	anim->next++;
+	if (delay_ms)
+		*delay_ms = f->delay_ms;
+	if (changed)
+		*changed = rect;
+	if (zsize_read)
+		*zsize_read = zsize;
+	return true;
+}
+
+bool host_png_decode(const uint8_t *data, size_t size, HostImage *image)
+{
+	HostAnimation *anim = calloc(1, sizeof(HostAnimation));
+	bool ok = false;
+
+	memset(image, 0, sizeof(*image));
+	if (anim && parse(anim, data, size)) {
+		image->width = anim->hdr.width;
+		image->height = anim->hdr.height;
+		image->rgba = malloc((size_t)image->width * image->height * 4);
+		ok = image->rgba &&
+		     decode_image(&anim->hdr, anim->default_zdata,
+				  anim->default_zsize, image->width,
+				  image->height, image->rgba);
+	}
+	host_apng_close(anim);
+	if (!ok)
+		host_image_free(image);
+	return ok;
+}
+
+void host_image_free(HostImage *image)
+{
+	free(image->rgba);
+	image->rgba = NULL;
+}
+
+// ---- Output ----
+
+static void put32(uint8_t *p, uint32_t v)
+{
+	p[0] = v >> 24;
+	p[1] = v >> 16;
+	p[2] = v >> 8;
+	p[3] = v;
+}
+
+static bool write_chunk(FILE *f, const char *type, const uint8_t *body,
+			uint32_t len)
+{
+	uint8_t head[8], tail[4];
+	put32(head, len);
+	memcpy(head + 4, type, 4);
+	uLong crc = crc32(crc32(0, head + 4, 4), body, len);
+	put32(tail, crc);
+	return fwrite(head, 1, 8, f) == 8 &&
+	       fwrite(body, 1, len, f) == len && fwrite(tail, 1, 4, f) == 4;
+}
+
+bool host_png_write(const char *path, int width, int height,
+		    const uint8_t *rgb)
+{
+	size_t stride = (size_t)width * 3 + 1;
+	uLongf zsize = compressBound(stride * height);
+	uint8_t *raw = malloc(stride * height);
+	uint8_t *z = malloc(zsize);
+	FILE *f = fopen(path, "wb");
+	bool ok = raw && z && f;
+
+	if (ok) {
+		for (int y = 0; y < height; y++) {
+			raw[y * stride] = 0;
+			memcpy(&raw[y * stride + 1], &rgb[y * width * 3],
+			       width * 3);
+		}
+		ok = compress2(z, &zsize, raw, stride * height, 9) == Z_OK;
+	}
+	if (ok) {
+		uint8_t ihdr[13] = {0};
+		put32(ihdr, width);
+		put32(ihdr + 4, height);
+		ihdr[8] = 8;
+		ihdr[9] = 2;
+		ok = fwrite(PNG_SIGNATURE, 1, 8, f) == 8 &&
+		     write_chunk(f, "IHDR", ihdr, sizeof(ihdr)) &&
+		     write_chunk(f, "IDAT", z, zsize) &&
+		     write_chunk(f, "IEND", (const uint8_t *)"", 0);
+	}
+
+	if (f && fclose(f))
+		ok = false;
+	free(raw);
+	free(z);
+	return ok;
+}
@@ -0,0 +1,577 @@
+#include "host.h"
+
+#include <getopt.h>
+
+// Command-line driver: boots the face at a simulated time, plays a scenario
+// of clock jumps, runs and sensor events given as options, writes frames as
+// PNG and reports where the time and draw calls went.
+
+#ifndef HOST_APP_NAME
+#define HOST_APP_NAME "app"
+#endif
+
+// The face's own main(), renamed by the build
+int host_app_main(void);
+
+// ---- Platform ----
+
+const HostPlatform host_platform = {
+#if defined(PBL_PLATFORM_APLITE)
+	"aplite", {144, 168}, false, 24 * 1024,
+#elif defined(PBL_PLATFORM_BASALT)
+	"basalt", {144, 168}, false, 64 * 1024,
+#elif defined(PBL_PLATFORM_CHALK)
+	"chalk", {180, 180}, true, 64 * 1024,
+#elif defined(PBL_PLATFORM_DIORITE)
+	"diorite", {144, 168}, false, 64 * 1024,
+#elif defined(PBL_PLATFORM_EMERY)
+	"emery", {200, 228}, false, 128 * 1024,
+#elif defined(PBL_PLATFORM_FLINT)
+	"flint", {144, 168}, false, 64 * 1024,
+#endif
+};
+
+// ---- Heap ----
+
+// Bookkeeping the watch's allocator spends on every block
+#define HEAP_BLOCK_OVERHEAD 8
+
+typedef union {
+	size_t size;
+	max_align_t align;
+} BlockHeader;
+
+static size_t s_heap_used, s_heap_peak;
+static uint32_t s_heap_allocs, s_heap_frees, s_heap_failures;
+
+void *host_malloc(size_t size)
+{
+	size_t charge = size + HEAP_BLOCK_OVERHEAD;
+	if (s_heap_used + charge > host_platform.heap_size) {
+		s_heap_failures++;
+		return NULL;
+	}
+
+	BlockHeader *block = malloc(sizeof(BlockHeader) + size);
+	if (!block)
+		return NULL;
+	block->size = size;
+	s_heap_used += charge;
+	if (s_heap_used > s_heap_peak)
+		s_heap_peak = s_heap_used;
+	s_heap_allocs++;
+	return block + 1;
+}
+
+void *host_calloc(size_t count, size_t size)
+{
+	void *ptr = host_malloc(count * size);
+	if (ptr)
+		memset(ptr, 0, count * size);
+	return ptr;
+}
+
+void host_free(void *ptr)
+{
+	if (!ptr)
+		return;
+	BlockHeader *block = (BlockHeader *)ptr - 1;
+	s_heap_used -= block->size + HEAP_BLOCK_OVERHEAD;
+	s_heap_frees++;
+	free(block);
+}
+
+size_t heap_bytes_used(void)
+{
+	return s_heap_used;
+}
+
+size_t heap_bytes_free(void)
+{
+	return host_platform.heap_size - s_heap_used;
+}
+
+// ---- Profiling ----
+
+static const char *const DRAW_CALL_NAMES[HOST_NUM_DRAW_CALLS] = {
+	[HOST_DRAW_PIXEL] = "draw_pixel",
+	[HOST_DRAW_LINE] = "draw_line",
+	[HOST_DRAW_RECT] = "draw_rect",
+	[HOST_FILL_RECT] = "fill_rect",
+	[HOST_DRAW_CIRCLE] = "draw_circle",
+	[HOST_FILL_CIRCLE] = "fill_circle",
+	[HOST_DRAW_PATH] = "gpath_draw_outline",
+	[HOST_FILL_PATH] = "gpath_draw_filled",
+	[HOST_DRAW_TEXT] = "draw_text",
+	[HOST_DRAW_BITMAP] = "draw_bitmap",
+	[HOST_CAPTURE_FB] = "capture_frame_buffer",
+};
+
+static const char *const COUNTER_NAMES[HOST_NUM_COUNTERS] = {
+	[HOST_FRAMES] = "frames",
+	[HOST_TICKS] = "ticks",
+	[HOST_TIMERS_REGISTERED] = "timers_registered",
+	[HOST_TIMERS_FIRED] = "timers_fired",
+	[HOST_ACCEL_BATCHES] = "accel_batches",
+	[HOST_TAPS] = "taps",
+	[HOST_BATTERY_EVENTS] = "battery_events",
+	[HOST_FOCUS_EVENTS] = "focus_events",
+	[HOST_MESSAGES] = "messages",
+	[HOST_BITMAPS_CREATED] = "bitmaps_created",
+	[HOST_RESOURCE_LOADS] = "resource_loads",
+	[HOST_RESOURCE_BYTES] = "resource_bytes",
+};
+
+typedef struct {
+	const char *name;
+	uint64_t calls;
+	double total_us;
+	double max_us;
+	uint64_t draws[HOST_NUM_DRAW_CALLS];
+} ProcStats;
+
+typedef struct {
+	const char *name;
+	uint64_t arms;
+	int64_t pending_ms;
+} TimerStats;
+
+#define MAX_PROCS 64
+#define MAX_TIMERS 32
+#define MAX_DEPTH 8
+
+static ProcStats s_procs[MAX_PROCS];
+static int s_num_procs;
+static TimerStats s_timer_stats[MAX_TIMERS];
+static int s_num_timer_stats;
+static uint64_t s_counters[HOST_NUM_COUNTERS];
+
+// Open callbacks; a NULL entry mutes draw counting for the host's own
+// drawing, such as the glyphs of a draw_text
+static struct {
+	ProcStats *stats;
+	struct timespec start;
+} s_stack[MAX_DEPTH];
+static int s_depth;
+
+static ProcStats *proc_stats(const char *name)
+{
+	for (int i = 0; i < s_num_procs; i++) {
+		if (!strcmp(s_procs[i].name, name))
+			return &s_procs[i];
+	}
+	if (s_num_procs == MAX_PROCS)
+		return NULL;
+	s_procs[s_num_procs].name = name;
+	return &s_procs[s_num_procs++];
+}
+
+void host_profile_begin(const char *name)
+{
+	if (s_depth == MAX_DEPTH)
+		return;
+	s_stack[s_depth].stats = name ? proc_stats(name) : NULL;
+	clock_gettime(CLOCK_MONOTONIC, &s_stack[s_depth].start);
+	s_depth++;
+}
+
+void host_profile_end(void)
+{
+	struct timespec end;
+	clock_gettime(CLOCK_MONOTONIC, &end);
+
+	ProcStats *stats = s_stack[--s_depth].stats;
+	if (!stats)
+		return;
+	double us = (end.tv_sec - s_stack[s_depth].start.tv_sec) * 1e6 +
+		    (end.tv_nsec - s_stack[s_depth].start.tv_nsec) / 1e3;
+	stats->calls++;
+	stats->total_us += us;
+	if (us > stats->max_us)
+		stats->max_us = us;
+}
+
+void host_count_draw(enum HostDrawCall call)
+{
+	if (s_depth && s_stack[s_depth - 1].stats)
+		s_stack[s_depth - 1].stats->draws[call]++;
+}
+
+void host_count(enum HostCounter counter)
+{
+	s_counters[counter]++;
+}
+
+void host_count_n(enum HostCounter counter, uint64_t n)
+{
+	s_counters[counter] += n;
+}
+
+static TimerStats *timer_stats(const char *name)
+{
+	for (int i = 0; i < s_num_timer_stats; i++) {
+		if (!strcmp(s_timer_stats[i].name, name))
+			return &s_timer_stats[i];
+	}
+	if (s_num_timer_stats == MAX_TIMERS)
+		return NULL;
+	s_timer_stats[s_num_timer_stats].name = name;
+	return &s_timer_stats[s_num_timer_stats++];
+}
+
+void host_count_timer_armed(const char *name)
+{
+	TimerStats *stats = timer_stats(name);
+	if (stats)
+		stats->arms++;
+}
+
+void host_count_timer_pending(const char *name, int64_t ms)
+{
+	TimerStats *stats = timer_stats(name);
+	if (stats)
+		stats->pending_ms += ms;
+}
+
+static void reset_stats(void)
+{
+	memset(s_procs, 0, sizeof(s_procs));
+	s_num_procs = 0;
+	memset(s_timer_stats, 0, sizeof(s_timer_stats));
+	s_num_timer_stats = 0;
+	memset(s_counters, 0, sizeof(s_counters));
+	s_heap_peak = s_heap_used;
+}
+
+// ---- Rendering ----
+
+static GContext s_ctx;
+
+void host_render(void)
+{
+	host_window_render(&s_ctx);
+}
+
+// ---- Scenario ----
+
+static int s_argc;
+static char **s_argv;
+// The scenario's first option was --at, or --trace with a start line,
+// already used as the boot time
+static bool s_boot_at;
+// Simulated time let pass by --run
+static int64_t s_run_ms;
+static const char *s_persist_path;
+
+static const struct option OPTIONS[] = {
+	{"at", required_argument, NULL, 'a'},
+	{"run", required_argument, NULL, 'r'},
+	{"png", required_argument, NULL, 'p'},
+	{"bench", required_argument, NULL, 'b'},
+	{"battery", required_argument, NULL, 'B'},
+	{"tap", no_argument, NULL, 't'},
+	{"flick", no_argument, NULL, 'f'},
+	{"focus", required_argument, NULL, 'F'},
+	{"quiet-time", required_argument, NULL, 'Q'},
+	{"sleep", required_argument, NULL, 'S'},
+	{"message", required_argument, NULL, 'm'},
+	{"persist", required_argument, NULL, 'P'},
+	{"trace", required_argument, NULL, 'T'},
+	{"reset-stats", no_argument, NULL, 'R'},
+	{"quiet", no_argument, NULL, 'q'},
+	{"help", no_argument, NULL, 'h'},
+	{NULL, 0, NULL, 0},
+};
+
+static void usage(FILE *f)
+{
+	fprintf(f,
+		"usage: %s [options]\n"
+		"\n"
+		"Runs " HOST_APP_NAME " as built for %s. Options other than "
+		"--persist and --quiet\nare performed in order after the "
+		"face's init().\n"
+		"\n"
+		"  --at TIME        set the clock to TIME (UTC, "
+		"\"YYYY-MM-DD HH:MM[:SS]\"),\n"
+		"                   delivering one tick; the first --at "
+		"before any\n"
+		"                   other option is the boot time instead\n"
+		"  --run DURATION   let DURATION pass (e.g. 90, 90s, 10m, 2h, "
+		"1d),\n"
+		"                   delivering every tick, timer and "
+		"accelerometer batch\n"
+		"  --png FILE       write the current frame to FILE\n"
+		"  --bench N        redraw the whole window N times\n"
+		"  --battery PCT[c] set the battery state (c: charging)\n"
+		"  --tap            deliver an accelerometer tap\n"
+		"  --flick          tap, then lower the arm for one accelerometer batch\n"
+		"  --focus 0|1      cover the face with a notification, or "
+		"uncover it\n"
+		"  --quiet-time 0|1 end or start Quiet Time\n"
+		"  --sleep 0|1      wake the wearer, or put them to sleep\n"
+		"  --message KEY=VALUE[,KEY=VALUE...]\n"
+		"                   send an app message from the phone\n"
+		"  --trace FILE     replay a sensor trace; one with a start "
+		"line first\n"
+		"                   sets the boot time\n"
+		"  --reset-stats    forget what the report has counted so far\n"
+		"  --persist FILE   keep persistent storage in FILE between "
+		"runs\n"
+		"  --quiet          suppress APP_LOG output\n",
+		s_argv[0], host_platform.name);
+}
+
+static void die(const char *fmt, const char *arg)
+{
+	fprintf(stderr, "%s: ", s_argv[0]);
+	fprintf(stderr, fmt, arg);
+	fputc('\n', stderr);
+	exit(2);
+}
+
+static int64_t parse_time(const char *s)
+{
+	struct tm tm = {0};
+	const char *end = strptime(s, "%Y-%m-%d %H:%M", &tm);
+	if (!end)
+		end = strptime(s, "%Y-%m-%dT%H:%M", &tm);
+	if (end && *end == ':')
+		end = strptime(end, ":%S", &tm);
+	if (!end || *end)
+		die("bad time \"%s\"", s);
+	return (int64_t)timegm(&tm) * 1000;
+}
+
+static int64_t parse_duration(const char *s)
+{
+	char *end;
+	double n = strtod(s, &end);
+	int64_t unit = 1000;
+
+	if (!strcmp(end, "m"))
+		unit = 60 * 1000;
+	else if (!strcmp(end, "h"))
+		unit = 3600 * 1000;
+	else if (!strcmp(end, "d"))
+		unit = 86400 * 1000;
+	else if (*end && strcmp(end, "s"))
+		die("bad duration \"%s\"", s);
+	if (end == s || n < 0)
+		die("bad duration \"%s\"", s);
+	return (int64_t)(n * unit);
+}
+
+static BatteryChargeState parse_battery(const char *s)
+{
+	char *end;
+	long pct = strtol(s, &end, 10);
+	if (end == s || pct < 0 || pct > 100 || (*end && strcmp(end, "c")))
+		die("bad battery state \"%s\"", s);
+	return (BatteryChargeState){
+		.charge_percent = (uint8_t)pct,
+		.is_charging = *end == 'c',
+		.is_plugged = *end == 'c',
+	};
+}
+
+static bool parse_switch(const char *s)
+{
+	if (strcmp(s, "0") && strcmp(s, "1"))
+		die("expected 0 or 1, not \"%s\"", s);
+	return *s == '1';
+}
+
+static void render_if_dirty(void)
+{
+	if (host_window_needs_render())
+		host_render();
+}
+
+void app_event_loop(void)
+{
+	// The face has pushed its window; show the first frame
+	render_if_dirty();
+
+	int opt;
+	optind = 0;
+	while ((opt = getopt_long(s_argc, s_argv, "", OPTIONS, NULL)) != -1) {
+		switch (opt) {
+		case 'a':
+			if (s_boot_at)
+				s_boot_at = false;
+			else
+				host_jump_to(parse_time(optarg));
+			break;
+		case 'r': {
+			int64_t duration = parse_duration(optarg);
+			host_run_until(host_clock_ms + duration);
+			s_run_ms += duration;
+			break;
+		}
+		case 'p':
+			render_if_dirty();
+			if (!host_graphics_write_png(&s_ctx, optarg))
+				die("cannot write %s", optarg);
+			break;
+		case 'b':
+			for (long n = strtol(optarg, NULL, 10); n > 0; n--) {
+				host_window_mark_all_dirty();
+				host_render();
+			}
+			break;
+		case 'B':
+			host_set_battery(parse_battery(optarg));
+			render_if_dirty();
+			break;
+		case 't':
+			host_tap(ACCEL_AXIS_Y, 1);
+			render_if_dirty();
+			break;
+		case 'f':
+			host_flick();
+			render_if_dirty();
+			break;
+		case 'F':
+			host_set_focus(parse_switch(optarg));
+			render_if_dirty();
+			break;
+		case 'Q':
+			host_set_quiet_time(parse_switch(optarg));
+			break;
+		case 'S':
+			host_set_asleep(parse_switch(optarg));
+			break;
+		case 'm': {
+			const char *error = host_send_message(optarg);
+			if (error)
+				die("bad message: %s", error);
+			render_if_dirty();
+			break;
+		}
+		case 'T': {
+			int64_t from = host_clock_ms;
+			host_trace_replay(optarg, !s_boot_at);
+			s_boot_at = false;
+			s_run_ms += host_clock_ms - from;
+			break;
+		}
+		case 'R':
+			reset_stats();
+			s_run_ms = 0;
+			break;
+		}
+	}
+}
+
+// ---- Report ----
+
+static int compare_procs(const void *a, const void *b)
+{
+	const ProcStats *x = a, *y = b;
+	return (y->total_us > x->total_us) - (y->total_us < x->total_us);
+}
+
+static void report(void)
+{
+	printf("%s on %s: %.1f simulated seconds run\n", HOST_APP_NAME,
+	       host_platform.name, s_run_ms / 1000.0);
+
+	printf("%-28s %8s %10s %10s  %s\n", "callback", "calls", "avg_us",
+	       "max_us", "draw calls per call");
+	qsort(s_procs, s_num_procs, sizeof(s_procs[0]), compare_procs);
+	for (int i = 0; i < s_num_procs; i++) {
+		const ProcStats *p = &s_procs[i];
+		if (!p->calls)
+			continue;
+		printf("%-28s %8llu %10.2f %10.2f ", p->name,
+		       (unsigned long long)p->calls, p->total_us / p->calls,
+		       p->max_us);
+		for (int d = 0; d < HOST_NUM_DRAW_CALLS; d++) {
+			if (p->draws[d])
+				printf(" %s=%.4g", DRAW_CALL_NAMES[d],
+				       (double)p->draws[d] / p->calls);
+		}
+		putchar('\n');
+	}
+
+	if (s_num_timer_stats) {
+		printf("%-28s %8s %10s\n", "timer callback", "arms",
+		       "pending_ms");
+	}
+	for (int i = 0; i < s_num_timer_stats; i++) {
+		const TimerStats *t = &s_timer_stats[i];
+		printf("%-28s %8llu %10lld\n", t->name,
+		       (unsigned long long)t->arms, (long long)t->pending_ms);
+	}
+
+	// Every event that would run the app on the watch
+	uint64_t wakeups = s_counters[HOST_TICKS] +
+			   s_counters[HOST_TIMERS_FIRED] +
+			   s_counters[HOST_ACCEL_BATCHES] +
+			   s_counters[HOST_TAPS] +
+			   s_counters[HOST_BATTERY_EVENTS] +
+			   s_counters[HOST_FOCUS_EVENTS] +
+			   s_counters[HOST_MESSAGES];
+	printf("events: wakeups=%llu", (unsigned long long)wakeups);
+	for (int i = 0; i < HOST_NUM_COUNTERS; i++)
+		printf(" %s=%llu", COUNTER_NAMES[i],
+		       (unsigned long long)s_counters[i]);
+	printf("\nheap: size=%zu peak=%zu leaked=%zu allocs=%u frees=%u "
+	       "failed=%u\n",
+	       host_platform.heap_size, s_heap_peak, s_heap_used,
+	       s_heap_allocs, s_heap_frees, s_heap_failures);
+}
+
+// ---- Entry point ----
+
+int main(int argc, char **argv)
+{
+	int64_t start_ms = parse_time("2025-06-21 10:10");
+
+	s_argc = argc;
+	s_argv = argv;
+
+	// Global options and the boot time are taken before init() runs
+	bool first = true;
+	int opt;
+	while ((opt = getopt_long(argc, argv, "", OPTIONS, NULL)) != -1) {
+		if (opt == 'q') {
+			host_log_quiet = true;
+			continue;
+		} else if (opt == 'P') {
+			s_persist_path = optarg;
+			host_persist_load(optarg);
+			continue;
+		} else if (opt == 'h') {
+			usage(stdout);
+			return 0;
+		} else if (opt == '?') {
+			usage(stderr);
+			return 2;
+		} else if (opt == 'a' && first) {
+			start_ms = parse_time(optarg);
+			s_boot_at = true;
+		} else if (opt == 'T' && first) {
+			int64_t trace_start = host_trace_start(optarg);
+			if (trace_start >= 0) {
+				start_ms = trace_start;
+				s_boot_at = true;
+			}
+		}
+		first = false;
+	}
+	if (optind < argc)
+		die("unexpected argument \"%s\"", argv[optind]);
+
+	host_set_clock(start_ms);
+	host_graphics_init(&s_ctx);
+	int status = host_app_main();
+	host_window_unload_all();
+	host_app_message_close();
+	if (s_persist_path)
+		host_persist_save(s_persist_path);
+	report();
+	host_graphics_deinit(&s_ctx);
+	return status;
+}
@@ -0,0 +1,607 @@
+#include "host.h"
+
+#include <stdarg.h>
+
+// Event services driven by the simulated clock: ticks, app timers, battery
+// state, accelerometer batches and taps. Plus resources and logging, which
+// need somewhere to live.
+
+int64_t host_clock_ms;
+
+// ---- Time ----
+
+time_t host_time(time_t *tloc)
+{
+	time_t now = (time_t)(host_clock_ms / 1000);
+	if (tloc)
+		*tloc = now;
+	return now;
+}
+
+struct tm *host_localtime(const time_t *timep)
+{
+	static struct tm s_tm;
+	return gmtime_r(timep, &s_tm);
+}
+
+uint16_t time_ms(time_t *tloc, uint16_t *out_ms)
+{
+	uint16_t ms = (uint16_t)(host_clock_ms % 1000);
+	host_time(tloc);
+	if (out_ms)
+		*out_ms = ms;
+	return ms;
+}
+
+bool clock_is_24h_style(void)
+{
+	return true;
+}
+
+void host_set_clock(int64_t ms)
+{
+	host_clock_ms = ms;
+}
+
+// ---- Ticks ----
+
+static TickHandler s_tick_handler;
+static const char *s_tick_handler_name;
+static TimeUnits s_tick_units;
+static struct tm s_last_tick;
+// When the clock was last compared with s_last_tick. A timer due on the
+// same millisecond as a tick can run first; the tick is still delivered.
+static int64_t s_tick_checked_ms;
+
+static struct tm clock_tm(int64_t ms)
+{
+	struct tm tm;
+	time_t t = (time_t)(ms / 1000);
+	gmtime_r(&t, &tm);
+	return tm;
+}
+
+void host_tick_timer_service_subscribe(TimeUnits tick_units,
+				       TickHandler handler, const char *name)
+{
+	s_tick_handler = handler;
+	s_tick_handler_name = name;
+	s_tick_units = tick_units;
+	s_last_tick = clock_tm(host_clock_ms);
+	s_tick_checked_ms = host_clock_ms;
+}
+
+void tick_timer_service_unsubscribe(void)
+{
+	s_tick_handler = NULL;
+}
+
+static TimeUnits units_changed(const struct tm *a, const struct tm *b)
+{
+	TimeUnits units = 0;
+	if (a->tm_sec != b->tm_sec)
+		units |= SECOND_UNIT;
+	if (a->tm_min != b->tm_min)
+		units |= MINUTE_UNIT;
+	if (a->tm_hour != b->tm_hour)
+		units |= HOUR_UNIT;
+	if (a->tm_yday != b->tm_yday)
+		units |= DAY_UNIT;
+	if (a->tm_mon != b->tm_mon)
+		units |= MONTH_UNIT;
+	if (a->tm_year != b->tm_year)
+		units |= YEAR_UNIT;
+	return units;
+}
+
+static void deliver_tick(void)
+{
+	struct tm now = clock_tm(host_clock_ms);
+	TimeUnits changed = units_changed(&s_last_tick, &now);
+
+	// A unit's ticks also come when a larger one changes alone, as when the
+	// clock is set
+	TimeUnits smallest = s_tick_units & -s_tick_units;
+
+	s_tick_checked_ms = host_clock_ms;
+	if (!s_tick_handler || !(changed & ~(smallest - 1)))
+		return;
+	s_last_tick = now;
+	host_count(HOST_TICKS);
+	host_profile_begin(s_tick_handler_name);
+	s_tick_handler(&now, changed);
+	host_profile_end();
+}
+
+// Next time at which a subscribed unit can change
+static int64_t next_tick_ms(void)
+{
+	static const int64_t PERIOD_MS[] = {1000, 60000, 3600000, 86400000};
+	int64_t period = PERIOD_MS[3];
+
+	for (int i = 0; i < 4; i++) {
+		if (s_tick_units & (1 << i)) {
+			period = PERIOD_MS[i];
+			break;
+		}
+	}
+	return (s_tick_checked_ms / period + 1) * period;
+}
+
+// ---- Timers ----
+
+struct AppTimer {
+	int64_t due_ms;
+	// When the timer was registered, for the time it spends pending
+	int64_t armed_ms;
+	AppTimerCallback callback;
+	void *data;
+	const char *name;
+	AppTimer *next;
+};
+
+static AppTimer *s_timers;
+
+static void timer_insert(AppTimer *timer)
+{
+	AppTimer **link = &s_timers;
+	while (*link && (*link)->due_ms <= timer->due_ms)
+		link = &(*link)->next;
+	timer->next = *link;
+	*link = timer;
+}
+
+// Unlink timer if it is still pending
+static bool timer_remove(AppTimer *timer)
+{
+	for (AppTimer **link = &s_timers; *link; link = &(*link)->next) {
+		if (*link == timer) {
+			*link = timer->next;
+			return true;
+		}
+	}
+	return false;
+}
+
+AppTimer *host_app_timer_register(uint32_t timeout_ms,
+				  AppTimerCallback callback,
+				  void *callback_data, const char *name)
+{
+	AppTimer *timer = host_malloc(sizeof(AppTimer));
+	if (!timer)
+		return NULL;
+	timer->due_ms = host_clock_ms + timeout_ms;
+	timer->armed_ms = host_clock_ms;
+	timer->callback = callback;
+	timer->data = callback_data;
+	timer->name = name;
+	timer_insert(timer);
+	host_count(HOST_TIMERS_REGISTERED);
+	host_count_timer_armed(name);
+	return timer;
+}
+
+bool app_timer_reschedule(AppTimer *timer_handle, uint32_t new_timeout_ms)
+{
+	if (!timer_handle || !timer_remove(timer_handle))
+		return false;
+	timer_handle->due_ms = host_clock_ms + new_timeout_ms;
+	timer_insert(timer_handle);
+	host_count_timer_armed(timer_handle->name);
+	return true;
+}
+
+void app_timer_cancel(AppTimer *timer_handle)
+{
+	if (timer_handle && timer_remove(timer_handle)) {
+		host_count_timer_pending(timer_handle->name,
+					 host_clock_ms - timer_handle->armed_ms);
+		host_free(timer_handle);
+	}
+}
+
+static void fire_timer(void)
+{
+	AppTimer *timer = s_timers;
+	AppTimerCallback callback = timer->callback;
+	void *data = timer->data;
+	const char *name = timer->name;
+
+	s_timers = timer->next;
+	host_count_timer_pending(name, host_clock_ms - timer->armed_ms);
+	host_free(timer);
+	host_count(HOST_TIMERS_FIRED);
+	host_profile_begin(name);
+	callback(data);
+	host_profile_end();
+}
+
+// ---- Battery ----
+
+static BatteryStateHandler s_battery_handler;
+static const char *s_battery_handler_name;
+static BatteryChargeState s_battery = {.charge_percent = 80};
+
+void host_battery_state_service_subscribe(BatteryStateHandler handler,
+					  const char *name)
+{
+	s_battery_handler = handler;
+	s_battery_handler_name = name;
+}
+
+void battery_state_service_unsubscribe(void)
+{
+	s_battery_handler = NULL;
+}
+
+BatteryChargeState battery_state_service_peek(void)
+{
+	return s_battery;
+}
+
+void host_set_battery(BatteryChargeState state)
+{
+	s_battery = state;
+	if (!s_battery_handler)
+		return;
+	host_count(HOST_BATTERY_EVENTS);
+	host_profile_begin(s_battery_handler_name);
+	s_battery_handler(state);
+	host_profile_end();
+}
+
+// ---- Accelerometer ----
+
+#define ACCEL_MAX_SAMPLES 25
+
+static AccelDataHandler s_accel_handler;
+static const char *s_accel_handler_name;
+static AccelTapHandler s_tap_handler;
+static const char *s_tap_handler_name;
+static uint32_t s_accel_samples = ACCEL_MAX_SAMPLES;
+static AccelSamplingRate s_accel_rate = ACCEL_SAMPLING_25HZ;
+static int64_t s_accel_next_ms;
+
+static int64_t accel_period_ms(void)
+{
+	return (int64_t)s_accel_samples * 1000 / s_accel_rate;
+}
+
+void host_accel_data_service_subscribe(uint32_t samples_per_update,
+				       AccelDataHandler handler,
+				       const char *name)
+{
+	s_accel_handler = handler;
+	s_accel_handler_name = name;
+	accel_service_set_samples_per_update(samples_per_update);
+}
+
+void accel_data_service_unsubscribe(void)
+{
+	s_accel_handler = NULL;
+}
+
+int accel_service_set_sampling_rate(AccelSamplingRate rate)
+{
+	s_accel_rate = rate;
+	s_accel_next_ms = host_clock_ms + accel_period_ms();
+	return 0;
+}
+
+int accel_service_set_samples_per_update(uint32_t num_samples)
+{
+	if (num_samples > ACCEL_MAX_SAMPLES)
+		num_samples = ACCEL_MAX_SAMPLES;
+	s_accel_samples = num_samples ? num_samples : 1;
+	s_accel_next_ms = host_clock_ms + accel_period_ms();
+	return 0;
+}
+
+// The watch lying still, face up
+static const AccelData RESTING = {.z = -1000};
+// The arm hanging down, screen facing sideways
+static const AccelData LOWERED = {.y = -1000};
+
+// Readings set by host_set_accel(), oldest first; each holds from its time
+// until the next. Enough for a batch of a trace sampled at up to 50 Hz.
+#define ACCEL_HISTORY 64
+
+static struct {
+	int64_t ms;
+	AccelData data;
+} s_accel_history[ACCEL_HISTORY];
+static int s_accel_history_len;
+
+void host_set_accel(const AccelData *data)
+{
+	if (s_accel_history_len == ACCEL_HISTORY) {
+		memmove(&s_accel_history[0], &s_accel_history[1],
+			sizeof(s_accel_history[0]) * (ACCEL_HISTORY - 1));
+		s_accel_history_len--;
+	}
+	s_accel_history[s_accel_history_len].ms = host_clock_ms;
+	s_accel_history[s_accel_history_len].data = *data;
+	s_accel_history_len++;
+}
+
+// The reading at ms: at rest until a trace sets one
+static AccelData accel_at(int64_t ms)
+{
+	for (int i = s_accel_history_len - 1; i >= 0; i--) {
+		if (s_accel_history[i].ms <= ms || i == 0)
+			return s_accel_history[i].data;
+	}
+	return RESTING;
+}
+
+int accel_service_peek(AccelData *data)
+{
+	*data = accel_at(host_clock_ms);
+	data->timestamp = (uint64_t)host_clock_ms;
+	return 0;
+}
+
+// A batch of the readings over the last period, or of pose throughout
+static void deliver_accel_batch(const AccelData *pose)
+{
+	AccelData batch[ACCEL_MAX_SAMPLES];
+	int64_t period = accel_period_ms();
+
+	for (uint32_t i = 0; i < s_accel_samples; i++) {
+		int64_t ms = host_clock_ms - period +
+			     period * (i + 1) / s_accel_samples;
+		batch[i] = pose ? *pose : accel_at(ms);
+		batch[i].timestamp = (uint64_t)ms;
+	}
+	s_accel_next_ms = host_clock_ms + period;
+	host_count(HOST_ACCEL_BATCHES);
+	host_profile_begin(s_accel_handler_name);
+	s_accel_handler(batch, s_accel_samples);
+	host_profile_end();
+}
+
+// Raising the arm sets off the accelerometer's tap detection. The data
+// service, subscribed before or by the tap handler, sees the arm lowered.
+void host_flick(void)
+{
+	host_tap(ACCEL_AXIS_Y, 1);
+	if (!s_accel_handler)
+		return;
+	deliver_accel_batch(&LOWERED);
+}
+
+void host_accel_tap_service_subscribe(AccelTapHandler handler,
+				      const char *name)
+{
+	s_tap_handler = handler;
+	s_tap_handler_name = name;
+}
+
+void accel_tap_service_unsubscribe(void)
+{
+	s_tap_handler = NULL;
+}
+
+void host_tap(AccelAxisType axis, int32_t direction)
+{
+	if (!s_tap_handler)
+		return;
+	host_count(HOST_TAPS);
+	host_profile_begin(s_tap_handler_name);
+	s_tap_handler(axis, direction);
+	host_profile_end();
+}
+
+// ---- Focus, Quiet Time and sleep ----
+
+static AppFocusHandlers s_focus_handlers;
+static bool s_in_focus = true;
+static bool s_quiet_time;
+static bool s_asleep;
+
+void app_focus_service_subscribe_handlers(AppFocusHandlers handlers)
+{
+	s_focus_handlers = handlers;
+}
+
+void app_focus_service_subscribe(AppFocusHandler handler)
+{
+	s_focus_handlers = (AppFocusHandlers){.did_focus = handler};
+}
+
+void app_focus_service_unsubscribe(void)
+{
+	s_focus_handlers = (AppFocusHandlers){0};
+}
+
+static void deliver_focus(AppFocusHandler handler, const char *name)
+{
+	if (!handler)
+		return;
+	host_count(HOST_FOCUS_EVENTS);
+	host_profile_begin(name);
+	handler(s_in_focus);
+	host_profile_end();
+}
+
+// The modal window's animation takes no simulated time
+void host_set_focus(bool in_focus)
+{
+	if (in_focus == s_in_focus)
+		return;
+	s_in_focus = in_focus;
+	deliver_focus(s_focus_handlers.will_focus, "will_focus");
+	deliver_focus(s_focus_handlers.did_focus, "did_focus");
+}
+
+bool quiet_time_is_active(void)
+{
+	return s_quiet_time;
+}
+
+void host_set_quiet_time(bool active)
+{
+	s_quiet_time = active;
+}
+
+#ifdef PBL_HEALTH
+HealthActivityMask health_service_peek_current_activities(void)
+{
+	return s_asleep ? HealthActivitySleep : HealthActivityNone;
+}
+#endif
+
+void host_set_asleep(bool asleep)
+{
+	s_asleep = asleep;
+}
+
+// ---- Dispatch ----
+
+static void render_if_dirty(void)
+{
+	if (host_window_needs_render())
+		host_render();
+}
+
+void host_run_until(int64_t ms)
+{
+	for (;;) {
+		enum { NONE, TICK, TIMER, ACCEL } event = NONE;
+		int64_t at = ms;
+
+		if (s_tick_handler && next_tick_ms() <= at) {
+			at = next_tick_ms();
+			event = TICK;
+		}
+		if (s_timers && s_timers->due_ms <= at) {
+			at = s_timers->due_ms < host_clock_ms ? host_clock_ms :
+								s_timers->due_ms;
+			event = TIMER;
+		}
+		if (s_accel_handler && s_accel_next_ms <= at) {
+			at = s_accel_next_ms;
+			event = ACCEL;
+		}
+		if (event == NONE)
+			break;
+
+		host_clock_ms = at;
+		if (event == TICK)
+			deliver_tick();
+		else if (event == TIMER)
+			fire_timer();
+		else
+			deliver_accel_batch(NULL);
+		render_if_dirty();
+	}
+	host_clock_ms = ms;
+}
+
+void host_jump_to(int64_t ms)
+{
+	host_clock_ms = ms;
+	deliver_tick();
+	render_if_dirty();
+	while (s_timers && s_timers->due_ms <= ms) {
+		fire_timer();
+		render_if_dirty();
+	}
+	s_accel_next_ms = ms + accel_period_ms();
+}
+
+// ---- Resources ----
+
+static struct {
+	uint8_t *data;
+	size_t size;
+} *s_resource_cache;
+
+ResHandle resource_get_handle(uint32_t resource_id)
+{
+	for (size_t i = 0; i < host_num_resources; i++) {
+		if (host_resources[i].id == resource_id)
+			return &host_resources[i];
+	}
+	return NULL;
+}
+
+const uint8_t *host_resource_data(ResHandle h, size_t *size)
+{
+	if (!h)
+		return NULL;
+	if (!s_resource_cache)
+		s_resource_cache = calloc(host_num_resources,
+					  sizeof(*s_resource_cache));
+
+	size_t i = h - host_resources;
+	if (!s_resource_cache[i].data) {
+		FILE *f = fopen(h->path, "rb");
+		if (!f) {
+			fprintf(stderr, "cannot open resource %s: %s\n",
+				h->name, h->path);
+			return NULL;
+		}
+		fseek(f, 0, SEEK_END);
+		long n = ftell(f);
+		rewind(f);
+		uint8_t *data = malloc(n > 0 ? n : 1);
+		if (data && fread(data, 1, n, f) == (size_t)n) {
+			s_resource_cache[i].data = data;
+			s_resource_cache[i].size = n;
+		} else {
+			free(data);
+		}
+		fclose(f);
+	}
+	*size = s_resource_cache[i].size;
+	return s_resource_cache[i].data;
+}
+
+size_t resource_size(ResHandle h)
+{
+	size_t size = 0;
+	host_resource_data(h, &size);
+	return size;
+}
+
+size_t resource_load_byte_range(ResHandle h, uint32_t start_offset,
+				uint8_t *buffer, size_t num_bytes)
+{
+	size_t size = 0;
+	const uint8_t *data = host_resource_data(h, &size);
+
+	if (!data || start_offset >= size)
+		return 0;
+	if (num_bytes > size - start_offset)
+		num_bytes = size - start_offset;
+	memcpy(buffer, data + start_offset, num_bytes);
+	host_count(HOST_RESOURCE_LOADS);
+	host_count_n(HOST_RESOURCE_BYTES, num_bytes);
+	return num_bytes;
+}
+
+size_t resource_load(ResHandle h, uint8_t *buffer, size_t max_length)
+{
+	return resource_load_byte_range(h, 0, buffer, max_length);
+}
+
+// ---- Logging ----
+
+bool host_log_quiet;
+
+void app_log(uint8_t log_level, const char *src_filename, int src_line_number,
+	     const char *fmt, ...)
+{
+	if (host_log_quiet)
+		return;
+
+	const char *base = strrchr(src_filename, '/');
+	va_list args;
+	va_start(args, fmt);
+	fprintf(stderr, "[%lld] %s:%d> ", (long long)host_clock_ms,
+		base ? base + 1 : src_filename, src_line_number);
+	vfprintf(stderr, fmt, args);
+	fputc('\n', stderr);
+	va_end(args);
+}
@@ -0,0 +1,197 @@
+#include "host.h"
+
+#include <ctype.h>
+
+// Text drawn with a built-in 5x7 bitmap font scaled to the system font's
+// size. Glyph shapes and metrics are not the firmware's Gothic or Bitham, so
+// text shows where it lands and how much of the box it fills, nothing more.
+
+#define GLYPH_W 5
+#define GLYPH_H 7
+#define FIRST_GLYPH ' '
+#define LAST_GLYPH '~'
+
+// Columns of each glyph, least significant bit at the top
+static const uint8_t GLYPHS[][GLYPH_W] = {
+	{0x00, 0x00, 0x00, 0x00, 0x00}, {0x00, 0x00, 0x5f, 0x00, 0x00},
+	{0x00, 0x07, 0x00, 0x07, 0x00}, {0x14, 0x7f, 0x14, 0x7f, 0x14},
+	{0x24, 0x2a, 0x7f, 0x2a, 0x12}, {0x23, 0x13, 0x08, 0x64, 0x62},
+	{0x36, 0x49, 0x55, 0x22, 0x50}, {0x00, 0x05, 0x03, 0x00, 0x00},
+	{0x00, 0x1c, 0x22, 0x41, 0x00}, {0x00, 0x41, 0x22, 0x1c, 0x00},
+	{0x08, 0x2a, 0x1c, 0x2a, 0x08}, {0x08, 0x08, 0x3e, 0x08, 0x08},
+	{0x00, 0x50, 0x30, 0x00, 0x00}, {0x08, 0x08, 0x08, 0x08, 0x08},
+	{0x00, 0x60, 0x60, 0x00, 0x00}, {0x20, 0x10, 0x08, 0x04, 0x02},
+	{0x3e, 0x51, 0x49, 0x45, 0x3e}, {0x00, 0x42, 0x7f, 0x40, 0x00},
+	{0x42, 0x61, 0x51, 0x49, 0x46}, {0x21, 0x41, 0x45, 0x4b, 0x31},
+	{0x18, 0x14, 0x12, 0x7f, 0x10}, {0x27, 0x45, 0x45, 0x45, 0x39},
+	{0x3c, 0x4a, 0x49, 0x49, 0x30}, {0x01, 0x71, 0x09, 0x05, 0x03},
+	{0x36, 0x49, 0x49, 0x49, 0x36}, {0x06, 0x49, 0x49, 0x29, 0x1e},
+	{0x00, 0x36, 0x36, 0x00, 0x00}, {0x00, 0x56, 0x36, 0x00, 0x00},
+	{0x00, 0x08, 0x14, 0x22, 0x41}, {0x14, 0x14, 0x14, 0x14, 0x14},
+	{0x41, 0x22, 0x14, 0x08, 0x00}, {0x02, 0x01, 0x51, 0x09, 0x06},
+	{0x32, 0x49, 0x79, 0x41, 0x3e}, {0x7e, 0x11, 0x11, 0x11, 0x7e},
+	{0x7f, 0x49, 0x49, 0x49, 0x36}, {0x3e, 0x41, 0x41, 0x41, 0x22},
+	{0x7f, 0x41, 0x41, 0x22, 0x1c}, {0x7f, 0x49, 0x49, 0x49, 0x41},
+	{0x7f, 0x09, 0x09, 0x01, 0x01}, {0x3e, 0x41, 0x41, 0x51, 0x32},
+	{0x7f, 0x08, 0x08, 0x08, 0x7f}, {0x00, 0x41, 0x7f, 0x41, 0x00},
+	{0x20, 0x40, 0x41, 0x3f, 0x01}, {0x7f, 0x08, 0x14, 0x22, 0x41},
+	{0x7f, 0x40, 0x40, 0x40, 0x40}, {0x7f, 0x02, 0x04, 0x02, 0x7f},
+	{0x7f, 0x04, 0x08, 0x10, 0x7f}, {0x3e, 0x41, 0x41, 0x41, 0x3e},
+	{0x7f, 0x09, 0x09, 0x09, 0x06}, {0x3e, 0x41, 0x51, 0x21, 0x5e},
+	{0x7f, 0x09, 0x19, 0x29, 0x46}, {0x46, 0x49, 0x49, 0x49, 0x31},
+	{0x01, 0x01, 0x7f, 0x01, 0x01}, {0x3f, 0x40, 0x40, 0x40, 0x3f},
+	{0x1f, 0x20, 0x40, 0x20, 0x1f}, {0x7f, 0x20, 0x18, 0x20, 0x7f},
+	{0x63, 0x14, 0x08, 0x14, 0x63}, {0x03, 0x04, 0x78, 0x04, 0x03},
+	{0x61, 0x51, 0x49, 0x45, 0x43}, {0x00, 0x00, 0x7f, 0x41, 0x41},
+	{0x02, 0x04, 0x08, 0x10, 0x20}, {0x41, 0x41, 0x7f, 0x00, 0x00},
+	{0x04, 0x02, 0x01, 0x02, 0x04}, {0x40, 0x40, 0x40, 0x40, 0x40},
+	{0x00, 0x01, 0x02, 0x04, 0x00}, {0x20, 0x54, 0x54, 0x54, 0x78},
+	{0x7f, 0x48, 0x44, 0x44, 0x38}, {0x38, 0x44, 0x44, 0x44, 0x20},
+	{0x38, 0x44, 0x44, 0x48, 0x7f}, {0x38, 0x54, 0x54, 0x54, 0x18},
+	{0x08, 0x7e, 0x09, 0x01, 0x02}, {0x08, 0x14, 0x54, 0x54, 0x3c},
+	{0x7f, 0x08, 0x04, 0x04, 0x78}, {0x00, 0x44, 0x7d, 0x40, 0x00},
+	{0x20, 0x40, 0x44, 0x3d, 0x00}, {0x00, 0x7f, 0x10, 0x28, 0x44},
+	{0x00, 0x41, 0x7f, 0x40, 0x00}, {0x7c, 0x04, 0x18, 0x04, 0x78},
+	{0x7c, 0x08, 0x04, 0x04, 0x78}, {0x38, 0x44, 0x44, 0x44, 0x38},
+	{0x7c, 0x14, 0x14, 0x14, 0x08}, {0x08, 0x14, 0x14, 0x18, 0x7c},
+	{0x7c, 0x08, 0x04, 0x04, 0x08}, {0x48, 0x54, 0x54, 0x54, 0x20},
+	{0x04, 0x3f, 0x44, 0x40, 0x20}, {0x3c, 0x40, 0x40, 0x20, 0x7c},
+	{0x1c, 0x20, 0x40, 0x20, 0x1c}, {0x3c, 0x40, 0x30, 0x40, 0x3c},
+	{0x44, 0x28, 0x10, 0x28, 0x44}, {0x0c, 0x50, 0x50, 0x50, 0x3c},
+	{0x44, 0x64, 0x54, 0x4c, 0x44}, {0x00, 0x08, 0x36, 0x41, 0x00},
+	{0x00, 0x00, 0x7f, 0x00, 0x00}, {0x00, 0x41, 0x36, 0x08, 0x00},
+	{0x10, 0x08, 0x08, 0x10, 0x08},
+};
+
+struct HostFont {
+	char key[40];
+	// Line height of the system font, and the scale that makes the 5x7
+	// glyphs roughly as tall as its capitals
+	int height;
+	int scale;
+	bool bold;
+};
+
+#define MAX_FONTS 16
+
+GFont fonts_get_system_font(const char *font_key)
+{
+	static struct HostFont s_fonts[MAX_FONTS];
+	static int s_num_fonts;
+
+	for (int i = 0; i < s_num_fonts; i++) {
+		if (!strcmp(s_fonts[i].key, font_key))
+			return &s_fonts[i];
+	}
+	if (s_num_fonts == MAX_FONTS)
+		return &s_fonts[0];
+
+	struct HostFont *font = &s_fonts[s_num_fonts++];
+	snprintf(font->key, sizeof(font->key), "%s", font_key);
+	const char *digits = font_key;
+	while (*digits && !isdigit((unsigned char)*digits))
+		digits++;
+	font->height = *digits ? atoi(digits) : 14;
+	font->scale = font->height * 2 / 3 / GLYPH_H;
+	if (font->scale < 1)
+		font->scale = 1;
+	font->bold = strstr(font_key, "BOLD") || strstr(font_key, "BLACK");
+	return font;
+}
+
+static int glyph_advance(GFont font)
+{
+	return (GLYPH_W + 1) * font->scale + font->bold;
+}
+
+static void draw_glyph(GContext *ctx, GFont font, char c, int x, int y)
+{
+	if (c < FIRST_GLYPH || c > LAST_GLYPH)
+		c = '?';
+	const uint8_t *columns = GLYPHS[c - FIRST_GLYPH];
+	int s = font->scale;
+
+	for (int col = 0; col < GLYPH_W; col++) {
+		for (int row = 0; row < GLYPH_H; row++) {
+			if (!(columns[col] & (1 << row)))
+				continue;
+			// Widen each stroke by a pixel for bold faces
+			GRect r = GRect(x + col * s, y + row * s,
+					s + font->bold, s);
+			for (int py = 0; py < r.size.h; py++) {
+				for (int px = 0; px < r.size.w; px++) {
+					graphics_draw_pixel(
+						ctx, GPoint(r.origin.x + px,
+							    r.origin.y + py));
+				}
+			}
+		}
+	}
+}
+
+// Length of the next line starting at text that fits in width pixels
+static size_t line_length(GFont font, const char *text, int width,
+			  GTextOverflowMode overflow_mode)
+{
+	size_t max_chars = width / glyph_advance(font);
+	size_t n = 0, last_break = 0;
+
+	if (max_chars == 0)
+		max_chars = 1;
+	while (text[n] && text[n] != '\n') {
+		if (n == max_chars) {
+			if (overflow_mode == GTextOverflowModeWordWrap &&
+			    last_break)
+				return last_break;
+			return n;
+		}
+		if (text[n] == ' ')
+			last_break = n + 1;
+		n++;
+	}
+	return n;
+}
+
+void graphics_draw_text(GContext *ctx, const char *text, const GFont font,
+			const GRect box, const GTextOverflowMode overflow_mode,
+			const GTextAlignment alignment,
+			GTextAttributes *text_attributes)
+{
+	host_count_draw(HOST_DRAW_TEXT);
+	if (!text || !font)
+		return;
+
+	// Draw glyph pixels through the stroke colour without counting them
+	GColor stroke = ctx->stroke_color;
+	ctx->stroke_color = ctx->text_color;
+	host_profile_begin(NULL);
+
+	int s = font->scale;
+	int y = box.origin.y + (font->height - GLYPH_H * s + 1) / 2;
+	const char *p = text;
+	while (*p && y < box.origin.y + box.size.h) {
+		size_t n = line_length(font, p, box.size.w, overflow_mode);
+		size_t visible = n;
+		while (visible && p[visible - 1] == ' ')
+			visible--;
+
+		int width = visible * glyph_advance(font) - s;
+		int x = box.origin.x;
+		if (alignment == GTextAlignmentCenter)
+			x += (box.size.w - width) / 2;
+		else if (alignment == GTextAlignmentRight)
+			x += box.size.w - width;
+
+		for (size_t i = 0; i < visible; i++)
+			draw_glyph(ctx, font, p[i], x + i * glyph_advance(font),
+				   y);
+
+		p += n;
+		if (*p == '\n')
+			p++;
+		y += font->height;
+	}
+
+	host_profile_end();
+	ctx->stroke_color = stroke;
+}
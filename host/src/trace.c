@@ -0,0 +1,156 @@
+#include "host.h"
+
+#include <errno.h>
+
+// Sensor traces: accelerometer readings, taps, battery states, focus,
+// Quiet Time and sleep at times relative to the trace's start, replayed in
+// simulated time. The format is described in README.md.
+
+static const char *s_path;
+static int s_line;
+
+static void fail(const char *what)
+{
+	fprintf(stderr, "%s:%d: %s\n", s_path, s_line, what);
+	exit(2);
+}
+
+static FILE *open_trace(const char *path)
+{
+	FILE *f = fopen(path, "r");
+	if (!f) {
+		fprintf(stderr, "%s: %s\n", path, strerror(errno));
+		exit(2);
+	}
+	s_path = path;
+	s_line = 0;
+	return f;
+}
+
+// The next line that is not blank or a comment, with its newline removed
+static bool next_line(FILE *f, char *buf, size_t size)
+{
+	while (fgets(buf, (int)size, f)) {
+		s_line++;
+		buf[strcspn(buf, "\r\n#")] = '\0';
+		if (buf[strspn(buf, " \t")])
+			return true;
+	}
+	return false;
+}
+
+static bool parse_start(const char *line, int64_t *ms)
+{
+	struct tm tm = {0};
+	if (strncmp(line, "start ", 6))
+		return false;
+	const char *end = strptime(line + 6, "%Y-%m-%d %H:%M:%S", &tm);
+	if (!end || end[strspn(end, " \t")])
+		fail("bad start time");
+	*ms = (int64_t)timegm(&tm) * 1000;
+	return true;
+}
+
+int64_t host_trace_start(const char *path)
+{
+	char line[256];
+	int64_t ms = -1;
+	FILE *f = open_trace(path);
+
+	if (next_line(f, line, sizeof(line)))
+		parse_start(line, &ms);
+	fclose(f);
+	return ms;
+}
+
+static AccelAxisType parse_axis(const char *s)
+{
+	if (!strcmp(s, "x"))
+		return ACCEL_AXIS_X;
+	if (!strcmp(s, "y"))
+		return ACCEL_AXIS_Y;
+	if (!strcmp(s, "z"))
+		return ACCEL_AXIS_Z;
+	fail("bad tap axis");
+	return ACCEL_AXIS_X;
+}
+
+// An event at origin + its time
+static void replay_event(const char *line, int64_t origin)
+{
+	long long ms;
+	char event[16];
+	int n;
+
+	if (sscanf(line, "%lld %15s %n", &ms, event, &n) != 2 || ms < 0)
+		fail("expected \"<ms> <event> ...\"");
+	line += n;
+	int64_t at = origin + ms;
+	if (at < host_clock_ms)
+		fail("time goes backwards");
+	host_run_until(at);
+
+	if (!strcmp(event, "accel")) {
+		int x, y, z;
+		if (sscanf(line, "%d %d %d", &x, &y, &z) != 3)
+			fail("expected \"accel <x> <y> <z>\"");
+		AccelData data = {.x = (int16_t)x, .y = (int16_t)y,
+				  .z = (int16_t)z};
+		host_set_accel(&data);
+	} else if (!strcmp(event, "tap")) {
+		char axis[4];
+		int direction;
+		if (sscanf(line, "%3s %d", axis, &direction) != 2 ||
+		    (direction != 1 && direction != -1))
+			fail("expected \"tap <x|y|z> <1|-1>\"");
+		host_tap(parse_axis(axis), direction);
+	} else if (!strcmp(event, "battery")) {
+		int pct;
+		char state[16] = "";
+		if (sscanf(line, "%d %15s", &pct, state) < 1 || pct < 0 ||
+		    pct > 100 || (*state && strcmp(state, "charging")))
+			fail("expected \"battery <percent> [charging]\"");
+		host_set_battery((BatteryChargeState){
+			.charge_percent = (uint8_t)pct,
+			.is_charging = *state != '\0',
+			.is_plugged = *state != '\0',
+		});
+	} else if (!strcmp(event, "focus") || !strcmp(event, "quiet-time") ||
+		   !strcmp(event, "sleep")) {
+		int on;
+		char extra;
+		if (sscanf(line, "%d %c", &on, &extra) != 1 ||
+		    (on != 0 && on != 1))
+			fail("expected \"<focus|quiet-time|sleep> <0|1>\"");
+		if (*event == 'f')
+			host_set_focus(on);
+		else if (*event == 'q')
+			host_set_quiet_time(on);
+		else
+			host_set_asleep(on);
+	} else if (strcmp(event, "end")) {
+		fail("unknown event");
+	}
+
+	if (host_window_needs_render())
+		host_render();
+}
+
+void host_trace_replay(const char *path, bool jump_to_start)
+{
+	char line[256];
+	FILE *f = open_trace(path);
+	int64_t start;
+	bool more = next_line(f, line, sizeof(line));
+
+	if (more && parse_start(line, &start)) {
+		if (jump_to_start)
+			host_jump_to(start);
+		more = next_line(f, line, sizeof(line));
+	}
+
+	int64_t origin = host_clock_ms;
+	for (; more; more = next_line(f, line, sizeof(line)))
+		replay_event(line, origin);
+	fclose(f);
+}
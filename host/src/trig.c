@@ -0,0 +1,27 @@
+#include "host.h"
+
+#include <math.h>
+
+// The SDK's trig lookups, computed exactly. Kept apart from the rest of the
+// runtime so tools/lunar_check.c can link them on their own.
+
+int32_t sin_lookup(int32_t angle)
+{
+	return (int32_t)lround(sin(2 * M_PI * angle / TRIG_MAX_ANGLE) *
+			       TRIG_MAX_RATIO);
+}
+
+int32_t cos_lookup(int32_t angle)
+{
+	return (int32_t)lround(cos(2 * M_PI * angle / TRIG_MAX_ANGLE) *
+			       TRIG_MAX_RATIO);
+}
+
+int32_t atan2_lookup(int16_t y, int16_t x)
+{
+	double a = atan2(y, x);
+	if (a < 0)
+		a += 2 * M_PI;
+	return (int32_t)lround(a * TRIG_MAX_ANGLE / (2 * M_PI)) %
+	       TRIG_MAX_ANGLE;
+}
@@ -0,0 +1,310 @@
+"""Golden-image and footprint regression check of the host builds.
+
+usage: check.py [--record | --baseline] BUILD...
+
+Boots each build (build/<face>-<platform>) in every scenario below and
+compares the frame with golden/<face>-<platform>-<scenario>.png pixel for
+pixel. Then prints the build's footprint:
+
+  resources  bytes of the resource files its .pbw carries
+  code       text and read-only data of the face's own objects
+  static     data and bss of the face's own objects
+  heap       the most app heap any scenario took
+
+and checks resources and heap against budgets.json. Code and static are
+read from the face's pebble-app.elf where `pebble build` has left one,
+and from its host objects otherwise. Either moves with the compiler, so
+they are checked against code_sizes.json, the sizes recorded for the
+toolchain that built them (its ELF .comment, plus SIZE_FLAGS from the
+environment for host objects), with SIZE_TOLERANCE to spare. A toolchain
+with none recorded is reported and not checked.
+
+Fails if a frame differs, a scenario leaks heap or a budget or baseline
+is passed; frames that differ are left in build/check. With --record,
+the frames become the new golden images instead. With --baseline, no
+scenario runs: the builds' code and static are recorded in
+code_sizes.json for their toolchain.
+"""
+
+import json
+import os
+import re
+import struct
+import subprocess
+import sys
+
+HERE = os.path.dirname(os.path.abspath(__file__))
+HOST = os.path.dirname(HERE)
+sys.path.insert(0, os.path.join(HOST, '..', 'tools'))
+
+import assets  # noqa: E402
+import pngio  # noqa: E402
+
+GOLDEN_DIR = os.path.join(HOST, 'golden')
+BUDGETS = os.path.join(HOST, 'budgets.json')
+CODE_SIZES = os.path.join(HOST, 'code_sizes.json')
+OUT_DIR = os.path.join(HOST, 'build', 'check')
+
+# Name and host options of each scenario, and the faces it is for if not
+# all of them. The first --at is the boot time.
+SCENARIOS = [
+    ('day', ['--at', '2025-06-21 10:10'], None),
+    ('night', ['--at', '2025-06-21 22:30'], None),
+    ('full-moon', ['--at', '2025-06-11 22:30'], None),
+    ('new-moon', ['--at', '2025-06-25 22:30'], None),
+    ('low-battery', ['--at', '2025-06-21 10:10', '--battery', '10'], None),
+    ('charging', ['--at', '2025-06-21 10:10', '--battery', '50c'], None),
+    # Settings sent from the phone
+    ('roman', ['--at', '2025-06-21 22:30', '--message', 'MarkerStyle=1'],
+     ('moonphase',)),
+    ('ticks-long-day', ['--at', '2025-06-21 22:30', '--message',
+                        'MarkerStyle=2,DayStart=5,DayEnd=23'],
+     ('moonphase',)),
+    # The seconds hand turned on, by day and at night; gone again after its
+    # timeout, and back after a flick
+    ('seconds-hand-day', ['--at', '2025-06-21 10:10', '--message',
+                          'SecondsHand=1', '--run', '20s'], ('moonphase',)),
+    ('seconds-hand-night', ['--at', '2025-06-21 22:30', '--message',
+                            'SecondsHand=1', '--run', '40s'],
+     ('moonphase',)),
+    ('seconds-hand-idle', ['--at', '2025-06-21 22:30', '--message',
+                           'SecondsHand=1,SecondsTimeout=10', '--run', '15s'],
+     ('moonphase',)),
+    ('seconds-hand-flick', ['--at', '2025-06-21 22:30', '--message',
+                            'SecondsHand=1,SecondsTimeout=10', '--run', '15s',
+                            '--tap', '--run', '5s'], ('moonphase',)),
+    # The kitten's player: a second flick while it plays, and one after the
+    # stop timer while the loop finishes, each keep it playing past where
+    # one flick would have come to rest (3 s on 1-bit platforms, 4 s on
+    # colour). A flick just before 18:00 comes to rest on the night pose.
+    ('flick-twice', ['--at', '2025-06-21 10:10', '--flick', '--run', '2s',
+                     '--flick', '--run', '2.5s'], ('meow-o-clock',)),
+    ('flick-while-stopping', ['--at', '2025-06-21 10:10', '--flick',
+                              '--run', '3.5s', '--flick', '--run', '1s'],
+     ('meow-o-clock',)),
+    ('flick-at-dusk', ['--at', '2025-06-21 17:59:58', '--flick',
+                       '--run', '5s'], ('meow-o-clock',)),
+]
+
+METRICS = ('resources', 'code', 'static', 'heap')
+# The metrics with a budget in budgets.json; the others have a baseline
+# per toolchain in code_sizes.json
+BUDGETED = ('resources', 'heap')
+# How far code and static may grow past their baseline, in percent and at
+# least in bytes, before the check fails
+SIZE_TOLERANCE = (3, 32)
+
+# ELF section flags and types
+SHF_WRITE, SHF_ALLOC = 1, 2
+SHT_NOBITS = 8
+
+
+def elf_sizes(path):
+    """(text, data, bss, comment) of an ELF32 or ELF64 file, the sizes as
+    size(1) counts them and comment the compiler's .comment string."""
+    with open(path, 'rb') as f:
+        elf = f.read()
+    if elf[4] == 1:
+        shoff, = struct.unpack_from('<I', elf, 0x20)
+        shentsize, shnum, shstrndx = struct.unpack_from('<HHH', elf, 0x2e)
+        header = '<IIIIII'
+    else:
+        shoff, = struct.unpack_from('<Q', elf, 0x28)
+        shentsize, shnum, shstrndx = struct.unpack_from('<HHH', elf, 0x3a)
+        header = '<IIQQQQ'
+    sections = [struct.unpack_from(header, elf, shoff + i * shentsize)
+                for i in range(shnum)]
+    names = sections[shstrndx][4]
+    text = data = bss = 0
+    comment = ''
+    for name, kind, flags, _, offset, size in sections:
+        name = elf[names + name:elf.index(b'\0', names + name)]
+        if name == b'.comment':
+            comment = elf[offset:offset + size].strip(b'\0') \
+                .split(b'\0')[0].decode()
+        if not flags & SHF_ALLOC:
+            continue
+        if kind == SHT_NOBITS:
+            bss += size
+        elif flags & SHF_WRITE:
+            data += size
+        else:
+            text += size
+    return text, data, bss, comment
+
+
+def code_size(face, platform):
+    """(code, static, toolchain) of a build: its watch binary's if `pebble
+    build` has made one, else its host objects'."""
+    elf = os.path.join(HOST, '..', face, 'build', platform, 'pebble-app.elf')
+    if os.path.exists(elf):
+        text, data, bss, comment = elf_sizes(elf)
+        return text, data + bss, '%s, pebble build' % comment
+    code = static = 0
+    comment = ''
+    for kind in ('face', 'common'):
+        obj_dir = os.path.join(HOST, 'build', face, platform, 'obj', kind)
+        if not os.path.isdir(obj_dir):
+            continue
+        for obj in sorted(os.listdir(obj_dir)):
+            if obj.endswith('.o'):
+                text, data, bss, comment = elf_sizes(
+                    os.path.join(obj_dir, obj))
+                code += text
+                static += data + bss
+    return code, static, '%s, %s' % (comment,
+                                     os.environ.get('SIZE_FLAGS', ''))
+
+
+def footprint(build, heap):
+    name = os.path.basename(build)
+    face, platform = name.rsplit('-', 1)
+    code, static, toolchain = code_size(face, platform)
+    resources = sum(row[1] for row in assets.resource_sizes(
+        os.path.join(HOST, '..', face), platform))
+    return {'resources': resources, 'code': code, 'static': static,
+            'heap': heap}, toolchain
+
+
+def size_limit(baseline):
+    percent, least = SIZE_TOLERANCE
+    return baseline + max(baseline * percent // 100, least)
+
+
+def record_baseline(builds):
+    """Write the code and static of builds to code_sizes.json under their
+    toolchain, keeping what other toolchains have recorded."""
+    with open(CODE_SIZES) as f:
+        baselines = json.load(f)
+    for build in builds:
+        face, platform = os.path.basename(build).rsplit('-', 1)
+        code, static, toolchain = code_size(face, platform)
+        baselines.setdefault(toolchain, {})[os.path.basename(build)] = {
+            'code': code, 'static': static}
+        print('%-24s %9d %9d  %s' % (os.path.basename(build), code, static,
+                                     toolchain))
+    with open(CODE_SIZES, 'w') as f:
+        json.dump({toolchain: dict(sorted(sizes.items()))
+                   for toolchain, sizes in sorted(baselines.items())},
+                  f, indent=2)
+        f.write('\n')
+    print('recorded the code and static of %d builds in %s' %
+          (len(builds), os.path.relpath(CODE_SIZES)))
+
+
+def run(build, options, png):
+    """Render a scenario to png, returning (heap peak, bytes leaked)."""
+    out = subprocess.check_output(
+        [build, '--quiet'] + options + ['--png', png],
+        universal_newlines=True)
+    heap = re.search(r'^heap: .*peak=(\d+) leaked=(\d+)', out, re.M)
+    return int(heap.group(1)), int(heap.group(2))
+
+
+def differing_pixels(a, b):
+    with open(a, 'rb') as f:
+        wa, ha, pa = pngio.decode(f.read())
+    with open(b, 'rb') as f:
+        wb, hb, pb = pngio.decode(f.read())
+    if (wa, ha) != (wb, hb):
+        return wa * ha
+    return sum(1 for p, q in zip(pa, pb) if p != q)
+
+
+def same_file(a, b):
+    with open(a, 'rb') as fa, open(b, 'rb') as fb:
+        return fa.read() == fb.read()
+
+
+def main(args):
+    if args[:1] == ['--baseline']:
+        record_baseline(args[1:])
+        return
+    record = args[:1] == ['--record']
+    builds = args[1:] if record else args
+    os.makedirs(OUT_DIR, exist_ok=True)
+    os.makedirs(GOLDEN_DIR, exist_ok=True)
+    with open(BUDGETS) as f:
+        budgets = json.load(f)
+    with open(CODE_SIZES) as f:
+        baselines = json.load(f)
+
+    failures = []
+    unrecorded = set()
+    frames = 0
+    print('%-24s %9s %9s %9s %9s' % (('build',) + METRICS))
+    for build in builds:
+        name = os.path.basename(build)
+        face = name.rsplit('-', 1)[0]
+        heap = 0
+        for scenario, options, faces in SCENARIOS:
+            if faces and face not in faces:
+                continue
+            frames += 1
+            frame = '%s-%s.png' % (name, scenario)
+            actual = os.path.join(OUT_DIR, frame)
+            golden = os.path.join(GOLDEN_DIR, frame)
+            peak, leaked = run(build, options, actual)
+            heap = max(heap, peak)
+            if leaked:
+                failures.append('%s %s: leaked %d bytes' %
+                                (name, scenario, leaked))
+
+            if record:
+                os.replace(actual, golden)
+            elif not os.path.exists(golden):
+                failures.append('%s: no golden image' % frame)
+            elif same_file(actual, golden):
+                os.remove(actual)
+            else:
+                pixels = differing_pixels(actual, golden)
+                if pixels:
+                    failures.append('%s: %d pixels differ from golden/' %
+                                    (frame, pixels))
+                else:
+                    os.remove(actual)
+
+        sizes, toolchain = footprint(build, heap)
+        budget = budgets.get(name, {})
+        baseline = baselines.get(toolchain, {}).get(name)
+        if baseline is None:
+            unrecorded.add(toolchain)
+        cells = []
+        for metric in METRICS:
+            if metric in BUDGETED:
+                limit = budget.get(metric)
+                if limit is None:
+                    failures.append('%s: no %s budget' % (name, metric))
+                elif sizes[metric] > limit:
+                    failures.append('%s: %s %d over its budget of %d' %
+                                    (name, metric, sizes[metric], limit))
+            else:
+                limit = baseline and size_limit(baseline[metric])
+                if limit and sizes[metric] > limit:
+                    failures.append(
+                        '%s: %s %d over %d, its baseline of %d and '
+                        'tolerance' % (name, metric, sizes[metric], limit,
+                                       baseline[metric]))
+            cells.append('%d%s' % (sizes[metric],
+                                   '!' if limit and sizes[metric] > limit
+                                   else ''))
+        print('%-24s %9s %9s %9s %9s' % tuple([name] + cells))
+
+    if record:
+        print('recorded %d golden images in %s' %
+              (frames, os.path.relpath(GOLDEN_DIR)))
+    for toolchain in sorted(unrecorded):
+        print('code and static unchecked, none recorded for %s: run '
+              'make -C host baseline' % toolchain)
+    for failure in failures:
+        print('FAIL ' + failure)
+    if failures:
+        sys.exit(1)
+    if not record:
+        print('%d frames match, every footprint within budget' % frames)
+
+
+if __name__ == '__main__':
+    if not sys.argv[1:] or sys.argv[1:] in (['--record'], ['--baseline']):
+        sys.exit(__doc__)
+    main(sys.argv[1:])
@@ -0,0 +1,90 @@
+#include "lunar.h"
+
+// Checks moonphase's lunation engine against lunar_reference.txt, the new
+// and full moons of two centuries from the full theory. Asked a day before
+// each one when the next will be, the engine has to answer within
+// TOLERANCE_S, and at each full moon the disc has to be lit to at least
+// FULL_ILLUMINATION_MIN. Linked against the same lunar.o as the face.
+//
+//   usage: lunar_check TABLE
+
+#define TOLERANCE_S (10 * 60)
+#define FULL_ILLUMINATION_MIN 995
+#define ASK_AHEAD_S 86400
+
+int main(int argc, char **argv)
+{
+	if (argc != 2) {
+		fprintf(stderr, "usage: %s TABLE\n", argv[0]);
+		return 2;
+	}
+	FILE *f = fopen(argv[1], "r");
+	if (!f) {
+		perror(argv[1]);
+		return 2;
+	}
+
+	int events = 0, failures = 0;
+	int min_illumination = LUNAR_ILLUMINATION_MAX;
+	long total_error = 0, worst_error = -1;
+	char worst[48] = "", line[128];
+	while (fgets(line, sizeof(line), f)) {
+		char kind[8], date[20];
+		struct tm tm = {0};
+		if (line[0] == '#')
+			continue;
+		if (sscanf(line, "%7s %19[0-9: -]", kind, date) != 2 ||
+		    sscanf(date, "%d-%d-%d %d:%d:%d", &tm.tm_year, &tm.tm_mon,
+			   &tm.tm_mday, &tm.tm_hour, &tm.tm_min,
+			   &tm.tm_sec) != 6 ||
+		    (strcmp(kind, "new") && strcmp(kind, "full"))) {
+			fprintf(stderr, "%s: bad line: %s", argv[1], line);
+			return 2;
+		}
+		tm.tm_year -= 1900;
+		tm.tm_mon -= 1;
+		time_t when = timegm(&tm);
+		bool full = !strcmp(kind, "full");
+
+		LunarPhase phase;
+		lunar_phase_at(when - ASK_AHEAD_S, &phase);
+		time_t predicted = full ? phase.next_full_moon :
+					  phase.next_new_moon;
+		long error = labs((long)(predicted - when));
+		total_error += error;
+		if (error > worst_error) {
+			worst_error = error;
+			snprintf(worst, sizeof(worst), "%s moon of %s", kind,
+				 date);
+		}
+		if (error > TOLERANCE_S) {
+			printf("FAIL %s moon of %s: %+ld s\n", kind, date,
+			       (long)(predicted - when));
+			failures++;
+		}
+
+		if (full) {
+			lunar_phase_at(when, &phase);
+			if (phase.illumination < min_illumination)
+				min_illumination = phase.illumination;
+			if (phase.illumination < FULL_ILLUMINATION_MIN) {
+				printf("FAIL full moon of %s: only %d/%d lit\n",
+				       date, (int)phase.illumination,
+				       LUNAR_ILLUMINATION_MAX);
+				failures++;
+			}
+		}
+		events++;
+	}
+	fclose(f);
+
+	if (!events) {
+		fprintf(stderr, "%s: no new or full moons\n", argv[1]);
+		return 2;
+	}
+	printf("lunar: %d new and full moons, off by %.1f min on average and "
+	       "%.1f at worst (%s); full moons at least %d/%d lit\n",
+	       events, total_error / 60.0 / events, worst_error / 60.0, worst,
+	       min_illumination, LUNAR_ILLUMINATION_MAX);
+	return failures ? 1 : 0;
+}
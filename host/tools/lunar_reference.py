@@ -0,0 +1,152 @@
+"""Write the reference table of new and full moons that lunar_check tests
+moonphase's lunation engine against.
+
+usage: lunar_reference.py > lunar_reference.txt
+
+Times come from the full solution of Meeus, Astronomical Algorithms,
+chapter 49: the mean phase, its 25 periodic corrections and the 14
+planetary arguments, good to a few seconds against the ephemerides. They
+are converted from dynamical time to UTC with Espenak and Meeus's
+polynomials for delta T. The table covers 1900 to 2100, past where a
+32-bit count of seconds from J2000.0 runs out on either side, and is
+checked in, so the check does not depend on this script.
+"""
+
+import calendar
+import math
+import time
+
+FIRST_YEAR, LAST_YEAR = 1900, 2100
+
+# Julian ephemeris day of the Unix epoch
+UNIX_EPOCH_JD = 2440587.5
+
+# Coefficients of the corrections to the mean phase, for new and full moon,
+# and what each multiplies: a power of E and a sine of a sum of multiples
+# of M, M', F and omega
+CORRECTIONS = [
+    # new, full, E^n, M, M', F, omega
+    (-0.40720, -0.40614, 0, 0, 1, 0, 0),
+    (0.17241, 0.17302, 1, 1, 0, 0, 0),
+    (0.01608, 0.01614, 0, 0, 2, 0, 0),
+    (0.01039, 0.01043, 0, 0, 0, 2, 0),
+    (0.00739, 0.00734, 1, -1, 1, 0, 0),
+    (-0.00514, -0.00515, 1, 1, 1, 0, 0),
+    (0.00208, 0.00209, 2, 2, 0, 0, 0),
+    (-0.00111, -0.00111, 0, 0, 1, -2, 0),
+    (-0.00057, -0.00057, 0, 0, 1, 2, 0),
+    (0.00056, 0.00056, 1, 1, 2, 0, 0),
+    (-0.00042, -0.00042, 0, 0, 3, 0, 0),
+    (0.00042, 0.00042, 1, 1, 0, 2, 0),
+    (0.00038, 0.00038, 1, 1, 0, -2, 0),
+    (-0.00024, -0.00024, 1, -1, 2, 0, 0),
+    (-0.00017, -0.00017, 0, 0, 0, 0, 1),
+    (-0.00007, -0.00007, 0, 2, 1, 0, 0),
+    (0.00004, 0.00004, 0, 0, 2, -2, 0),
+    (0.00004, 0.00004, 0, 3, 0, 0, 0),
+    (0.00003, 0.00003, 0, 1, 1, -2, 0),
+    (0.00003, 0.00003, 0, 0, 2, 2, 0),
+    (-0.00003, -0.00003, 0, 1, 1, 2, 0),
+    (0.00003, 0.00003, 0, -1, 1, 2, 0),
+    (-0.00002, -0.00002, 0, -1, 1, -2, 0),
+    (-0.00002, -0.00002, 0, 1, 3, 0, 0),
+    (0.00002, 0.00002, 0, 0, 4, 0, 0),
+]
+
+# The planetary arguments: coefficient, and the argument in degrees as a
+# constant and a rate per lunation
+PLANETARY = [
+    (0.000325, 299.77, 0.107408),
+    (0.000165, 251.88, 0.016321),
+    (0.000164, 251.83, 26.651886),
+    (0.000126, 349.42, 36.412478),
+    (0.000110, 84.66, 18.206239),
+    (0.000062, 141.74, 53.303771),
+    (0.000060, 207.14, 2.453732),
+    (0.000056, 154.84, 7.306860),
+    (0.000047, 34.52, 27.261239),
+    (0.000042, 207.19, 0.121824),
+    (0.000040, 291.34, 1.844379),
+    (0.000037, 161.72, 24.198154),
+    (0.000035, 239.56, 25.513099),
+    (0.000023, 331.55, 3.592518),
+]
+
+
+def phase_jde(k):
+    """Julian ephemeris day of lunation k, a whole number for a new moon
+    and half way between for a full one."""
+    t = k / 1236.85
+    jde = (2451550.09766 + 29.530588861 * k + 0.00015437 * t ** 2 -
+           0.000000150 * t ** 3 + 0.00000000073 * t ** 4)
+    e = 1 - 0.002516 * t - 0.0000074 * t ** 2
+    m = math.radians(2.5534 + 29.10535670 * k - 0.0000014 * t ** 2 -
+                     0.00000011 * t ** 3)
+    mp = math.radians(201.5643 + 385.81693528 * k + 0.0107582 * t ** 2 +
+                      0.00001238 * t ** 3 - 0.000000058 * t ** 4)
+    f = math.radians(160.7108 + 390.67050284 * k - 0.0016118 * t ** 2 -
+                     0.00000227 * t ** 3 + 0.000000011 * t ** 4)
+    omega = math.radians(124.7746 - 1.56375588 * k + 0.0020672 * t ** 2 +
+                         0.00000215 * t ** 3)
+
+    full = k % 1 != 0
+    for new_c, full_c, e_power, cm, cmp, cf, comega in CORRECTIONS:
+        jde += ((full_c if full else new_c) * e ** e_power *
+                math.sin(cm * m + cmp * mp + cf * f + comega * omega))
+    for c, a0, rate in PLANETARY:
+        jde += c * math.sin(math.radians(a0 + rate * k))
+    return jde
+
+
+def delta_t(year):
+    """Dynamical time less UTC in seconds (Espenak and Meeus, 2006)."""
+    if year < 1920:
+        t = year - 1900
+        return (-2.79 + 1.494119 * t - 0.0598939 * t ** 2 +
+                0.0061966 * t ** 3 - 0.000197 * t ** 4)
+    if year < 1941:
+        t = year - 1920
+        return 21.20 + 0.84493 * t - 0.076100 * t ** 2 + 0.0020936 * t ** 3
+    if year < 1961:
+        t = year - 1950
+        return 29.07 + 0.407 * t - t ** 2 / 233 + t ** 3 / 2547
+    if year < 1986:
+        t = year - 1975
+        return 45.45 + 1.067 * t - t ** 2 / 260 - t ** 3 / 718
+    t = year - 2000
+    if year < 2005:
+        return (63.86 + 0.3345 * t - 0.060374 * t ** 2 +
+                0.0017275 * t ** 3 + 0.000651814 * t ** 4 +
+                0.00002373599 * t ** 5)
+    if year < 2050:
+        return 62.92 + 0.32217 * t + 0.005589 * t ** 2
+    u = (year - 1820) / 100.0
+    return -20 + 32 * u ** 2 - 0.5628 * (2150 - year)
+
+
+def unix_time(jde):
+    seconds = (jde - UNIX_EPOCH_JD) * 86400
+    year = time.gmtime(seconds).tm_year
+    return int(round(seconds - delta_t(year)))
+
+
+def main():
+    first = calendar.timegm((FIRST_YEAR, 1, 1, 0, 0, 0))
+    last = calendar.timegm((LAST_YEAR + 1, 1, 1, 0, 0, 0))
+    print('# New and full moons %d-%d in UTC, from Meeus, Astronomical '
+          'Algorithms,' % (FIRST_YEAR, LAST_YEAR))
+    print('# chapter 49. Written by tools/lunar_reference.py.')
+    k = math.floor((FIRST_YEAR - 2000) * 12.3685) - 1
+    while True:
+        for kind, offset in (('new', 0), ('full', 0.5)):
+            t = unix_time(phase_jde(k + offset))
+            if first <= t < last:
+                print('%-4s %s' % (kind, time.strftime(
+                    '%Y-%m-%d %H:%M:%S', time.gmtime(t))))
+            elif t >= last:
+                return
+        k += 1
+
+
+if __name__ == '__main__':
+    main()
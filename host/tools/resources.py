@@ -0,0 +1,117 @@
+"""Generate resource ids and the resource table for a host build of a face.
+
+usage: resources.py FACE_DIR PLATFORM OUT_DIR
+
+Runs the face's build-time generators first (the generate_resources()
+hook its wscript calls from build()), then resolves each media entry of
+package.json for PLATFORM, file tags included, and writes:
+
+  OUT_DIR/resource_ids.auto.h  RESOURCE_ID_* in the SDK's numbering
+  OUT_DIR/message_keys.auto.h  MESSAGE_KEY_* for its messageKeys, likewise
+  OUT_DIR/resources.auto.c     id, name and absolute path of each file,
+                               and the id and name of each message key
+"""
+
+import json
+import os
+import sys
+
+HERE = os.path.dirname(os.path.abspath(__file__))
+sys.path.insert(0, os.path.join(HERE, '..', '..', 'tools'))
+
+import assets  # noqa: E402
+import genutil  # noqa: E402
+
+MESSAGE_KEY_BASE = 10000
+
+
+class Node(object):
+    """The corner of waf's Node API that the wscript hooks use."""
+
+    def __init__(self, path):
+        self.path = os.path.abspath(path)
+
+    @property
+    def parent(self):
+        return Node(os.path.dirname(self.path))
+
+    def abspath(self):
+        return self.path
+
+    def find_dir(self, name):
+        path = os.path.join(self.path, name)
+        return Node(path) if os.path.isdir(path) else None
+
+    def find_node(self, name):
+        path = os.path.join(self.path, name)
+        return Node(path) if os.path.exists(path) else None
+
+    def make_node(self, name):
+        return Node(os.path.join(self.path, name))
+
+
+class Context(object):
+    def __init__(self, face_dir):
+        self.path = Node(face_dir)
+
+
+def run_generators(face_dir):
+    wscript = os.path.join(face_dir, 'wscript')
+    scope = {'__file__': wscript}
+    with open(wscript) as f:
+        exec(compile(f.read(), wscript, 'exec'), scope)
+    if 'generate_resources' in scope:
+        scope['generate_resources'](Context(face_dir))
+
+
+def main(face_dir, platform, out_dir):
+    face_dir = os.path.abspath(face_dir)
+    run_generators(face_dir)
+
+    with open(os.path.join(face_dir, 'package.json')) as f:
+        pebble = json.load(f)['pebble']
+    media = pebble['resources']['media']
+
+    ids, table = [], []
+    resources_dir = os.path.join(face_dir, 'resources')
+    for entry in media:
+        targets = entry.get('targetPlatforms')
+        if targets and platform not in targets:
+            continue
+        rid = len(ids) + 1
+        path = assets.resolve(resources_dir, entry['file'], platform)
+        ids.append('#define RESOURCE_ID_%s %d' % (entry['name'], rid))
+        table.append('\t{%d, "%s", "%s"},' % (rid, entry['name'], path))
+
+    # The SDK numbers message keys from 10000 in the order given
+    keys, key_table = [], []
+    for i, name in enumerate(pebble.get('messageKeys', [])):
+        keys.append('#define MESSAGE_KEY_%s %d' % (name, MESSAGE_KEY_BASE + i))
+        key_table.append('\t{%d, "%s"},' % (MESSAGE_KEY_BASE + i, name))
+
+    header = ['// Generated by host/tools/resources.py. Do not edit.',
+              '#pragma once', ''] + ids + ['']
+    key_header = ['// Generated by host/tools/resources.py. Do not edit.',
+                  '#pragma once', ''] + keys + ['']
+    source = ['// Generated by host/tools/resources.py. Do not edit.',
+              '#include "host.h"', '',
+              'const struct HostResource host_resources[] = {'] + table + [
+              '\t{0, NULL, NULL},',
+              '};',
+              '',
+              'const size_t host_num_resources = %d;' % len(table), '',
+              'const struct HostMessageKey host_message_keys[] = {']
+    source += key_table + ['\t{0, NULL},', '};', '']
+
+    genutil.write_if_changed(os.path.join(out_dir, 'resource_ids.auto.h'),
+                             '\n'.join(header).encode())
+    genutil.write_if_changed(os.path.join(out_dir, 'message_keys.auto.h'),
+                             '\n'.join(key_header).encode())
+    genutil.write_if_changed(os.path.join(out_dir, 'resources.auto.c'),
+                             '\n'.join(source).encode())
+
+
+if __name__ == '__main__':
+    if len(sys.argv) != 4:
+        sys.exit(__doc__)
+    main(*sys.argv[1:])
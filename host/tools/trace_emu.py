@@ -0,0 +1,146 @@
+"""Replay a sensor trace into a running Pebble emulator.
+
+usage: trace_emu.py TRACE PLATFORM [SPEEDUP]
+
+Sends the trace's accelerometer readings, taps and battery states with
+the SDK's pebble emu-accel, emu-tap and emu-battery commands, in real
+time or SPEEDUP times faster. Readings less than a second apart go in one
+emu-accel call. The emulator keeps its own clock, so the trace's start
+line is ignored and ticks follow the emulator rather than the trace. It
+has no command for focus, Quiet Time or sleep, so those events are
+skipped.
+
+Meanwhile it follows pebble logs for the face's "flick" lines and matches
+each to a tap labelled "# glance" that came up to MATCH_S before it. At
+the end it reports glances detected and missed and flicks without a
+glance, and exits 1 unless every glance was detected and nothing else
+was. Counts and timings beyond that are only reported by the host build
+(see README.md).
+"""
+
+import os
+import re
+import subprocess
+import sys
+import tempfile
+import threading
+import time
+
+# Trace seconds from a glance's tap within which its flick has to be
+# logged: the detector samples for at most 1 s after a tap
+MATCH_S = 3
+# Wall seconds to wait for the log after the last event
+SETTLE_S = 5
+
+FLICK_LOG = re.compile(r'> flick$')
+
+
+def pebble(platform, *args):
+    subprocess.check_call(('pebble',) + args + ('--emulator', platform))
+
+
+def events(path):
+    """(ms, event, args, label) for each event line of the trace."""
+    with open(path) as f:
+        for line in f:
+            line, _, label = line.partition('#')
+            line = line.split()
+            if line and line[0] != 'start':
+                yield int(line[0]), line[1], line[2:], label.strip()
+
+
+def send_readings(platform, readings):
+    with tempfile.NamedTemporaryFile('w', suffix='.txt',
+                                     delete=False) as f:
+        for x, y, z in readings:
+            f.write('%s,%s,%s\n' % (x, y, z))
+    try:
+        pebble(platform, 'emu-accel', 'custom', '--file', f.name)
+    finally:
+        os.unlink(f.name)
+
+
+class FlickLog(object):
+    """The wall times of the flicks the face logs, from pebble logs."""
+
+    def __init__(self, platform):
+        self.times = []
+        self._proc = subprocess.Popen(
+            ('pebble', 'logs', '--emulator', platform),
+            stdout=subprocess.PIPE, universal_newlines=True)
+        thread = threading.Thread(target=self._read)
+        thread.daemon = True
+        thread.start()
+
+    def _read(self):
+        for line in self._proc.stdout:
+            if FLICK_LOG.search(line.rstrip()):
+                self.times.append(time.time())
+
+    def close(self):
+        self._proc.terminate()
+        self._proc.wait()
+
+
+def match(glances, flicks, window):
+    """Pair each glance with the first unpaired flick up to window after
+    it. Returns the glances missed and the flicks left over."""
+    missed, flicks = [], sorted(flicks)
+    for glance in sorted(glances):
+        hit = next((f for f in flicks if glance <= f <= glance + window),
+                   None)
+        if hit is None:
+            missed.append(glance)
+        else:
+            flicks.remove(hit)
+    return missed, flicks
+
+
+def main(path, platform, speedup='1'):
+    speedup = float(speedup)
+    log = FlickLog(platform)
+    began = time.time()
+    readings, readings_ms = [], None
+    glances = []
+
+    for ms, event, args, label in events(path):
+        if readings and (event != 'accel' or ms - readings_ms >= 1000):
+            send_readings(platform, readings)
+            readings = []
+        delay = began + ms / 1000.0 / speedup - time.time()
+        if delay > 0 and not readings:
+            time.sleep(delay)
+
+        if event == 'accel':
+            if not readings:
+                readings_ms = ms
+            readings.append(args)
+        elif event == 'tap':
+            if label == 'glance':
+                glances.append(time.time())
+            pebble(platform, 'emu-tap', '--direction',
+                   args[0] + ('+' if args[1] == '1' else '-'))
+        elif event == 'battery':
+            charging = ('--charging',) if args[1:] == ['charging'] else ()
+            pebble(platform, 'emu-battery', '--percent', args[0], *charging)
+    if readings:
+        send_readings(platform, readings)
+    time.sleep(SETTLE_S)
+    log.close()
+
+    missed, extra = match(glances, log.times, MATCH_S / speedup)
+    print('%s: %d glances, %d detected, %d missed; flicks without a '
+          'glance: %d' % (os.path.basename(path), len(glances),
+                          len(glances) - len(missed), len(missed),
+                          len(extra)))
+    for t in missed:
+        print('  missed the glance at %.1f s' % ((t - began) * speedup))
+    for t in extra:
+        print('  flick without a glance at %.1f s' % ((t - began) * speedup))
+    return 1 if missed or extra else 0
+
+
+if __name__ == '__main__':
+    if len(sys.argv) not in (3, 4):
+        sys.exit(__doc__)
+    sys.exit(main(*sys.argv[1:]))
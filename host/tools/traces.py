@@ -0,0 +1,208 @@
+"""Write synthetic sensor traces of a commute, a working day, a night and
+a run of glances one after another.
+
+usage: traces.py OUT_DIR
+
+They stand in for recordings until there are some: the same seeds always
+give the same traces, so detector and player changes can be compared on
+identical input. Each trace starts with a comment saying how many times
+the wearer deliberately raised the wrist to look at the watch, and the
+tap that starts each of those is labelled "# glance"; a flick detector
+should fire about that often and not much more.
+
+The night also says when the wearer is asleep, as Health would see it;
+they wake briefly for its one glance.
+
+Readings are in mG. While the arm moves they are written at 25 Hz; in
+between, one reading holds until the next.
+"""
+
+import math
+import os
+import random
+import sys
+
+RATE_HZ = 25
+
+# Poses, as (x, y, z)
+VIEW = (0, -400, -900)  # Raised, screen towards the face
+DOWN = (0, -1000, 0)  # Arm hanging while walking or standing
+LAP = (200, -950, -250)  # Seated on a train, hand on the lap
+DESK = (-100, -150, -980)  # Wrist on the desk, typing
+SIDE = (-1000, 0, -100)  # Lying on the side, arm on the bed
+BACK = (-300, 600, -700)  # Lying on the back, arm by the side
+
+
+class Trace(object):
+    def __init__(self, start, seed, battery):
+        self.start = start
+        self.rng = random.Random(seed)
+        self.lines = []
+        self.t = 0
+        self.pose = None
+        self.battery = battery
+        self.glances = 0
+
+    def _emit(self, event, label=None):
+        self.lines.append('%d %s' % (self.t, event) +
+                          (' # ' + label if label else ''))
+
+    def hold(self, pose):
+        """Be still in pose from now."""
+        if pose != self.pose:
+            self._emit('accel %d %d %d' % pose)
+            self.pose = pose
+
+    def wait(self, seconds):
+        self.t += int(seconds * 1000)
+
+    def tap(self, label=None):
+        axis = self.rng.choice('xyz')
+        self._emit('tap %s %d' % (axis, self.rng.choice((1, -1))), label)
+
+    def move(self, pose, seconds=0.4):
+        """Turn the wrist smoothly to pose, ending still there."""
+        n = max(1, int(seconds * RATE_HZ))
+        start = self.pose
+        for i in range(1, n + 1):
+            f = i / float(n)
+            self.t += 1000 // RATE_HZ
+            self.pose = None
+            self.hold(tuple(int(a + (b - a) * f)
+                            for a, b in zip(start, pose)))
+        self.pose = pose
+
+    def swing(self, pose, seconds, amplitude, jolts_per_min):
+        """Walk for seconds, the arm swinging around pose, with jolts that
+        set off the tap detector."""
+        step = 1000 // RATE_HZ
+        end = self.t + int(seconds * 1000)
+        p_jolt = jolts_per_min / 60.0 / RATE_HZ
+        while self.t < end:
+            phase = 2 * math.pi * 0.9 * self.t / 1000.0
+            self.pose = None
+            self.hold((int(pose[0] + amplitude * math.sin(phase)),
+                       int(pose[1] + amplitude * 0.3 * math.cos(phase)),
+                       int(pose[2] + amplitude * 0.6 * math.sin(phase)),))
+            if self.rng.random() < p_jolt:
+                self.tap()
+            self.t += step
+        self.hold(pose)
+
+    def glance(self, rest, tap_in_view=False):
+        """Raise the wrist to look at the watch, then put it back. The tap
+        comes as the wrist starts to move, or as it stops in view."""
+        self.glances += 1
+        if not tap_in_view:
+            self.tap('glance')
+        self.move(VIEW, 0.3)
+        if tap_in_view:
+            self.tap('glance')
+        self.wait(self.rng.uniform(2, 5))
+        self.move(rest, 0.5)
+
+    def still(self, pose, seconds, taps_per_min):
+        """Stay in pose, with the odd knock that sets off a tap."""
+        self.hold(pose)
+        end = self.t + int(seconds * 1000)
+        while True:
+            gap = self.rng.expovariate(taps_per_min / 60.0) \
+                if taps_per_min else float('inf')
+            if self.t + gap * 1000 >= end:
+                break
+            self.wait(gap)
+            self.tap()
+        self.t = end
+
+    def state(self, event, on):
+        """Focus, Quiet Time or sleep begins (on) or ends."""
+        self._emit('%s %d' % (event, on))
+
+    def drain(self, percent):
+        self.battery -= percent
+        self._emit('battery %d' % self.battery)
+
+    def write(self, path, description):
+        with open(path, 'w') as f:
+            f.write('# %s\n# glances: %d\nstart %s\n' %
+                    (description, self.glances, self.start))
+            f.write('\n'.join(self.lines))
+            f.write('\n%d end\n' % self.t)
+
+
+def commute():
+    tr = Trace('2025-06-23 07:45:00', 1, 72)
+    tr.hold(DOWN)
+    for leg in ('walk', 'train', 'walk'):
+        for _ in range(5 if leg == 'train' else 3):
+            if leg == 'walk':
+                tr.swing(DOWN, tr.rng.uniform(150, 270), 300, 2)
+                tr.glance(DOWN)
+            else:
+                tr.still(LAP, tr.rng.uniform(240, 420), 0.5)
+                tr.glance(LAP)
+        tr.drain(1)
+    return tr, 'Walk, train and walk: taps from jolts and bumps'
+
+
+def desk():
+    tr = Trace('2025-06-23 09:00:00', 2, 70)
+    for hour in range(8):
+        for _ in range(3):
+            tr.still(DESK, tr.rng.uniform(900, 1300), 1)
+            # Hands off the keyboard, then a look at the watch
+            tr.move(DOWN, 0.6)
+            tr.wait(tr.rng.uniform(20, 120))
+            tr.glance(DOWN)
+            tr.move(DESK, 0.6)
+        tr.drain(2)
+    return tr, 'Typing at a desk, away now and then: taps while in view'
+
+
+def sleep():
+    tr = Trace('2025-06-23 23:00:00', 3, 55)
+    tr.hold(SIDE)
+    for hour in range(8):
+        for turn in range(2):
+            tr.still(tr.pose, tr.rng.uniform(1200, 2400), 0)
+            if hour == 0 and turn == 0:
+                # Asleep, as Health sees it
+                tr.state('sleep', 1)
+            # Turning over
+            tr.tap()
+            tr.move(SIDE if tr.pose == BACK else BACK, 1.5)
+        if hour == 3:
+            # Awake for a moment to check the time
+            tr.state('sleep', 0)
+            tr.wait(120)
+            tr.glance(tr.pose)
+            tr.state('sleep', 1)
+        tr.drain(1)
+    tr.state('sleep', 0)
+    return tr, 'A night turning over now and then, asleep from the first turn'
+
+
+def glances():
+    tr = Trace('2025-06-23 12:00:00', 4, 64)
+    tr.hold(DOWN)
+    for _ in range(30):
+        tr.wait(tr.rng.uniform(3, 60))
+        # Lowering the wrist sets off no tap, and the raise only does as it
+        # stops, with the watch already in view
+        tr.glance(DOWN, tap_in_view=True)
+    return tr, 'Standing, glancing again and again with no tap on the way down'
+
+
+def main(out_dir):
+    if not os.path.isdir(out_dir):
+        os.makedirs(out_dir)
+    for make in (commute, desk, sleep, glances):
+        trace, description = make()
+        trace.write(os.path.join(out_dir, make.__name__ + '.trace'),
+                    description)
+
+
+if __name__ == '__main__':
+    if len(sys.argv) != 2:
+        sys.exit(__doc__)
+    main(sys.argv[1])
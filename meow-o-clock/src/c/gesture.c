@@ -0,0 +1,213 @@
+#include "gesture.h"
+
+#include "profile.h"
+
+// 25 Hz in batches of 5: the app wakes 5 times a second during a burst
+#define BURST_SAMPLES_PER_UPDATE 5
+// While the watch may still be in view after a flick, a burst this short,
+// one batch, looks again: first once the cooldown is over, then less and
+// less often up to CHECK_MAX_MS apart
+#define CHECK_MS 250
+#define CHECK_MAX_MS 60000
+
+const GestureConfig GESTURE_DEFAULT_CONFIG = {
+	.x_min = -500,
+	.x_max = 500,
+	.y_min = -900,
+	.y_max = 200,
+	.z_min = -1100,
+	.z_max = 0,
+	.hysteresis = 100,
+	.confirm_samples = 3,
+	.burst_ms = 1000,
+	.cooldown_ms = 1500,
+};
+
+static GestureConfig s_config;
+static GestureHandler s_handler;
+static AppTimer *s_burst_timer = NULL;
+static bool s_sampling = false;
+// Consecutive samples in view so far in this burst
+static int s_in_view = 0;
+// Whether the watch has been out of view since the last flick. A flick
+// brings it into view, so taps while it stays there, typing at a desk say,
+// are not flicks. Lowering the wrist need not tap, so short bursts check
+// on it until it is seen out of view.
+static bool s_armed = true;
+static AppTimer *s_check_timer = NULL;
+static uint32_t s_check_ms;
+// Between gesture_pause() and gesture_resume()
+static bool s_paused = false;
+// Pending while taps are ignored after a flick. A timer counts time
+// elapsed, so setting the clock or crossing a time zone cannot stretch or
+// cut short the cooldown.
+static AppTimer *s_cooldown_timer = NULL;
+
+static bool within(int value, int min, int max, int margin)
+{
+	return value >= min - margin && value <= max + margin;
+}
+
+static bool in_view(const AccelData *sample, int margin)
+{
+	return within(sample->x, s_config.x_min, s_config.x_max, margin) &&
+	       within(sample->y, s_config.y_min, s_config.y_max, margin) &&
+	       within(sample->z, s_config.z_min, s_config.z_max, margin);
+}
+
+static void end_burst(void)
+{
+	if (s_burst_timer) {
+		app_timer_cancel(s_burst_timer);
+		s_burst_timer = NULL;
+	}
+	if (s_sampling) {
+		accel_data_service_unsubscribe();
+		s_sampling = false;
+	}
+}
+
+static void cancel_check(void)
+{
+	if (s_check_timer) {
+		app_timer_cancel(s_check_timer);
+		s_check_timer = NULL;
+	}
+}
+
+static void burst_data_handler(AccelData *data, uint32_t num_samples);
+static void burst_timeout_handler(void *context);
+
+static void start_burst(uint32_t ms)
+{
+	cancel_check();
+	s_in_view = 0;
+	s_sampling = true;
+	accel_data_service_subscribe(BURST_SAMPLES_PER_UPDATE,
+				     burst_data_handler);
+	accel_service_set_sampling_rate(ACCEL_SAMPLING_25HZ);
+	s_burst_timer = app_timer_register(ms, burst_timeout_handler, NULL);
+}
+
+static void check_handler(void *context)
+{
+	s_check_timer = NULL;
+	start_burst(CHECK_MS);
+}
+
+static void schedule_check(void)
+{
+	s_check_timer = app_timer_register(s_check_ms, check_handler, NULL);
+	s_check_ms = s_check_ms * 2 < CHECK_MAX_MS ? s_check_ms * 2
+						   : CHECK_MAX_MS;
+}
+
+static void cooldown_handler(void *context)
+{
+	s_cooldown_timer = NULL;
+	if (!s_armed && !s_sampling && !s_paused) {
+		start_burst(CHECK_MS);
+	}
+}
+
+static void burst_timeout_handler(void *context)
+{
+	s_burst_timer = NULL;
+	end_burst();
+
+	// Not steadily in view by the end: the next raise is a flick again
+	if (s_in_view < s_config.confirm_samples) {
+		s_armed = true;
+	}
+	if (!s_armed) {
+		schedule_check();
+	}
+}
+
+static void burst_data_handler(AccelData *data, uint32_t num_samples)
+{
+	for (uint32_t i = 0; i < num_samples; i++) {
+		if (data[i].did_vibrate) {
+			s_in_view = 0;
+			continue;
+		}
+
+		if (!in_view(&data[i], 0)) {
+			// Only clearly out of view starts the count again, or
+			// out of view at all if it only counted while unarmed
+			if (!s_armed ||
+			    !in_view(&data[i], s_config.hysteresis)) {
+				s_in_view = 0;
+			}
+			s_armed = true;
+			continue;
+		}
+		// Counted while unarmed too, for burst_timeout_handler()
+		if (++s_in_view >= s_config.confirm_samples && s_armed) {
+			s_armed = false;
+			s_check_ms = s_config.cooldown_ms;
+			end_burst();
+			s_cooldown_timer = app_timer_register(
+				s_config.cooldown_ms, cooldown_handler, NULL);
+			// tools/trace_emu.py counts these in the emulator's log
+			APP_LOG(APP_LOG_LEVEL_DEBUG, "flick");
+			s_handler();
+			return;
+		}
+	}
+}
+
+static void tap_handler(AccelAxisType axis, int32_t direction)
+{
+	if (s_sampling || s_cooldown_timer) {
+		return;
+	}
+
+	start_burst(s_config.burst_ms);
+}
+
+void gesture_init(GestureHandler handler)
+{
+	s_handler = handler;
+	s_config = GESTURE_DEFAULT_CONFIG;
+	accel_tap_service_subscribe(tap_handler);
+}
+
+void gesture_deinit(void)
+{
+	end_burst();
+	cancel_check();
+	if (s_cooldown_timer) {
+		app_timer_cancel(s_cooldown_timer);
+		s_cooldown_timer = NULL;
+	}
+	accel_tap_service_unsubscribe();
+}
+
+void gesture_pause(void)
+{
+	s_paused = true;
+	end_burst();
+	cancel_check();
+	accel_tap_service_unsubscribe();
+}
+
+void gesture_resume(void)
+{
+	s_paused = false;
+	accel_tap_service_subscribe(tap_handler);
+	if (!s_armed && !s_cooldown_timer) {
+		s_check_ms = s_config.cooldown_ms;
+		start_burst(CHECK_MS);
+	}
+}
+
+void gesture_set_config(const GestureConfig *config)
+{
+	s_config = *config;
+}
+
+const GestureConfig *gesture_get_config(void)
+{
+	return &s_config;
+}
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <pebble.h>
+
+// Wrist-flick detection that leaves the app asleep while the wrist is still.
+// The accelerometer's own tap detection wakes the detector; only then does
+// it sample, for a short burst, to confirm the watch has been raised into
+// view. After a flick it also samples briefly, less and less often, until
+// it sees the watch lowered again.
+
+typedef void (*GestureHandler)(void);
+
+typedef struct {
+	// The watch is in view while every axis is within these bounds, in mG
+	int16_t x_min, x_max;
+	int16_t y_min, y_max;
+	int16_t z_min, z_max;
+	// Samples out of view by less than this pause the count of samples
+	// in view rather than restart it
+	int16_t hysteresis;
+	// Consecutive samples in view that confirm a flick
+	uint8_t confirm_samples;
+	// How long to sample after a tap before giving up
+	uint16_t burst_ms;
+	// Taps are ignored for this long after a flick
+	uint16_t cooldown_ms;
+} GestureConfig;
+
+// Tilted towards the wearer with the screen up, as in pebble_glancing_demo
+extern const GestureConfig GESTURE_DEFAULT_CONFIG;
+
+void gesture_init(GestureHandler handler);
+void gesture_deinit(void);
+
+// Stop listening for taps, ending any burst, until gesture_resume(): the
+// app is not woken by the accelerometer at all meanwhile
+void gesture_pause(void);
+void gesture_resume(void);
+
+// For tuning sensitivity; takes effect from the next tap
+void gesture_set_config(const GestureConfig *config);
+const GestureConfig *gesture_get_config(void);
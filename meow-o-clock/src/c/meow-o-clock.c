@@ -1,56 +1,72 @@
 #include <pebble.h>
 
+#include "gesture.h"
+#include "heap_trace.h"
+#include "profile.h"
+#include "status_bar.h"
+
+#ifdef PBL_BW
+#include "generated/kitten_frames.h"
+#endif
+
 static Window *s_window;
 static TextLayer *s_time_layer;
 static TextLayer *s_date_layer;
-static TextLayer *s_battery_layer;
-static GBitmap *s_battery_icon = NULL;
-static BitmapLayer *s_battery_icon_layer;
 static BitmapLayer *s_bitmap_layer;
 
 #ifdef PBL_BW
-// Frame-based animation for aplite
+// Frame-based animation for black and white platforms. Each animation is
+// a 1-bit keyframe and XOR deltas between consecutive frames (see
+// tools/kitten_frames.py), applied in place to the one bitmap allocated at
+// startup, so playing allocates nothing and reads only what changed.
 static GBitmap *s_bitmap = NULL;
+static uint8_t s_delta[KITTEN_DELTA_MAX_BYTES];
+// An empty child of the bitmap layer, moved over the pixels the last
+// deltas changed and marked dirty in place of the whole bitmap layer
+static Layer *s_changed_layer = NULL;
 static AppTimer *s_timer = NULL;
 static AppTimer *s_animation_stop_timer = NULL;
 static int s_current_frame = 0;
 static bool s_is_playing = true;
 static bool s_animation_active = false;
-static bool s_current_static_is_playing =
-	true; // Track which static frame is loaded
+// Which frame s_bitmap holds; -1 before the first load
+static bool s_shown_is_playing;
+static int s_shown_frame = -1;
 
-#define NUM_PLAY_FRAMES 11
-#define NUM_SLEEP_FRAMES 11
 #define FRAME_DELAY_MS 100
 #define ANIMATION_DURATION_MS 3000 // Play animation for 3 seconds
-
-static const uint32_t s_play_frames[NUM_PLAY_FRAMES] = {
-	RESOURCE_ID_KITTEN_PLAY_FRAME_0, RESOURCE_ID_KITTEN_PLAY_FRAME_1,
-	RESOURCE_ID_KITTEN_PLAY_FRAME_2, RESOURCE_ID_KITTEN_PLAY_FRAME_3,
-	RESOURCE_ID_KITTEN_PLAY_FRAME_4, RESOURCE_ID_KITTEN_PLAY_FRAME_5,
-	RESOURCE_ID_KITTEN_PLAY_FRAME_6, RESOURCE_ID_KITTEN_PLAY_FRAME_7,
-	RESOURCE_ID_KITTEN_PLAY_FRAME_8, RESOURCE_ID_KITTEN_PLAY_FRAME_9,
-	RESOURCE_ID_KITTEN_PLAY_FRAME_10};
-
-static const uint32_t s_sleep_frames[NUM_SLEEP_FRAMES] = {
-	RESOURCE_ID_KITTEN_SLEEP_FRAME_0, RESOURCE_ID_KITTEN_SLEEP_FRAME_1,
-	RESOURCE_ID_KITTEN_SLEEP_FRAME_2, RESOURCE_ID_KITTEN_SLEEP_FRAME_3,
-	RESOURCE_ID_KITTEN_SLEEP_FRAME_4, RESOURCE_ID_KITTEN_SLEEP_FRAME_5,
-	RESOURCE_ID_KITTEN_SLEEP_FRAME_6, RESOURCE_ID_KITTEN_SLEEP_FRAME_7,
-	RESOURCE_ID_KITTEN_SLEEP_FRAME_8, RESOURCE_ID_KITTEN_SLEEP_FRAME_9,
-	RESOURCE_ID_KITTEN_SLEEP_FRAME_10};
 #else
-// APNG-based animation for basalt
+// APNG-based animation for color platforms. One player owns the sequence
+// and its bitmap for the face's lifetime: frame 0 is the static pose and a
+// flick plays the loop from there.
+typedef enum {
+	PLAYER_IDLE,     // Resting on frame 0
+	PLAYER_PLAYING,  // Looping until the stop timer fires
+	PLAYER_STOPPING, // Finishing the current loop
+} PlayerState;
+
 static GBitmapSequence *s_sequence = NULL;
 static GBitmap *s_bitmap = NULL;
 static AppTimer *s_timer = NULL;
 static AppTimer *s_animation_stop_timer = NULL;
+static PlayerState s_player_state = PLAYER_IDLE;
+// The loaded sequence, and the one for the time of day, which replaces it
+// once the player is idle
 static uint32_t s_current_resource_id = 0;
-static bool s_animation_active = false;
+static uint32_t s_wanted_resource_id = 0;
 
 #define ANIMATION_DURATION_MS 3000 // Play animation for 3 seconds
 #endif
 
+// Where an animation of size sits: at the bottom of the display,
+// centred, as tools/assets.py lays out each platform's variant
+static GRect animation_frame(GSize size)
+{
+	GRect bounds = layer_get_bounds(window_get_root_layer(s_window));
+	return GRect((bounds.size.w - size.w) / 2, bounds.size.h - size.h,
+		     size.w, size.h);
+}
+
 static bool is_daytime(struct tm *tick_time)
 {
 	int hour = tick_time->tm_hour;
@@ -60,33 +76,121 @@ static bool is_daytime(struct tm *tick_time)
 
 static void timer_handler(void *context);
 static void stop_animation_handler(void *context);
-static void accel_data_handler(AccelData *data, uint32_t num_samples);
 static void load_static_frame(bool is_playing);
 
 #ifdef PBL_BW
-// Frame-based animation for aplite
-static void load_static_frame(bool is_playing)
+// Frame-based animation for black and white platforms
+static void load_keyframe(ResHandle handle)
 {
-	// Don't reload if already showing the correct static frame
-	if (s_current_static_is_playing == is_playing && s_bitmap != NULL) {
-		return;
+	uint8_t *data = gbitmap_get_data(s_bitmap);
+	uint16_t row_bytes = gbitmap_get_bytes_per_row(s_bitmap);
+
+	// One read when the bitmap's rows are laid out like the resource's
+	if (row_bytes == KITTEN_FRAME_ROW_BYTES) {
+		resource_load_byte_range(handle, 0, data, KITTEN_FRAME_BYTES);
+	} else {
+		for (int y = 0; y < KITTEN_FRAME_HEIGHT; y++) {
+			resource_load_byte_range(
+				handle, y * KITTEN_FRAME_ROW_BYTES,
+				data + y * row_bytes, KITTEN_FRAME_ROW_BYTES);
+		}
 	}
+}
 
-	// Destroy previous bitmap if exists
-	if (s_bitmap) {
-		gbitmap_destroy(s_bitmap);
+static void apply_delta(ResHandle handle, const uint16_t *offsets, int index)
+{
+	size_t size = offsets[index + 1] - offsets[index];
+	resource_load_byte_range(handle, offsets[index], s_delta, size);
+
+	// Dirty rectangle: rows y0..y1, byte columns b0..b1
+	int y0 = s_delta[0], y1 = s_delta[1], b0 = s_delta[2], b1 = s_delta[3];
+	const uint8_t *token = &s_delta[4];
+	uint8_t *data = gbitmap_get_data(s_bitmap);
+	uint16_t row_bytes = gbitmap_get_bytes_per_row(s_bitmap);
+
+	for (int y = y0; y <= y1; y++) {
+		uint8_t *p = data + y * row_bytes + b0;
+		uint8_t *end = data + y * row_bytes + b1 + 1;
+		while (p < end) {
+			int n = (*token & 0x7f) + 1;
+			if (*token++ & 0x80) {
+				p += n;
+				continue;
+			}
+			while (n--)
+				*p++ ^= *token++;
+		}
+	}
+}
+
+// The smallest rectangle holding both a and b, either of which may be empty
+static GRect rect_union(GRect a, GRect b)
+{
+	if (!a.size.w || !a.size.h) {
+		return b;
 	}
+	if (!b.size.w || !b.size.h) {
+		return a;
+	}
+	int x0 = a.origin.x < b.origin.x ? a.origin.x : b.origin.x;
+	int y0 = a.origin.y < b.origin.y ? a.origin.y : b.origin.y;
+	int x1 = a.origin.x + a.size.w > b.origin.x + b.size.w
+			 ? a.origin.x + a.size.w
+			 : b.origin.x + b.size.w;
+	int y1 = a.origin.y + a.size.h > b.origin.y + b.size.h
+			 ? a.origin.y + a.size.h
+			 : b.origin.y + b.size.h;
+	return GRect(x0, y0, x1 - x0, y1 - y0);
+}
 
-	// Load frame 0 of the appropriate animation
-	const uint32_t *frames = is_playing ? s_play_frames : s_sleep_frames;
-	s_bitmap = gbitmap_create_with_resource(frames[0]);
 
-	// Set the bitmap on the layer
-	bitmap_layer_set_bitmap(s_bitmap_layer, s_bitmap);
-	layer_mark_dirty(bitmap_layer_get_layer(s_bitmap_layer));
+static void load_frame(bool is_playing, int frame)
+{
+	if (!s_bitmap || !s_changed_layer ||
+	    (s_shown_is_playing == is_playing && s_shown_frame == frame)) {
+		return;
+	}
+
+	ResHandle handle = resource_get_handle(
+		is_playing ? RESOURCE_ID_KITTEN_PLAY_FRAMES
+			   : RESOURCE_ID_KITTEN_SLEEP_FRAMES);
+	const uint16_t *offsets = is_playing ? KITTEN_PLAY_DELTA_OFFSET
+					     : KITTEN_SLEEP_DELTA_OFFSET;
+	const GRect *rects =
+		is_playing ? KITTEN_PLAY_DELTA_RECT : KITTEN_SLEEP_DELTA_RECT;
+	int num_frames =
+		is_playing ? KITTEN_PLAY_FRAMES : KITTEN_SLEEP_FRAMES;
+
+	// Step forward through the deltas from the frame on screen, wrapping
+	// only from the last frame; otherwise start again from the keyframe
+	GRect changed = GRectZero;
+	if (s_shown_is_playing != is_playing || s_shown_frame < 0 ||
+	    (frame < s_shown_frame && s_shown_frame != num_frames - 1)) {
+		load_keyframe(handle);
+		s_shown_is_playing = is_playing;
+		s_shown_frame = 0;
+		changed = GRect(0, 0, KITTEN_FRAME_WIDTH, KITTEN_FRAME_HEIGHT);
+	}
+	while (s_shown_frame != frame) {
+		apply_delta(handle, offsets, s_shown_frame);
+		changed = rect_union(changed, rects[s_shown_frame]);
+		s_shown_frame = (s_shown_frame + 1) % num_frames;
+	}
+
+	// Only the pixels the deltas touched, from the generated rectangles
+	if (changed.size.w && changed.size.h) {
+		layer_set_frame(s_changed_layer, changed);
+		layer_mark_dirty(s_changed_layer);
+	}
+}
 
-	// Track which static frame is loaded
-	s_current_static_is_playing = is_playing;
+static void load_static_frame(bool is_playing)
+{
+	// The animation puts the static frame back when it stops
+	if (s_animation_active) {
+		return;
+	}
+	load_frame(is_playing, 0);
 }
 
 static void start_animation(bool is_playing)
@@ -115,6 +219,7 @@ static void start_animation(bool is_playing)
 
 static void stop_animation_handler(void *context)
 {
+	s_animation_stop_timer = NULL;
 	s_animation_active = false;
 
 	// Cancel animation timer
@@ -123,8 +228,11 @@ static void stop_animation_handler(void *context)
 		s_timer = NULL;
 	}
 
-	// Revert to static first frame
-	load_static_frame(s_is_playing);
+	// Back to frame 0 of the pose for the time of day, not of the
+	// animation: the hour may have turned while it played
+	s_current_frame = 0;
+	time_t temp = time(NULL);
+	load_frame(is_daytime(localtime(&temp)), 0);
 }
 
 static void timer_handler(void *context)
@@ -134,21 +242,10 @@ static void timer_handler(void *context)
 		return;
 	}
 
-	// Destroy previous bitmap
-	if (s_bitmap) {
-		gbitmap_destroy(s_bitmap);
-	}
-
-	// Get current frame's resource ID
-	const uint32_t *frames = s_is_playing ? s_play_frames : s_sleep_frames;
-	int num_frames = s_is_playing ? NUM_PLAY_FRAMES : NUM_SLEEP_FRAMES;
-
-	// Load current frame
-	s_bitmap = gbitmap_create_with_resource(frames[s_current_frame]);
+	int num_frames =
+		s_is_playing ? KITTEN_PLAY_FRAMES : KITTEN_SLEEP_FRAMES;
 
-	// Set the bitmap on the layer
-	bitmap_layer_set_bitmap(s_bitmap_layer, s_bitmap);
-	layer_mark_dirty(bitmap_layer_get_layer(s_bitmap_layer));
+	load_frame(s_is_playing, s_current_frame);
 
 	// Advance to next frame
 	s_current_frame = (s_current_frame + 1) % num_frames;
@@ -157,93 +254,93 @@ static void timer_handler(void *context)
 	s_timer = app_timer_register(FRAME_DELAY_MS, timer_handler, NULL);
 }
 
+// Stop where it is; the next load_static_frame() puts frame 0 back
+static void halt_animation(void)
+{
+	s_animation_active = false;
+	if (s_timer) {
+		app_timer_cancel(s_timer);
+		s_timer = NULL;
+	}
+	if (s_animation_stop_timer) {
+		app_timer_cancel(s_animation_stop_timer);
+		s_animation_stop_timer = NULL;
+	}
+}
+
 #else
 // APNG-based animation for color platforms
-static void load_static_frame(bool is_playing)
+
+// Back to frame 0 of the wanted animation. The sequence is only recreated
+// when the time of day has picked the other animation; otherwise it is
+// rewound, which keeps the parsed APNG and the decoder.
+static void player_rest(void)
 {
-	uint32_t resource_id = is_playing ? RESOURCE_ID_KITTEN_PLAY_TIME
-					  : RESOURCE_ID_KITTEN_SLEEPING;
+	s_player_state = PLAYER_IDLE;
 
-	// Don't reload if already loaded
-	if (s_current_resource_id == resource_id) {
-		return;
-	}
+	if (s_current_resource_id != s_wanted_resource_id) {
+		if (s_sequence) {
+			gbitmap_sequence_destroy(s_sequence);
+		}
+		uint32_t resource_id = s_wanted_resource_id;
+		s_sequence = gbitmap_sequence_create_with_resource(resource_id);
+		s_current_resource_id = s_sequence ? resource_id : 0;
+		if (!s_sequence) {
+			return;
+		}
 
-	// Clean up existing sequence and bitmap
-	if (s_sequence) {
-		gbitmap_sequence_destroy(s_sequence);
-		s_sequence = NULL;
-	}
-	if (s_bitmap) {
-		gbitmap_destroy(s_bitmap);
-		s_bitmap = NULL;
+		// Stop at the end of each loop so the player sees it
+		gbitmap_sequence_set_play_count(s_sequence, 1);
+
+		// Both animations of a platform are the same size, so one
+		// 8-bit bitmap serves them all; the APNG decoder outputs 8-bit
+		if (!s_bitmap) {
+			GSize size = gbitmap_sequence_get_bitmap_size(s_sequence);
+			s_bitmap = gbitmap_create_blank(size, GBitmapFormat8Bit);
+			bitmap_layer_set_bitmap(s_bitmap_layer, s_bitmap);
+			layer_set_frame(bitmap_layer_get_layer(s_bitmap_layer),
+					animation_frame(size));
+		}
+	} else {
+		gbitmap_sequence_restart(s_sequence);
 	}
 
-	// Load the sequence
-	s_sequence = gbitmap_sequence_create_with_resource(resource_id);
-	if (s_sequence) {
-		// Create blank bitmap with the correct size
-		GSize frame_size = gbitmap_sequence_get_bitmap_size(s_sequence);
-		s_bitmap = gbitmap_create_blank(frame_size, GBitmapFormat8Bit);
-
-		// Load first frame only (no animation)
-		gbitmap_sequence_update_bitmap_next_frame(s_sequence, s_bitmap,
-							  NULL);
-
-		// Set the bitmap on the layer
-		bitmap_layer_set_bitmap(s_bitmap_layer, s_bitmap);
+	if (s_bitmap &&
+	    gbitmap_sequence_update_bitmap_next_frame(s_sequence, s_bitmap,
+						      NULL)) {
 		layer_mark_dirty(bitmap_layer_get_layer(s_bitmap_layer));
-
-		s_current_resource_id = resource_id;
 	}
 }
 
-static void load_sequence(uint32_t resource_id)
+static void load_static_frame(bool is_playing)
 {
-	// Don't reload if already loaded
-	if (s_current_resource_id == resource_id) {
-		return;
-	}
+	s_wanted_resource_id = is_playing ? RESOURCE_ID_KITTEN_PLAY_TIME
+					  : RESOURCE_ID_KITTEN_SLEEPING;
 
-	// Clean up existing sequence and bitmap
-	if (s_sequence) {
-		gbitmap_sequence_destroy(s_sequence);
-		s_sequence = NULL;
-	}
-	if (s_bitmap) {
-		gbitmap_destroy(s_bitmap);
-		s_bitmap = NULL;
+	// A running animation picks up the change when it comes to rest
+	if (s_player_state == PLAYER_IDLE &&
+	    s_current_resource_id != s_wanted_resource_id) {
+		player_rest();
 	}
+}
 
-	// Cancel any pending timers
-	if (s_timer) {
-		app_timer_cancel(s_timer);
-		s_timer = NULL;
-	}
-	if (s_animation_stop_timer) {
-		app_timer_cancel(s_animation_stop_timer);
-		s_animation_stop_timer = NULL;
+static void start_animation(bool is_playing)
+{
+	load_static_frame(is_playing);
+	if (!s_sequence || !s_bitmap) {
+		return;
 	}
 
-	// Load the new sequence
-	s_sequence = gbitmap_sequence_create_with_resource(resource_id);
-	if (s_sequence) {
-		// Create blank bitmap with the correct size
-		GSize frame_size = gbitmap_sequence_get_bitmap_size(s_sequence);
-
-		// Always use 8-bit format - APNG decoder outputs 8-bit even for
-		// BW platforms
-		s_bitmap = gbitmap_create_blank(frame_size, GBitmapFormat8Bit);
-
-		// Set the bitmap on the layer
-		bitmap_layer_set_bitmap(s_bitmap_layer, s_bitmap);
-
-		// Start animation
-		s_current_resource_id = resource_id;
-		s_animation_active = true;
+	// Frame 0 is already on screen; carry on from frame 1
+	if (s_player_state == PLAYER_IDLE) {
 		s_timer = app_timer_register(0, timer_handler, NULL);
+	}
+	s_player_state = PLAYER_PLAYING;
 
-		// Schedule animation to stop after duration
+	// Every flick plays for the full duration from now
+	if (!s_animation_stop_timer ||
+	    !app_timer_reschedule(s_animation_stop_timer,
+				  ANIMATION_DURATION_MS)) {
 		s_animation_stop_timer = app_timer_register(
 			ANIMATION_DURATION_MS, stop_animation_handler, NULL);
 	}
@@ -251,46 +348,111 @@ static void load_sequence(uint32_t resource_id)
 
 static void stop_animation_handler(void *context)
 {
-	s_animation_active = false;
+	s_animation_stop_timer = NULL;
 
-	// Cancel animation timer
+	// Stopping mid-loop would jump back to frame 0; the last frame of the
+	// loop leads into it instead
+	s_player_state = PLAYER_STOPPING;
+}
+
+static void timer_handler(void *context)
+{
+	s_timer = NULL;
+
+	uint32_t next_delay;
+	if (!gbitmap_sequence_update_bitmap_next_frame(s_sequence, s_bitmap,
+						       &next_delay)) {
+		// The loop ended: come to rest, or go round again
+		if (s_player_state == PLAYER_STOPPING) {
+			player_rest();
+			return;
+		}
+		gbitmap_sequence_restart(s_sequence);
+		if (!gbitmap_sequence_update_bitmap_next_frame(
+			    s_sequence, s_bitmap, &next_delay)) {
+			player_rest();
+			return;
+		}
+	}
+
+	layer_mark_dirty(bitmap_layer_get_layer(s_bitmap_layer));
+	s_timer = app_timer_register(next_delay, timer_handler, NULL);
+}
+
+// Stop at once, back at rest on frame 0
+static void halt_animation(void)
+{
 	if (s_timer) {
 		app_timer_cancel(s_timer);
 		s_timer = NULL;
 	}
+	if (s_animation_stop_timer) {
+		app_timer_cancel(s_animation_stop_timer);
+		s_animation_stop_timer = NULL;
+	}
+	if (s_player_state != PLAYER_IDLE) {
+		player_rest();
+	}
+}
+#endif
 
-	// Revert to static first frame
-	time_t temp = time(NULL);
-	struct tm *tick_time = localtime(&temp);
-	bool is_playing = is_daytime(tick_time);
-	load_static_frame(is_playing);
+// Nobody watches while a notification covers the face, in Quiet Time or
+// while the wearer sleeps. The face is paused then: it neither animates
+// nor listens to the accelerometer, and only the minute tick wakes it.
+static bool s_in_focus = true;
+static bool s_paused = false;
+
+static bool nobody_watching(void)
+{
+	if (!s_in_focus || quiet_time_is_active()) {
+		return true;
+	}
+#if defined(PBL_HEALTH)
+	HealthActivityMask activities =
+		health_service_peek_current_activities();
+	if (activities & (HealthActivitySleep | HealthActivityRestfulSleep)) {
+		return true;
+	}
+#endif
+	return false;
 }
 
-static void timer_handler(void *context)
+static void update_paused(void)
 {
-	// Stop if animation is no longer active
-	if (!s_animation_active) {
+	bool paused = nobody_watching();
+	if (paused == s_paused) {
 		return;
 	}
+	s_paused = paused;
 
-	uint32_t next_delay;
+	if (paused) {
+		gesture_pause();
+		halt_animation();
+	} else {
+		// Visible again: the static frame for the time of day
+		time_t temp = time(NULL);
+		load_static_frame(is_daytime(localtime(&temp)));
+		gesture_resume();
+	}
+}
 
-	// Advance to the next APNG frame, and get the delay for this frame
-	if (gbitmap_sequence_update_bitmap_next_frame(s_sequence, s_bitmap,
-						      &next_delay)) {
-		// Set the new frame into the BitmapLayer
-		bitmap_layer_set_bitmap(s_bitmap_layer, s_bitmap);
-		layer_mark_dirty(bitmap_layer_get_layer(s_bitmap_layer));
+// Pause as soon as something starts to cover the face...
+static void will_focus_handler(bool in_focus)
+{
+	if (!in_focus) {
+		s_in_focus = false;
+		update_paused();
+	}
+}
 
-		// Timer for that frame's delay
-		s_timer = app_timer_register(next_delay, timer_handler, NULL);
-	} else {
-		// Sequence ended, restart from beginning
-		gbitmap_sequence_restart(s_sequence);
-		s_timer = app_timer_register(0, timer_handler, NULL);
+// ...and resume once it is uncovered
+static void did_focus_handler(bool in_focus)
+{
+	if (in_focus) {
+		s_in_focus = true;
+		update_paused();
 	}
 }
-#endif
 
 static void update_time()
 {
@@ -320,95 +482,17 @@ static void update_time()
 
 static void tick_handler(struct tm *tick_time, TimeUnits units_changed)
 {
+	// Quiet Time and sleep send no events of their own
+	update_paused();
 	update_time();
 }
 
-static void accel_data_handler(AccelData *data, uint32_t num_samples)
-{
-	static bool was_inactive = true;
-
-// Define active zone: watch tilted towards user with screen facing user
-// Based on pebble_glancing_demo zones
-#define ACTIVE_ZONE_X_MIN -500
-#define ACTIVE_ZONE_X_MAX 500
-#define ACTIVE_ZONE_Y_MIN -900
-#define ACTIVE_ZONE_Y_MAX 200
-#define ACTIVE_ZONE_Z_MIN -1100
-#define ACTIVE_ZONE_Z_MAX 0
-
-	// Check if any sample is in the active zone
-	bool in_active_zone = false;
-	for (uint32_t i = 0; i < num_samples; i++) {
-		if (data[i].x >= ACTIVE_ZONE_X_MIN &&
-		    data[i].x <= ACTIVE_ZONE_X_MAX &&
-		    data[i].y >= ACTIVE_ZONE_Y_MIN &&
-		    data[i].y <= ACTIVE_ZONE_Y_MAX &&
-		    data[i].z >= ACTIVE_ZONE_Z_MIN &&
-		    data[i].z <= ACTIVE_ZONE_Z_MAX) {
-			in_active_zone = true;
-			break;
-		}
-	}
-
-	// Trigger animation when transitioning from inactive to active (wrist
-	// flick)
-	if (in_active_zone && was_inactive) {
-		// Get current time to determine which animation to play
-		time_t temp = time(NULL);
-		struct tm *tick_time = localtime(&temp);
-
-		// Determine which animation to show based on time
-#ifdef PBL_BW
-		// Use frame-based animation for aplite
-		bool is_playing = is_daytime(tick_time);
-		start_animation(is_playing);
-#else
-		// Use APNG animation for basalt
-		uint32_t resource_id = is_daytime(tick_time)
-					       ? RESOURCE_ID_KITTEN_PLAY_TIME
-					       : RESOURCE_ID_KITTEN_SLEEPING;
-		load_sequence(resource_id);
-#endif
-	}
-
-	was_inactive = !in_active_zone;
-}
-
-static void battery_callback(BatteryChargeState state)
+static void flick_handler(void)
 {
-	// Write the battery percentage into a buffer
-	static char battery_buffer[16];
-	snprintf(battery_buffer, sizeof(battery_buffer), "%d%%",
-		 state.charge_percent);
-
-	// Display this on the battery layer
-	text_layer_set_text(s_battery_layer, battery_buffer);
-
-	// Destroy old battery icon if it exists
-	if (s_battery_icon) {
-		gbitmap_destroy(s_battery_icon);
-	}
-
-	// Load the appropriate battery icon based on state
-	if (state.is_charging) {
-		s_battery_icon = gbitmap_create_with_resource(
-			RESOURCE_ID_BATTERY_CHARGING);
-	} else if (state.charge_percent == 100) {
-		s_battery_icon =
-			gbitmap_create_with_resource(RESOURCE_ID_BATTERY_FULL);
-	} else if (state.charge_percent >= 60) {
-		s_battery_icon = gbitmap_create_with_resource(
-			RESOURCE_ID_BATTERY_HEALTHY);
-	} else if (state.charge_percent >= 40) {
-		s_battery_icon =
-			gbitmap_create_with_resource(RESOURCE_ID_BATTERY_HALF);
-	} else {
-		s_battery_icon =
-			gbitmap_create_with_resource(RESOURCE_ID_BATTERY_LOW);
-	}
-
-	// Update the battery icon layer
-	bitmap_layer_set_bitmap(s_battery_icon_layer, s_battery_icon);
+	// Play the animation for the time of day
+	time_t temp = time(NULL);
+	struct tm *tick_time = localtime(&temp);
+	start_animation(is_daytime(tick_time));
 }
 
 static void init()
@@ -421,16 +505,28 @@ static void init()
 	Layer *window_layer = window_get_root_layer(s_window);
 	GRect bounds = layer_get_bounds(window_layer);
 
-	// Create BitmapLayer for animation (full screen to match 144x168 APNG)
-	int image_width = 144;
-	int image_height = 168;
-	int image_x = 0;
-	int image_y = 0;
-	s_bitmap_layer = bitmap_layer_create(
-		GRect(image_x, image_y, image_width, image_height));
+	// Create BitmapLayer for animation, sized to it once it is loaded on
+	// colour platforms
+#ifdef PBL_BW
+	s_bitmap_layer = bitmap_layer_create(animation_frame(
+		GSize(KITTEN_FRAME_WIDTH, KITTEN_FRAME_HEIGHT)));
+#else
+	s_bitmap_layer = bitmap_layer_create(GRectZero);
+#endif
 	bitmap_layer_set_compositing_mode(s_bitmap_layer, GCompOpSet);
 	layer_add_child(window_layer, bitmap_layer_get_layer(s_bitmap_layer));
 
+#ifdef PBL_BW
+	// The only animation bitmap for the face's lifetime
+	s_bitmap = gbitmap_create_blank(
+		GSize(KITTEN_FRAME_WIDTH, KITTEN_FRAME_HEIGHT),
+		GBitmapFormat1Bit);
+	bitmap_layer_set_bitmap(s_bitmap_layer, s_bitmap);
+	s_changed_layer = layer_create(GRectZero);
+	layer_add_child(bitmap_layer_get_layer(s_bitmap_layer),
+			s_changed_layer);
+#endif
+
 	// Create time TextLayer (vertically centered with date)
 	s_time_layer = text_layer_create(GRect(0, 10, bounds.size.w, 50));
 	text_layer_set_background_color(s_time_layer, GColorClear);
@@ -450,55 +546,46 @@ static void init()
 	layer_add_child(window_layer, text_layer_get_layer(s_date_layer));
 
 	// Create battery TextLayer in top right corner with 3px padding from
-	// right edge Width is sized to fit "100%" exactly
+	// right edge Width is sized to fit "100%" exactly; round displays
+	// have no corner, so there it is centred with the icon
 	int battery_width = 30;
 	int battery_height = 20;
-	int battery_x = bounds.size.w - battery_width - 5;
+	int icon_size = 20;
+	int battery_x = PBL_IF_ROUND_ELSE(
+		(bounds.size.w + icon_size + 2 - battery_width) / 2,
+		bounds.size.w - battery_width - 5);
 	int battery_y = 0;
 
-	// Create battery icon layer to the left of the text with 2px gap
-	int icon_size = 20;
+	// Battery icon to the left of the text with 2px gap; the status bar
+	// keeps both up to date
 	int icon_x = battery_x - icon_size - 2;
 	int icon_y = 0;
-	s_battery_icon_layer = bitmap_layer_create(
-		GRect(icon_x, icon_y, icon_size, icon_size));
-	bitmap_layer_set_compositing_mode(s_battery_icon_layer, GCompOpSet);
-	layer_add_child(window_layer,
-			bitmap_layer_get_layer(s_battery_icon_layer));
-
-	s_battery_layer = text_layer_create(
-		GRect(battery_x, battery_y, battery_width, battery_height));
-	text_layer_set_background_color(s_battery_layer, GColorClear);
-	text_layer_set_text_color(s_battery_layer, GColorBlack);
-	text_layer_set_font(s_battery_layer,
-			    fonts_get_system_font(FONT_KEY_GOTHIC_14_BOLD));
-	text_layer_set_text_alignment(s_battery_layer, GTextAlignmentRight);
-	layer_add_child(window_layer, text_layer_get_layer(s_battery_layer));
+	status_bar_init(window_layer,
+			GRect(icon_x, icon_y, icon_size, icon_size),
+			GRect(battery_x, battery_y, battery_width,
+			      battery_height));
 
 	// Register with TickTimerService
 	tick_timer_service_subscribe(MINUTE_UNIT, tick_handler);
 
-	// Register for battery level updates
-	battery_state_service_subscribe(battery_callback);
-
-	// Register for accelerometer data to detect wrist flicks
-	// Sample at 25Hz (25 samples per second) with 25 samples per callback
-	accel_data_service_subscribe(25, accel_data_handler);
-	accel_service_set_sampling_rate(ACCEL_SAMPLING_25HZ);
+	// Detect wrist flicks; the accelerometer is only sampled after a tap
+	gesture_init(flick_handler);
+	app_focus_service_subscribe_handlers((AppFocusHandlers){
+		.will_focus = will_focus_handler,
+		.did_focus = did_focus_handler,
+	});
 
 	// Make sure the time is displayed from the start
 	update_time();
-
-	// Ensure battery level is displayed from the start
-	battery_callback(battery_state_service_peek());
+	update_paused();
 }
 
 static void deinit()
 {
 	// Unsubscribe from services
 	tick_timer_service_unsubscribe();
-	battery_state_service_unsubscribe();
-	accel_data_service_unsubscribe();
+	app_focus_service_unsubscribe();
+	gesture_deinit();
 
 	// Cancel timers
 	if (s_timer) {
@@ -511,15 +598,15 @@ static void deinit()
 	// Destroy layers
 	text_layer_destroy(s_time_layer);
 	text_layer_destroy(s_date_layer);
-	text_layer_destroy(s_battery_layer);
-	bitmap_layer_destroy(s_battery_icon_layer);
+	status_bar_deinit();
+#ifdef PBL_BW
+	if (s_changed_layer) {
+		layer_destroy(s_changed_layer);
+	}
+#endif
 	bitmap_layer_destroy(s_bitmap_layer);
 
 	// Destroy bitmaps and sequence
-	if (s_battery_icon) {
-		gbitmap_destroy(s_battery_icon);
-	}
-
 #ifdef PBL_BW
 	// Frame-based animation cleanup
 	if (s_bitmap) {
@@ -537,6 +624,8 @@ static void deinit()
 
 	// Destroy window
 	window_destroy(s_window);
+	profile_dump();
+	heap_trace_dump();
 }
 
 int main(void)
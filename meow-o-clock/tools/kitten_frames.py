@@ -0,0 +1,177 @@
+"""Pack each black and white kitten animation into one delta-encoded
+resource.
+
+Each frame PNG is reduced to black and white as tools/assets.py does
+every black and white variant, then converted to the layout of a 1-bit
+GBitmap on the watch: rows padded to a 32-bit word, least significant
+bit first, a set bit white. The resource holds frame 0 in that layout as a keyframe, then
+one delta per step of the loop, the last one leading back to frame 0.
+
+A delta starts with its dirty rectangle in bytes: first row, last row,
+first byte column, last byte column, one byte each. Then, for every row
+of the rectangle, the XOR of the two frames over its columns as RLE
+tokens that exactly cover the row:
+
+  0x80 | (n - 1)        skip n unchanged bytes
+  n - 1, then n bytes   XOR these n bytes into the frame
+
+An unchanged frame is a rectangle with first row > last row and no
+tokens. The generated header gives the keyframe size and each delta's
+offset, so the face loads a delta with one resource_load_byte_range()
+into a buffer of KITTEN_DELTA_MAX_BYTES. It also gives each delta's
+rectangle in pixels, empty for an unchanged frame, which the face marks
+dirty without reading the delta.
+"""
+
+import os
+import re
+
+import assets
+import genutil
+import pngio
+
+
+def _row_bytes(width):
+    return (width + 31) // 32 * 4
+
+
+def pack_frame(path):
+    """Return (width, height, raw 1-bit frame) for the PNG at path."""
+    with open(path, 'rb') as f:
+        width, height, pixels = pngio.decode(f.read())
+    palette, indices = assets.dither_bw(width, pixels)
+    white = palette.index((255, 255, 255, 255))
+    stride = _row_bytes(width)
+    out = bytearray(stride * height)
+    for y in range(height):
+        for x in range(width):
+            # Clear pixels come out black, as in the SDK's 1-bit format
+            if indices[y * width + x] == white:
+                out[y * stride + x // 8] |= 1 << (x % 8)
+    return width, height, bytes(out)
+
+
+def _rle_row(xor):
+    out = bytearray()
+    i = 0
+    while i < len(xor):
+        j = i
+        if xor[i] == 0:
+            while j < len(xor) and xor[j] == 0 and j - i < 128:
+                j += 1
+            out.append(0x80 | (j - i - 1))
+        else:
+            # A lone unchanged byte between changes is cheaper inline
+            while j < len(xor) and j - i < 128 and (
+                    xor[j] or (j + 1 < len(xor) and xor[j + 1])):
+                j += 1
+            out.append(j - i - 1)
+            out += xor[i:j]
+        i = j
+    return out
+
+
+def delta_rect(delta, width):
+    """(x, y, w, h) of the pixels delta may change, clipped to width."""
+    y0, y1, b0, b1 = delta[:4]
+    if y0 > y1:
+        return (0, 0, 0, 0)
+    x0 = b0 * 8
+    return (x0, y0, min((b1 + 1) * 8, width) - x0, y1 - y0 + 1)
+
+
+def encode_delta(prev, frame, stride, height):
+    """Delta turning frame prev into frame, both in the 1-bit layout."""
+    xor = bytes(a ^ b for a, b in zip(prev, frame))
+    rows = [y for y in range(height) if any(xor[y * stride:(y + 1) * stride])]
+    if not rows:
+        return bytes([1, 0, 0, 0])
+    cols = [x for x in range(stride)
+            if any(xor[y * stride + x] for y in rows)]
+    y0, y1, b0, b1 = rows[0], rows[-1], cols[0], cols[-1]
+    out = bytearray([y0, y1, b0, b1])
+    for y in range(y0, y1 + 1):
+        out += _rle_row(xor[y * stride + b0:y * stride + b1 + 1])
+    return bytes(out)
+
+
+def frame_paths(directory, prefix):
+    """prefix-frame-N.png in directory, in frame order."""
+    pattern = re.compile(re.escape(prefix) + r'-frame-(\d+)\.png$')
+    frames = {}
+    for name in os.listdir(directory):
+        m = pattern.match(name)
+        if m:
+            frames[int(m.group(1))] = os.path.join(directory, name)
+    return [frames[i] for i in sorted(frames)]
+
+
+def generate(out_dir, header_path, animations):
+    """Write out_dir/kitten-NAME.bin for each (NAME, frame paths) in
+    animations, and the header describing them."""
+    size = None
+    max_delta = 0
+    lines = [
+        '// Generated by tools/kitten_frames.py from wscript. Do not edit.',
+        '#pragma once',
+        '',
+        '#include <pebble.h>',
+        '',
+    ]
+    for name, paths in animations:
+        frames = []
+        for path in paths:
+            width, height, frame = pack_frame(path)
+            if size not in (None, (width, height)):
+                raise ValueError('%s is %dx%d, expected %dx%d' %
+                                 ((path, width, height) + size))
+            size = (width, height)
+            frames.append(frame)
+
+        stride = _row_bytes(width)
+        data = bytearray(frames[0])
+        offsets = []
+        rects = []
+        for i in range(len(frames)):
+            delta = encode_delta(frames[i], frames[(i + 1) % len(frames)],
+                                 stride, height)
+            offsets.append(len(data))
+            rects.append(delta_rect(delta, width))
+            max_delta = max(max_delta, len(delta))
+            data += delta
+        offsets.append(len(data))
+        genutil.write_if_changed(
+            os.path.join(out_dir, 'kitten-%s.bin' % name), bytes(data))
+
+        macro = 'KITTEN_%s' % name.upper()
+        lines += [
+            '#define %s_FRAMES %d' % (macro, len(frames)),
+            '// Delta i leads from frame i to frame i + 1, wrapping; it '
+            'ends where',
+            '// delta i + 1 starts',
+            'static const uint16_t %s_DELTA_OFFSET[%s_FRAMES + 1] = {' %
+            (macro, macro),
+        ]
+        for i in range(0, len(offsets), 8):
+            lines.append('\t%s,' % ', '.join(str(o)
+                                              for o in offsets[i:i + 8]))
+        lines += [
+            '};',
+            '// The pixels delta i changes',
+            'static const GRect %s_DELTA_RECT[%s_FRAMES] = {' %
+            (macro, macro),
+        ]
+        lines.extend('\t{{%d, %d}, {%d, %d}},' % rect for rect in rects)
+        lines += ['};', '']
+
+    width, height = size
+    lines += [
+        '#define KITTEN_FRAME_WIDTH %d' % width,
+        '#define KITTEN_FRAME_HEIGHT %d' % height,
+        '#define KITTEN_FRAME_ROW_BYTES %d' % _row_bytes(width),
+        '#define KITTEN_FRAME_BYTES (KITTEN_FRAME_ROW_BYTES * '
+        'KITTEN_FRAME_HEIGHT)',
+        '#define KITTEN_DELTA_MAX_BYTES %d' % max_delta,
+        '',
+    ]
+    genutil.write_if_changed(header_path, '\n'.join(lines).encode())
@@ -0,0 +1,23 @@
+#pragma once
+
+#include <pebble.h>
+
+// Illuminated fraction of the disc is reported in thousandths
+#define LUNAR_ILLUMINATION_MAX 1000
+
+typedef struct {
+	// Sun-moon elongation in TRIG_MAX_ANGLE units: 0 is new moon,
+	// TRIG_MAX_ANGLE / 2 is full moon, increasing while waxing.
+	int32_t phase_angle;
+	// 0 (new) to LUNAR_ILLUMINATION_MAX (full)
+	int32_t illumination;
+	time_t next_new_moon;
+	time_t next_full_moon;
+} LunarPhase;
+
+// Phase of the moon at UTC time t. Integer-only.
+void lunar_phase_at(time_t t, LunarPhase *out);
+
+// Phase at local noon on the date of *local, where now is the current UTC
+// time. Memoized: only recomputed when the date changes.
+const LunarPhase *lunar_phase_for_date(time_t now, const struct tm *local);
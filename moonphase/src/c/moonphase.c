@@ -1,88 +1,127 @@
 #include <pebble.h>
 
+#include "generated/dial_geometry.h"
+#include "heap_trace.h"
+#include "profile.h"
+#include "lunar.h"
+#include "raster.h"
+
 // Rectangular Pebble (basalt/aplite): 144x168. Chalk (round): 180x180.
 #define CLOCK_CX PBL_IF_ROUND_ELSE(90, 72)
 #define CLOCK_CY PBL_IF_ROUND_ELSE(90, 84)
 #define NUMERAL_R PBL_IF_ROUND_ELSE(74, 52)
 #define MOON_OFFSET_Y 46
+// Must match MOON_RADIUS in wscript, which bakes the phase sprites
 #define MOON_RADIUS 13
+#define MOON_SPRITE_SIZE (2 * MOON_RADIUS + 1)
+#define MOON_PHASES 30
+// DAY|DATE on one line, vertically centred at the 3 o'clock marker
+#define DATE_RECT                                                              \
+	PBL_IF_ROUND_ELSE(GRect(116, CLOCK_CY - 7, 40, 14),                    \
+			  GRect(84, CLOCK_CY - 7, 36, 14))
+
+#if CLOCK_CX != GEOMETRY_CLOCK_CX || CLOCK_CY != GEOMETRY_CLOCK_CY ||          \
+	NUMERAL_R != GEOMETRY_NUMERAL_R ||                                     \
+	MOON_OFFSET_Y != GEOMETRY_MOON_OFFSET_Y ||                             \
+	MOON_RADIUS != GEOMETRY_MOON_RADIUS
+#error "Dial geometry in wscript is out of sync with moonphase.c"
+#endif
 
-// Marker style: 0 = numbers, 1 = roman numerals, 2 = ticks
-#define MARKER_STYLE 0
+// Settings chosen on the phone (src/pkjs) and kept in persistent storage.
+// The defaults are the face as it looked before it had settings.
+typedef enum {
+	MARKERS_NUMBERS,
+	MARKERS_ROMAN,
+	MARKERS_TICKS,
+	NUM_MARKER_STYLES,
+} MarkerStyle;
+
+typedef struct {
+	uint8_t marker_style;
+	// Day runs from day_start:00 until day_end:00, night the rest
+	uint8_t day_start;
+	uint8_t day_end;
+	// Seconds hand: 0 = never, 1 = shown when the face appears or the
+	// wrist is flicked, and hidden again after seconds_timeout seconds
+	// without a flick
+	uint8_t seconds_hand;
+	uint8_t seconds_timeout;
+} Settings;
+
+static const Settings DEFAULT_SETTINGS = {
+	.marker_style = MARKERS_NUMBERS,
+	.day_start = 6,
+	.day_end = 20,
+	.seconds_hand = 0,
+	.seconds_timeout = 60,
+};
 
-#define DAY_START 6
-#define DAY_END 20
+#define SETTINGS_PERSIST_KEY 1
+#define SECONDS_TIMEOUT_MIN 10
+#define SECONDS_TIMEOUT_MAX 240
+
+// Battery governor: the face steps down a refresh tier when the charge falls
+// to the _ENTER level and only steps back up once it reaches _LEAVE, or as
+// soon as the watch is plugged in
+#define TIER_REDUCED_ENTER 30
+#define TIER_REDUCED_LEAVE 40
+#define TIER_CRITICAL_ENTER 10
+#define TIER_CRITICAL_LEAVE 20
+
+// Full: stars twinkle every second. Reduced: minute ticks and still stars.
+// Critical: minute ticks, and no clouds, sun rays or stars.
+typedef enum {
+	TIER_FULL,
+	TIER_REDUCED,
+	TIER_CRITICAL,
+} RefreshTier;
 
 static Window *s_window;
 static Layer *s_sky_layer, *s_subdial_layer, *s_markers_layer, *s_hands_layer;
-static GPath *s_minute_arrow, *s_hour_arrow;
+// All phases stacked vertically, and a window onto the current one
+static GBitmap *s_moon_phases, *s_moon_sprite;
 
-static const GPathInfo MINUTE_HAND_POINTS = {
-	.num_points = 3, .points = (GPoint[]){{-4, 12}, {4, 12}, {0, -62}}};
+static Settings s_settings;
 
-static const GPathInfo HOUR_HAND_POINTS = {
-	.num_points = 3, .points = (GPoint[]){{-5, 12}, {5, 12}, {0, -40}}};
+// One time snapshot per tick; every update proc reads from here instead of
+// calling time()/localtime() itself.
+static struct tm s_now;
+static bool s_is_day;
 
-static bool is_daytime(struct tm *t)
-{
-	return t->tm_hour >= DAY_START && t->tm_hour < DAY_END;
-}
+// Derived once per day rather than on every redraw
+static const LunarPhase *s_moon;
+static char s_date_str[10];
 
-// ---- Moon phase ----
+static RefreshTier s_tier;
+static bool s_seconds_visible;
+static AppTimer *s_seconds_idle_timer;
+// Stars covered by the hour and minute hands, one bit per star
+static uint32_t s_stars_hidden;
+// Set by the bottom layer when this frame came out of the cache
+static bool s_frame_from_cache;
 
-static int isqrt(int n)
+static bool is_daytime(struct tm *t)
 {
-	int x = 1;
-	while (x * x <= n)
-		x++;
-	return x - 1;
+	return t->tm_hour >= s_settings.day_start &&
+	       t->tm_hour < s_settings.day_end;
 }
 
-static int get_moon_age(struct tm *t)
-{
-	int year = t->tm_year + 1900;
-	int month = t->tm_mon + 1;
-	int day = t->tm_mday;
-	int a = (14 - month) / 12;
-	int y = year + 4800 - a;
-	int m = month + 12 * a - 3;
-	long jdn = (long)day + (153 * m + 2) / 5 + 365L * y + y / 4 - y / 100 +
-		   y / 400 - 32045;
-	long days = jdn - 2451550L;
-	long h = (days * 100L) % 2953L;
-	if (h < 0)
-		h += 2953L;
-	return (int)(h / 100);
-}
+// ---- Moon phase ----
 
-static void draw_moon(GContext *ctx, GPoint center, int r, int moon_age)
+static void draw_moon(GContext *ctx, GPoint center, int r, int32_t phase_angle)
 {
-	int32_t phase_angle = (int32_t)(moon_age * 100) * TRIG_MAX_ANGLE / 2953;
-	int32_t cos_phase = cos_lookup(phase_angle);
-
-	graphics_context_set_fill_color(
-		ctx, PBL_IF_COLOR_ELSE(GColorOxfordBlue, GColorBlack));
-	graphics_fill_circle(ctx, center, r);
-	graphics_context_set_stroke_color(
-		ctx, PBL_IF_COLOR_ELSE(GColorPastelYellow, GColorWhite));
-
-	bool waxing = (moon_age < 15);
-
-	for (int dy = -(r - 1); dy <= (r - 1); dy++) {
-		int cw = isqrt(r * r - dy * dy);
-		if (cw == 0)
-			continue;
-		int tx = (int)((int32_t)cw * cos_phase / TRIG_MAX_RATIO);
-		GPoint p1, p2;
-		if (waxing) {
-			p1 = GPoint(center.x + tx, center.y + dy);
-			p2 = GPoint(center.x + cw, center.y + dy);
-		} else {
-			p1 = GPoint(center.x - cw, center.y + dy);
-			p2 = GPoint(center.x - tx, center.y + dy);
-		}
-		if (p1.x <= p2.x)
-			graphics_draw_line(ctx, p1, p2);
+	// Disc and terminator are baked at build time for MOON_PHASES evenly
+	// spaced angles; the outline is stroked here so it keeps the platform's
+	// antialiasing
+	if (s_moon_sprite) {
+		int frame = (phase_angle * MOON_PHASES + TRIG_MAX_ANGLE / 2) /
+			    TRIG_MAX_ANGLE % MOON_PHASES;
+		gbitmap_set_bounds(s_moon_sprite,
+				   GRect(0, frame * MOON_SPRITE_SIZE,
+					 MOON_SPRITE_SIZE, MOON_SPRITE_SIZE));
+		graphics_draw_bitmap_in_rect(ctx, s_moon_sprite,
+					     GRect(center.x - r, center.y - r,
+						   2 * r + 1, 2 * r + 1));
 	}
 
 	graphics_context_set_stroke_color(
@@ -90,33 +129,32 @@ static void draw_moon(GContext *ctx, GPoint center, int r, int moon_age)
 	graphics_draw_circle(ctx, center, r);
 }
 
-static void draw_sun(GContext *ctx, GPoint center, int r)
+static void draw_sun(GContext *ctx, GPoint center)
 {
 	GColor sun_color = PBL_IF_COLOR_ELSE(GColorChromeYellow, GColorBlack);
 
+#ifdef PBL_COLOR
+	// Drawn through the GContext so the edges keep the platform's
+	// antialiasing
 	graphics_context_set_fill_color(ctx, sun_color);
-	graphics_fill_circle(ctx, center, r);
-
+	graphics_fill_circle(ctx, center, MOON_RADIUS);
 	graphics_context_set_stroke_color(ctx, sun_color);
-	graphics_draw_circle(ctx, center, r);
-
-	// 8 rays
-	for (int i = 0; i < 8; i++) {
-		int32_t angle = TRIG_MAX_ANGLE * i / 8;
-		GPoint p1 = {.x = (int16_t)(sin_lookup(angle) * (r + 3) /
-					    TRIG_MAX_RATIO) +
-				  center.x,
-			     .y = (int16_t)(-cos_lookup(angle) * (r + 3) /
-					    TRIG_MAX_RATIO) +
-				  center.y};
-		GPoint p2 = {.x = (int16_t)(sin_lookup(angle) * (r + 8) /
-					    TRIG_MAX_RATIO) +
-				  center.x,
-			     .y = (int16_t)(-cos_lookup(angle) * (r + 8) /
-					    TRIG_MAX_RATIO) +
-				  center.y};
-		graphics_draw_line(ctx, p1, p2);
-	}
+	graphics_draw_circle(ctx, center, MOON_RADIUS);
+	if (s_tier == TIER_CRITICAL)
+		return;
+	// Ray endpoints are generated for the sun's fixed position
+	for (int i = 0; i < SUN_RAY_COUNT; i++)
+		graphics_draw_line(ctx, SUN_RAY[i][0], SUN_RAY[i][1]);
+#else
+	// Disc, outline and rays are generated as spans for MOON_RADIUS
+	Raster raster;
+
+	raster_begin(&raster, ctx);
+	raster_fill(&raster, &SUN_DISC, center, sun_color);
+	if (s_tier != TIER_CRITICAL)
+		raster_fill(&raster, &SUN_RAYS, center, sun_color);
+	raster_end(&raster);
+#endif
 }
 
 // ---- Stars ----
@@ -141,15 +179,47 @@ static const uint8_t STAR_TWINKLE[NUM_STARS] = {
 	11, 14, 0, 4, 8,  12, 2, 6, 10, 1,  9, 5,
 };
 
-// ---- Layer callbacks ----
+// ---- Dial ----
 
-static void sky_update_proc(Layer *layer, GContext *ctx)
+#ifdef PBL_BW
+// The colour sky's bands as ordered dither, with white clouds, written
+// straight into the frame buffer a 32-pixel word at a time
+static bool draw_sky_dithered(GContext *ctx, GRect bounds, bool clouds)
 {
-	GRect bounds = layer_get_bounds(layer);
+	GBitmap *fb = graphics_capture_frame_buffer(ctx);
+	if (!fb)
+		return false;
+
+	uint8_t *data = gbitmap_get_data(fb);
+	uint16_t stride = gbitmap_get_bytes_per_row(fb);
+	int h = gbitmap_get_bounds(fb).size.h;
+	if (bounds.size.h < h)
+		h = bounds.size.h;
+	int bh = h / 4;
+
+	for (int y = 0; y < h; y++) {
+		int band = y / bh < 3 ? y / bh : 3;
+		uint32_t sky = SKY_DITHER[band][y % 4];
+		uint32_t *row = (uint32_t *)(data + y * stride);
+		int cloud = clouds ? y - CLOUD_FIRST_ROW : -1;
+		if (cloud >= 0 && cloud < CLOUD_ROWS) {
+			const uint32_t *mask = CLOUD_MASK[cloud];
+			for (int w = 0; w < SKY_FB_WORDS; w++)
+				row[w] = sky | mask[w];
+		} else {
+			for (int w = 0; w < SKY_FB_WORDS; w++)
+				row[w] = sky;
+		}
+	}
 
-	time_t now = time(NULL);
-	struct tm *t = localtime(&now);
-	bool day = is_daytime(t);
+	graphics_release_frame_buffer(ctx, fb);
+	return true;
+}
+#endif
+
+static void draw_sky(GContext *ctx, GRect bounds)
+{
+	bool day = s_is_day;
 
 #ifdef PBL_COLOR
 	if (day) {
@@ -167,163 +237,365 @@ static void sky_update_proc(Layer *layer, GContext *ctx)
 					   GRect(0, i * bh, bounds.size.w, h),
 					   0, GCornerNone);
 		}
+		if (s_tier == TIER_CRITICAL)
+			return;
 		graphics_context_set_fill_color(ctx, GColorWhite);
-		// Cloud A — top left
-		graphics_fill_circle(ctx, GPoint(20, 24), 7);
-		graphics_fill_circle(ctx, GPoint(11, 28), 5);
-		graphics_fill_circle(ctx, GPoint(29, 28), 5);
-		graphics_fill_circle(ctx, GPoint(22, 18), 5);
-		// Cloud B — top right
-		graphics_fill_circle(ctx, GPoint(116, 16), 8);
-		graphics_fill_circle(ctx, GPoint(106, 21), 6);
-		graphics_fill_circle(ctx, GPoint(126, 21), 6);
-		graphics_fill_circle(ctx, GPoint(118, 9), 5);
-		// Cloud C — right edge, mid-upper
-		graphics_fill_circle(ctx, GPoint(134, 50), 5);
-		graphics_fill_circle(ctx, GPoint(127, 54), 4);
-		graphics_fill_circle(ctx, GPoint(140, 54), 4);
-	} else {
-		graphics_context_set_fill_color(ctx, GColorBlack);
-		graphics_fill_rect(ctx, bounds, 0, GCornerNone);
+		for (int i = 0; i < CLOUD_PUFFS; i++)
+			graphics_fill_circle(ctx, CLOUD_PUFF_CENTER[i],
+					     CLOUD_PUFF_RADIUS[i]);
+		return;
 	}
 #else
+	if (day && draw_sky_dithered(ctx, bounds, s_tier != TIER_CRITICAL))
+		return;
+#endif
 	graphics_context_set_fill_color(ctx, day ? GColorWhite : GColorBlack);
 	graphics_fill_rect(ctx, bounds, 0, GCornerNone);
+}
+
+#ifdef PBL_COLOR
+// Whether star i, with its antialiased fringe, reaches into the date box
+static bool star_meets_date(int i)
+{
+	GRect date = DATE_RECT;
+	GPoint p = STAR_POSITIONS[i];
+	int r = STAR_RADIUS[i] + 1;
+	return p.x + r >= date.origin.x &&
+	       p.x - r < date.origin.x + date.size.w &&
+	       p.y + r >= date.origin.y && p.y - r < date.origin.y + date.size.h;
+}
 #endif
 
-	if (!day) {
-		graphics_context_set_fill_color(ctx, GColorWhite);
-		for (int i = 0; i < NUM_STARS; i++) {
-			if ((t->tm_sec % 15) == STAR_TWINKLE[i])
-				continue;
+static void draw_stars(GContext *ctx, uint32_t hidden)
+{
+	if (s_tier == TIER_CRITICAL)
+		return;
+
+	// Without second ticks a twinkle would hold for a whole minute
+	bool twinkle = s_tier == TIER_FULL;
+	uint32_t shown = 0;
+	for (int i = 0; i < NUM_STARS; i++)
+		if (!(twinkle && (s_now.tm_sec % 15) == STAR_TWINKLE[i]) &&
+		    !(hidden & (1u << i)))
+			shown |= 1u << i;
+
+#ifdef PBL_COLOR
+	// Stars clear of the date box keep the platform's antialiasing. The
+	// rest go through the raster below, which can clip them to the box.
+	graphics_context_set_fill_color(ctx, GColorWhite);
+	for (int i = 0; i < NUM_STARS; i++) {
+		if ((shown & (1u << i)) && !star_meets_date(i)) {
 			graphics_fill_circle(ctx, STAR_POSITIONS[i],
 					     STAR_RADIUS[i]);
+			shown &= ~(1u << i);
 		}
 	}
+	if (!shown)
+		return;
+#endif
+
+	Raster raster;
+
+	raster_begin(&raster, ctx);
+	// Drawn over the cached date box, which has to hide them as it did
+	// when it was drawn on top
+	raster_set_hole(&raster, DATE_RECT);
+	for (int i = 0; i < NUM_STARS; i++)
+		if (shown & (1u << i))
+			raster_fill(&raster, &STAR_SHAPE[STAR_RADIUS[i]],
+				    STAR_POSITIONS[i], GColorWhite);
+	raster_end(&raster);
 }
 
-static void markers_update_proc(Layer *layer, GContext *ctx)
-{
-	GPoint center = GPoint(CLOCK_CX, CLOCK_CY);
+// ---- Hour markers ----
+//
+// One renderer per marker style. settings_bind() picks one whenever the
+// settings change, so drawing a frame never asks which style is on. Each
+// skips the hour the sun (12 o'clock by day) or the moon (6 o'clock at
+// night) sits at.
 
-	time_t now = time(NULL);
-	struct tm *t = localtime(&now);
-	bool day = is_daytime(t);
+typedef void (*MarkerRenderer)(GContext *ctx, bool day, GColor fg);
 
-	GColor bg = day ? GColorWhite : GColorBlack;
-	GColor fg = day ? GColorBlack : GColorWhite;
+static MarkerRenderer s_draw_hour_markers;
 
-	// Hour markers (skip 6 o'clock — subdial)
-#if MARKER_STYLE == 2
-	graphics_context_set_stroke_color(ctx, fg);
-	for (int i = 1; i <= 12; i++) {
-		if (day && i == 12)
-			continue;
-		if (!day && i == 6)
-			continue;
-		int32_t angle = TRIG_MAX_ANGLE * i / 12;
-		GPoint outer = {.x = (int16_t)(sin_lookup(angle) * 62 /
-					       TRIG_MAX_RATIO) +
-				     center.x,
-				.y = (int16_t)(-cos_lookup(angle) * 62 /
-					       TRIG_MAX_RATIO) +
-				     center.y};
-		GPoint inner_pt = {.x = (int16_t)(sin_lookup(angle) * 55 /
-						  TRIG_MAX_RATIO) +
-					center.x,
-				   .y = (int16_t)(-cos_lookup(angle) * 55 /
-						  TRIG_MAX_RATIO) +
-					center.y};
-		graphics_draw_line(ctx, inner_pt, outer);
-	}
-#else
-	static const char *const LABELS[2][13] = {
-		{"", "1", "2", "3", "4", "5", "6", "7", "8", "9", "10", "11",
-		 "12"},
-		{"", "I", "II", "III", "IV", "V", "VI", "VII", "VIII", "IX",
-		 "X", "XI", "XII"},
-	};
-	const char *const *label = LABELS[MARKER_STYLE == 1 ? 1 : 0];
+static const char *const NUMBER_LABELS[13] = {
+	"", "1", "2", "3", "4", "5", "6", "7", "8", "9", "10", "11", "12",
+};
+
+static const char *const ROMAN_LABELS[13] = {
+	"", "I", "II", "III", "IV", "V", "VI", "VII", "VIII", "IX", "X", "XI",
+	"XII",
+};
+
+static void draw_label_markers(GContext *ctx, bool day, GColor fg,
+			       const char *const *label)
+{
 	GFont font = fonts_get_system_font(FONT_KEY_GOTHIC_18_BOLD);
 	graphics_context_set_text_color(ctx, fg);
 	for (int i = 1; i <= 12; i++) {
-		// Day: sun tracks through 12 o'clock, moon sits at 6 o'clock at
-		// night
-		if (day && i == 12)
+		if ((day && i == 12) || (!day && i == 6))
 			continue;
-		if (!day && i == 6)
+		GPoint anchor = MARKER_ANCHOR[i];
+		graphics_draw_text(ctx, label[i], font,
+				   GRect(anchor.x - 18, anchor.y - 11, 36, 22),
+				   GTextOverflowModeWordWrap,
+				   GTextAlignmentCenter, NULL);
+	}
+}
+
+static void draw_number_markers(GContext *ctx, bool day, GColor fg)
+{
+	draw_label_markers(ctx, day, fg, NUMBER_LABELS);
+}
+
+static void draw_roman_markers(GContext *ctx, bool day, GColor fg)
+{
+	draw_label_markers(ctx, day, fg, ROMAN_LABELS);
+}
+
+static void draw_tick_markers(GContext *ctx, bool day, GColor fg)
+{
+	graphics_context_set_stroke_color(ctx, fg);
+	for (int i = 1; i <= 12; i++) {
+		if ((day && i == 12) || (!day && i == 6))
 			continue;
-		int32_t angle = TRIG_MAX_ANGLE * i / 12;
-		int32_t sin_a = sin_lookup(angle);
-		int32_t cos_a = cos_lookup(angle);
-		int16_t cx, cy;
-#ifdef PBL_ROUND
-		cx = (int16_t)(sin_a * NUMERAL_R / TRIG_MAX_RATIO) + center.x;
-		cy = (int16_t)(-cos_a * NUMERAL_R / TRIG_MAX_RATIO) + center.y;
-#else
-		int32_t abs_sin = sin_a < 0 ? -sin_a : sin_a;
-		int32_t abs_cos = cos_a < 0 ? -cos_a : cos_a;
-		if (abs_sin == 0) {
-			cx = center.x;
-			cy = (int16_t)(center.y + (cos_a > 0 ? -62 : 62));
-		} else if (abs_cos == 0) {
-			cx = (int16_t)(center.x + (sin_a > 0 ? 52 : -52));
-			cy = center.y;
-		} else if (52 * abs_cos <= 62 * abs_sin) {
-			cx = (int16_t)(center.x + (sin_a > 0 ? 52 : -52));
-			cy = (int16_t)(center.y - cos_a * 52 / abs_sin);
-		} else {
-			cy = (int16_t)(center.y + (cos_a > 0 ? -62 : 62));
-			cx = (int16_t)(center.x + sin_a * 62 / abs_cos);
-		}
-#endif
-		graphics_draw_text(
-			ctx, label[i], font, GRect(cx - 18, cy - 11, 36, 22),
-			GTextOverflowModeWordWrap, GTextAlignmentCenter, NULL);
+		graphics_draw_line(ctx, MARKER_TICK[i][0], MARKER_TICK[i][1]);
 	}
-#endif
+}
+
+static const MarkerRenderer MARKER_RENDERERS[NUM_MARKER_STYLES] = {
+	[MARKERS_NUMBERS] = draw_number_markers,
+	[MARKERS_ROMAN] = draw_roman_markers,
+	[MARKERS_TICKS] = draw_tick_markers,
+};
+
+static void draw_markers(GContext *ctx)
+{
+	bool day = s_is_day;
+
+	GColor bg = day ? GColorWhite : GColorBlack;
+	GColor fg = day ? GColorBlack : GColorWhite;
 
-	// DAY|DATE on one line, vertically centred at the 3 o'clock marker
+	s_draw_hour_markers(ctx, day, fg);
+
+	// The day and date
 	{
-		static const char *const DAY_NAMES[] = {
-			"SUN", "MON", "TUE", "WED", "THU", "FRI", "SAT"};
-		char date_str[10];
-		snprintf(date_str, sizeof(date_str), "%s|%d",
-			 DAY_NAMES[t->tm_wday], t->tm_mday);
 		GFont date_font = fonts_get_system_font(FONT_KEY_GOTHIC_14);
-		GRect date_rect =
-			PBL_IF_ROUND_ELSE(GRect(116, center.y - 7, 40, 14),
-					  GRect(84, center.y - 7, 36, 14));
+		GRect date_rect = DATE_RECT;
 		graphics_context_set_fill_color(ctx, bg);
 		graphics_fill_rect(ctx, date_rect, 0, GCornerNone);
 		graphics_context_set_stroke_color(ctx, fg);
 		graphics_draw_rect(ctx, date_rect);
 		graphics_context_set_text_color(ctx, fg);
-		graphics_draw_text(ctx, date_str, date_font, date_rect,
+		graphics_draw_text(ctx, s_date_str, date_font, date_rect,
 				   GTextOverflowModeWordWrap,
 				   GTextAlignmentCenter, NULL);
 	}
 }
 
+// ---- Background cache ----
+//
+// The sky and the hour markers only change at the day/night boundary and
+// when the date rolls over, so they are rendered once, copied out of the
+// frame buffer and blitted on every later frame. Each of day and night
+// gets its own slot when the heap allows it; otherwise they share one slot
+// that is rebuilt at each transition. If not even one slot fits, the
+// layers fall back to drawing directly.
+//
+// While the seconds hand is showing, the cache holds the whole dial up to
+// and including the hour and minute hands and is rebuilt each minute, so
+// the per-second frame is one blit, the stars and the seconds hand.
+
+#define BACKGROUND_HEAP_RESERVE 8192
+
+static GBitmap *s_background[2];
+static int s_background_slots;
+// Which sky each slot currently holds: 0 = night, 1 = day, -1 = stale
+static int8_t s_background_content[2] = {-1, -1};
+
+static size_t background_bytes(GSize size)
+{
+#ifdef PBL_COLOR
+	return (size_t)size.w * size.h;
+#else
+	// 1-bit rows are padded to a 32-bit word
+	return (size_t)((size.w + 31) / 32 * 4) * size.h;
+#endif
+}
+
+static void background_create(GSize size)
+{
+	GBitmapFormat format =
+		PBL_IF_COLOR_ELSE(GBitmapFormat8Bit, GBitmapFormat1Bit);
+	size_t bytes = background_bytes(size);
+
+	s_background_slots = 0;
+	while (s_background_slots < 2 &&
+	       heap_bytes_free() >= bytes + BACKGROUND_HEAP_RESERVE) {
+		GBitmap *bitmap = gbitmap_create_blank(size, format);
+		if (!bitmap)
+			break;
+		s_background[s_background_slots++] = bitmap;
+	}
+	APP_LOG(APP_LOG_LEVEL_DEBUG, "background cache: %d x %d bytes",
+		s_background_slots, (int)bytes);
+}
+
+static void background_destroy(void)
+{
+	for (int i = 0; i < s_background_slots; i++) {
+		gbitmap_destroy(s_background[i]);
+		s_background[i] = NULL;
+	}
+	s_background_slots = 0;
+}
+
+static void background_invalidate(void)
+{
+	s_background_content[0] = s_background_content[1] = -1;
+}
+
+static int background_slot(void)
+{
+	return s_background_slots == 2 ? s_is_day : 0;
+}
+
+static bool background_restore(GContext *ctx, GRect bounds)
+{
+	int slot = background_slot();
+	if (!s_background_slots || s_background_content[slot] != s_is_day)
+		return false;
+	graphics_draw_bitmap_in_rect(ctx, s_background[slot], bounds);
+	return true;
+}
+
+static void background_save(GContext *ctx)
+{
+	GBitmap *fb = graphics_capture_frame_buffer(ctx);
+	if (!fb)
+		return;
+
+	int slot = background_slot();
+	GBitmap *bitmap = s_background[slot];
+	int h = gbitmap_get_bounds(bitmap).size.h;
+#ifdef PBL_COLOR
+	// Round displays only store the visible span of each row
+	for (int y = 0; y < h; y++) {
+		GBitmapDataRowInfo src = gbitmap_get_data_row_info(fb, y);
+		GBitmapDataRowInfo dst = gbitmap_get_data_row_info(bitmap, y);
+		memcpy(dst.data + src.min_x, src.data + src.min_x,
+		       src.max_x - src.min_x + 1);
+	}
+#else
+	uint16_t src_stride = gbitmap_get_bytes_per_row(fb);
+	uint16_t dst_stride = gbitmap_get_bytes_per_row(bitmap);
+	uint8_t *src = gbitmap_get_data(fb);
+	uint8_t *dst = gbitmap_get_data(bitmap);
+	for (int y = 0; y < h; y++)
+		memcpy(dst + y * dst_stride, src + y * src_stride,
+		       dst_stride < src_stride ? dst_stride : src_stride);
+#endif
+	graphics_release_frame_buffer(ctx, fb);
+	s_background_content[slot] = s_is_day;
+}
+
+// ---- Layer callbacks ----
+
+// Whether the hands are part of the cached frame
+static bool hands_cached(void)
+{
+	return s_seconds_visible && s_background_slots;
+}
+
+static void sky_update_proc(Layer *layer, GContext *ctx)
+{
+	GRect bounds = layer_get_bounds(layer);
+
+	// Markers are baked into the cached background. Nothing drawn over it
+	// overlaps them: the sun and moon sit in the gaps left at 12 and 6
+	// o'clock, no star touches a numeral and draw_stars() leaves the date
+	// box alone.
+	s_frame_from_cache = background_restore(ctx, bounds);
+	if (!s_frame_from_cache) {
+		draw_sky(ctx, bounds);
+		if (s_background_slots)
+			draw_markers(ctx);
+		if (s_background_slots && !hands_cached())
+			background_save(ctx);
+	}
+
+	// With the hands cached, stars go on top of them instead
+	if (!s_is_day && !hands_cached())
+		draw_stars(ctx, 0);
+}
+
+static void markers_update_proc(Layer *layer, GContext *ctx)
+{
+	// Only reached directly when the heap had no room for the cache
+	if (!s_background_slots)
+		draw_markers(ctx);
+}
+
 static void subdial_update_proc(Layer *layer, GContext *ctx)
 {
-	time_t now = time(NULL);
-	struct tm *t = localtime(&now);
-	if (is_daytime(t)) {
+	if (hands_cached() && s_frame_from_cache)
+		return;
+
+	if (s_is_day) {
 		GPoint sun_pos = GPoint(CLOCK_CX, CLOCK_CY - MOON_OFFSET_Y);
-		draw_sun(ctx, sun_pos, MOON_RADIUS);
+		draw_sun(ctx, sun_pos);
 	} else {
 		GPoint moon_pos = GPoint(CLOCK_CX, CLOCK_CY + MOON_OFFSET_Y);
-		draw_moon(ctx, moon_pos, MOON_RADIUS, get_moon_age(t));
+		draw_moon(ctx, moon_pos, MOON_RADIUS, s_moon->phase_angle);
 	}
 }
 
-static void hands_update_proc(Layer *layer, GContext *ctx)
+static void draw_hand(GContext *ctx, const GPoint *points)
+{
+	// Points are pre-rotated and placed by the generator, so the path is
+	// drawn as-is without a gpath_create() or gpath_rotate_to()
+	GPath path = {.num_points = HAND_POINTS, .points = (GPoint *)points};
+	gpath_draw_filled(ctx, &path);
+	gpath_draw_outline(ctx, &path);
+}
+
+static int hand_side(GPoint a, GPoint b, GPoint p)
+{
+	return (b.x - a.x) * (p.y - a.y) - (b.y - a.y) * (p.x - a.x);
+}
+
+static bool hand_covers(const GPoint *hand, GPoint p)
+{
+	int d0 = hand_side(hand[0], hand[1], p);
+	int d1 = hand_side(hand[1], hand[2], p);
+	int d2 = hand_side(hand[2], hand[0], p);
+	bool neg = d0 < 0 || d1 < 0 || d2 < 0;
+	bool pos = d0 > 0 || d1 > 0 || d2 > 0;
+	return !(neg && pos);
+}
+
+// Whether the hand touches any pixel of star i, not just its centre. The
+// outline can stray a pixel outside the triangle, so each pixel's
+// neighbours count too.
+static bool hand_covers_star(const GPoint *hand, int i)
+{
+	const RasterShape *shape = &STAR_SHAPE[STAR_RADIUS[i]];
+	GPoint p = STAR_POSITIONS[i];
+	for (int s = 0; s < shape->num_spans; s++) {
+		const RasterSpan *span = &shape->spans[s];
+		for (int y = span->dy - 1; y <= span->dy + 1; y++)
+			for (int x = span->x0 - 1; x <= span->x1 + 1; x++)
+				if (hand_covers(hand, GPoint(p.x + x, p.y + y)))
+					return true;
+	}
+	return false;
+}
+
+static void draw_hour_minute_hands(GContext *ctx)
 {
 	GPoint center = GPoint(CLOCK_CX, CLOCK_CY);
-	time_t now = time(NULL);
-	struct tm *t = localtime(&now);
-	bool day = is_daytime(t);
+	struct tm *t = &s_now;
+	bool day = s_is_day;
 
 	GColor hand_fill = day ? GColorBlack : GColorWhite;
 	GColor hand_stroke = day ? GColorWhite : GColorBlack;
@@ -331,28 +603,290 @@ static void hands_update_proc(Layer *layer, GContext *ctx)
 	graphics_context_set_fill_color(ctx, hand_fill);
 	graphics_context_set_stroke_color(ctx, hand_stroke);
 
-	gpath_rotate_to(s_minute_arrow, TRIG_MAX_ANGLE * t->tm_min / 60);
-	gpath_draw_filled(ctx, s_minute_arrow);
-	gpath_draw_outline(ctx, s_minute_arrow);
-
-	gpath_rotate_to(s_hour_arrow,
-			(TRIG_MAX_ANGLE *
-			 (((t->tm_hour % 12) * 6) + (t->tm_min / 10))) /
-				(12 * 6));
-	gpath_draw_filled(ctx, s_hour_arrow);
-	gpath_draw_outline(ctx, s_hour_arrow);
+	const GPoint *minute = MINUTE_HAND[t->tm_min];
+	const GPoint *hour = HOUR_HAND[(t->tm_hour % 12) * 6 + t->tm_min / 10];
+	draw_hand(ctx, minute);
+	draw_hand(ctx, hour);
 
 	// Center pivot dot
 	graphics_context_set_fill_color(ctx, hand_stroke);
 	graphics_fill_rect(ctx, GRect(center.x - 2, center.y - 2, 5, 5), 0,
 			   GCornerNone);
+
+	s_stars_hidden = 0;
+	for (int i = 0; i < NUM_STARS; i++)
+		if (hand_covers_star(minute, i) || hand_covers_star(hour, i))
+			s_stars_hidden |= 1u << i;
+}
+
+static void draw_seconds_hand(GContext *ctx)
+{
+	const GPoint *hand = SECOND_HAND[s_now.tm_sec];
+	graphics_context_set_stroke_color(
+		ctx, PBL_IF_COLOR_ELSE(GColorRed,
+				       s_is_day ? GColorBlack : GColorWhite));
+	graphics_draw_line(ctx, hand[0], hand[1]);
+}
+
+static void hands_update_proc(Layer *layer, GContext *ctx)
+{
+	if (!hands_cached() || !s_frame_from_cache) {
+		draw_hour_minute_hands(ctx);
+		if (hands_cached())
+			background_save(ctx);
+	}
+
+	// Drawn over the cached hands, so skip any star they cover
+	if (hands_cached() && !s_is_day)
+		draw_stars(ctx, s_stars_hidden);
+
+	if (s_seconds_visible)
+		draw_seconds_hand(ctx);
 }
 
 // ---- Tick handler ----
 
+static void tick_handler(struct tm *tick_time, TimeUnits units_changed);
+
+static void subscribe_ticks(void)
+{
+	// Stars twinkle every second at night; by day nothing on the face moves
+	// faster than the minute hand unless the seconds hand is up. Below the
+	// full tier neither happens.
+	bool seconds = s_tier == TIER_FULL && (!s_is_day || s_seconds_visible);
+	tick_timer_service_subscribe(seconds ? SECOND_UNIT : MINUTE_UNIT,
+				     tick_handler);
+}
+
+static void update_date(void)
+{
+	static const char *const DAY_NAMES[] = {"SUN", "MON", "TUE", "WED",
+						"THU", "FRI", "SAT"};
+	snprintf(s_date_str, sizeof(s_date_str), "%s|%d",
+		 DAY_NAMES[s_now.tm_wday], s_now.tm_mday);
+	s_moon = lunar_phase_for_date(time(NULL), &s_now);
+}
+
 static void tick_handler(struct tm *tick_time, TimeUnits units_changed)
 {
+	s_now = *tick_time;
+	if (units_changed & DAY_UNIT) {
+		update_date();
+		background_invalidate();
+	}
+
+	// Day/night boundary: every layer changes colour, and the tick rate
+	// changes with it
+	bool day = is_daytime(&s_now);
+	if (day != s_is_day) {
+		s_is_day = day;
+		subscribe_ticks();
+		layer_mark_dirty(window_get_root_layer(s_window));
+		return;
+	}
+
+	if (units_changed & DAY_UNIT) {
+		layer_mark_dirty(s_markers_layer);
+		layer_mark_dirty(s_subdial_layer);
+	}
+	if (units_changed & MINUTE_UNIT) {
+		if (hands_cached())
+			background_invalidate();
+		layer_mark_dirty(s_hands_layer);
+	}
+	if (!day && (units_changed & SECOND_UNIT))
+		layer_mark_dirty(s_sky_layer);
+	if (s_seconds_visible && (units_changed & SECOND_UNIT))
+		layer_mark_dirty(s_hands_layer);
+}
+
+// ---- Seconds hand ----
+
+static void seconds_set_visible(bool visible)
+{
+	if (visible == s_seconds_visible)
+		return;
+	s_seconds_visible = visible;
+	// The cache switches between holding the hands and not
+	background_invalidate();
+	subscribe_ticks();
+	layer_mark_dirty(window_get_root_layer(s_window));
+}
+
+static void seconds_idle_handler(void *context)
+{
+	s_seconds_idle_timer = NULL;
+	seconds_set_visible(false);
+}
+
+static void seconds_wake(void)
+{
+	if (!s_settings.seconds_hand || s_tier != TIER_FULL)
+		return;
+
+	uint32_t timeout_ms = s_settings.seconds_timeout * 1000;
+	if (!s_seconds_idle_timer ||
+	    !app_timer_reschedule(s_seconds_idle_timer, timeout_ms))
+		s_seconds_idle_timer = app_timer_register(
+			timeout_ms, seconds_idle_handler, NULL);
+	seconds_set_visible(true);
+}
+
+static void tap_handler(AccelAxisType axis, int32_t direction)
+{
+	seconds_wake();
+}
+
+// Flicks are only listened for while the setting is on
+static void seconds_enable(bool enable)
+{
+	if (enable) {
+		accel_tap_service_subscribe(tap_handler);
+		seconds_wake();
+		return;
+	}
+
+	accel_tap_service_unsubscribe();
+	if (s_seconds_idle_timer) {
+		app_timer_cancel(s_seconds_idle_timer);
+		s_seconds_idle_timer = NULL;
+	}
+	seconds_set_visible(false);
+}
+
+// ---- Battery governor ----
+
+static RefreshTier governor_tier(BatteryChargeState charge)
+{
+	if (charge.is_charging || charge.is_plugged)
+		return TIER_FULL;
+
+	int pct = charge.charge_percent;
+	if (pct <= TIER_CRITICAL_ENTER ||
+	    (s_tier == TIER_CRITICAL && pct < TIER_CRITICAL_LEAVE))
+		return TIER_CRITICAL;
+	if (pct <= TIER_REDUCED_ENTER ||
+	    (s_tier != TIER_FULL && pct < TIER_REDUCED_LEAVE))
+		return TIER_REDUCED;
+	return TIER_FULL;
+}
+
+static void battery_handler(BatteryChargeState charge)
+{
+	RefreshTier tier = governor_tier(charge);
+	if (tier == s_tier)
+		return;
+
+	s_tier = tier;
+	if (tier != TIER_FULL && s_seconds_idle_timer) {
+		app_timer_cancel(s_seconds_idle_timer);
+		s_seconds_idle_timer = NULL;
+	}
+	if (tier != TIER_FULL)
+		seconds_set_visible(false);
+
+	// Clouds are part of the cached sky
+	background_invalidate();
+	subscribe_ticks();
+	layer_mark_dirty(window_get_root_layer(s_window));
+}
+
+// ---- Settings ----
+
+static void settings_load(void)
+{
+	// Nothing stored yet, or a record of another size, keeps the defaults.
+	// Records from before the seconds hand settings end where they begin
+	// and keep their defaults.
+	Settings settings = DEFAULT_SETTINGS;
+	int size = persist_read_data(SETTINGS_PERSIST_KEY, &settings,
+				     sizeof(settings));
+	if ((size == sizeof(settings) ||
+	     size == offsetof(Settings, seconds_hand)) &&
+	    settings.marker_style < NUM_MARKER_STYLES &&
+	    settings.day_start < settings.day_end && settings.day_end <= 24 &&
+	    settings.seconds_hand <= 1 &&
+	    settings.seconds_timeout >= SECONDS_TIMEOUT_MIN &&
+	    settings.seconds_timeout <= SECONDS_TIMEOUT_MAX)
+		s_settings = settings;
+	else
+		s_settings = DEFAULT_SETTINGS;
+}
+
+// Bind the renderers the settings pick; frames only call through them
+static void settings_bind(void)
+{
+	s_draw_hour_markers = MARKER_RENDERERS[s_settings.marker_style];
+}
+
+static int32_t tuple_int(const Tuple *t)
+{
+	if (t->type == TUPLE_CSTRING)
+		return atoi(t->value->cstring);
+	if (t->type == TUPLE_INT)
+		return t->length == 1 ? t->value->int8 :
+		       t->length == 2 ? t->value->int16 :
+					t->value->int32;
+	if (t->type == TUPLE_UINT)
+		return t->length == 1 ? t->value->uint8 :
+		       t->length == 2 ? t->value->uint16 :
+					(int32_t)t->value->uint32;
+	return -1;
+}
+
+// A setting the message carries, if it lies within min..max
+static bool read_setting(DictionaryIterator *iter, uint32_t key, int min,
+			 int max, uint8_t *out)
+{
+	Tuple *t = dict_find(iter, key);
+	if (!t)
+		return true;
+	int32_t value = tuple_int(t);
+	if (value < min || value > max)
+		return false;
+	*out = value;
+	return true;
+}
+
+static void inbox_received_handler(DictionaryIterator *iter, void *context)
+{
+	Settings settings = s_settings;
+	if (!read_setting(iter, MESSAGE_KEY_MarkerStyle, 0,
+			  NUM_MARKER_STYLES - 1, &settings.marker_style) ||
+	    !read_setting(iter, MESSAGE_KEY_DayStart, 0, 23,
+			  &settings.day_start) ||
+	    !read_setting(iter, MESSAGE_KEY_DayEnd, 1, 24,
+			  &settings.day_end) ||
+	    !read_setting(iter, MESSAGE_KEY_SecondsHand, 0, 1,
+			  &settings.seconds_hand) ||
+	    !read_setting(iter, MESSAGE_KEY_SecondsTimeout,
+			  SECONDS_TIMEOUT_MIN, SECONDS_TIMEOUT_MAX,
+			  &settings.seconds_timeout) ||
+	    settings.day_start >= settings.day_end) {
+		APP_LOG(APP_LOG_LEVEL_WARNING, "settings out of range");
+		return;
+	}
+	if (!memcmp(&settings, &s_settings, sizeof(settings)))
+		return;
+
+	Settings old = s_settings;
+	s_settings = settings;
+	persist_write_data(SETTINGS_PERSIST_KEY, &s_settings,
+			   sizeof(s_settings));
+	settings_bind();
+
+	// The markers and the day/night split are baked into the cached
+	// background; this is the only time they change
+	background_invalidate();
+	s_is_day = is_daytime(&s_now);
+	subscribe_ticks();
 	layer_mark_dirty(window_get_root_layer(s_window));
+
+	// Turned on or off, or shown again for the new timeout
+	if (s_settings.seconds_hand != old.seconds_hand)
+		seconds_enable(s_settings.seconds_hand);
+	else if (s_settings.seconds_timeout != old.seconds_timeout)
+		seconds_wake();
 }
 
 // ---- Window lifecycle ----
@@ -361,7 +895,6 @@ static void window_load(Window *window)
 {
 	Layer *window_layer = window_get_root_layer(window);
 	GRect bounds = layer_get_bounds(window_layer);
-	GPoint center = GPoint(CLOCK_CX, CLOCK_CY);
 
 	s_sky_layer = layer_create(bounds);
 	layer_set_update_proc(s_sky_layer, sky_update_proc);
@@ -379,16 +912,23 @@ static void window_load(Window *window)
 	layer_set_update_proc(s_hands_layer, hands_update_proc);
 	layer_add_child(window_layer, s_hands_layer);
 
-	s_minute_arrow = gpath_create(&MINUTE_HAND_POINTS);
-	s_hour_arrow = gpath_create(&HOUR_HAND_POINTS);
-	gpath_move_to(s_minute_arrow, center);
-	gpath_move_to(s_hour_arrow, center);
+	background_create(bounds.size);
+
+	s_moon_phases = gbitmap_create_with_resource(RESOURCE_ID_MOON_PHASES);
+	if (s_moon_phases) {
+		s_moon_sprite = gbitmap_create_as_sub_bitmap(
+			s_moon_phases,
+			GRect(0, 0, MOON_SPRITE_SIZE, MOON_SPRITE_SIZE));
+	}
 }
 
 static void window_unload(Window *window)
 {
-	gpath_destroy(s_minute_arrow);
-	gpath_destroy(s_hour_arrow);
+	background_destroy();
+	if (s_moon_sprite)
+		gbitmap_destroy(s_moon_sprite);
+	if (s_moon_phases)
+		gbitmap_destroy(s_moon_phases);
 	layer_destroy(s_sky_layer);
 	layer_destroy(s_subdial_layer);
 	layer_destroy(s_markers_layer);
@@ -399,19 +939,49 @@ static void window_unload(Window *window)
 
 static void init(void)
 {
+	settings_load();
+	settings_bind();
+
+	time_t now = time(NULL);
+	s_now = *localtime(&now);
+	s_is_day = is_daytime(&s_now);
+	s_tier = governor_tier(battery_state_service_peek());
+	update_date();
+
 	s_window = window_create();
 	window_set_window_handlers(s_window, (WindowHandlers){
 						     .load = window_load,
 						     .unload = window_unload,
 					     });
 	window_stack_push(s_window, true);
-	tick_timer_service_subscribe(SECOND_UNIT, tick_handler);
+	subscribe_ticks();
+	battery_state_service_subscribe(battery_handler);
+
+	// Settings from the phone: five int32s
+	app_message_register_inbox_received(inbox_received_handler);
+	app_message_open(dict_calc_buffer_size(5, sizeof(int32_t),
+					       sizeof(int32_t),
+					       sizeof(int32_t),
+					       sizeof(int32_t),
+					       sizeof(int32_t)),
+			 0);
+
+	if (s_settings.seconds_hand)
+		seconds_enable(true);
 }
 
 static void deinit(void)
 {
+	if (s_settings.seconds_hand)
+		accel_tap_service_unsubscribe();
+	if (s_seconds_idle_timer)
+		app_timer_cancel(s_seconds_idle_timer);
+	app_message_deregister_callbacks();
+	battery_state_service_unsubscribe();
 	tick_timer_service_unsubscribe();
 	window_destroy(s_window);
+	profile_dump();
+	heap_trace_dump();
 }
 
 int main(void)
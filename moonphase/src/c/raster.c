@@ -0,0 +1,103 @@
+#include "raster.h"
+
+#include "profile.h"
+
+void raster_begin(Raster *raster, GContext *ctx)
+{
+	raster->ctx = ctx;
+	raster->fb = graphics_capture_frame_buffer(ctx);
+	raster->hole = GRectZero;
+	if (raster->fb)
+		raster->size = gbitmap_get_bounds(raster->fb).size;
+}
+
+void raster_end(Raster *raster)
+{
+	if (raster->fb)
+		graphics_release_frame_buffer(raster->ctx, raster->fb);
+	raster->fb = NULL;
+}
+
+void raster_set_hole(Raster *raster, GRect rect)
+{
+	raster->hole = rect;
+}
+
+#ifdef PBL_BW
+// 1-bit rows are LSB first: pixel x is bit x % 8 of byte x / 8
+static void write_span(GBitmap *fb, int y, int x0, int x1, GColor color)
+{
+	uint8_t *row = gbitmap_get_data(fb) + y * gbitmap_get_bytes_per_row(fb);
+	bool white = gcolor_equal(color, GColorWhite);
+	int first = x0 / 8, last = x1 / 8;
+
+	for (int b = first; b <= last; b++) {
+		uint8_t mask = 0xff;
+		if (b == first)
+			mask &= 0xff << (x0 % 8);
+		if (b == last)
+			mask &= 0xff >> (7 - x1 % 8);
+		row[b] = white ? row[b] | mask : row[b] & ~mask;
+	}
+}
+#else
+// One byte per pixel; round displays only store the visible part of each
+// row, which the row info describes
+static void write_span(GBitmap *fb, int y, int x0, int x1, GColor color)
+{
+	GBitmapDataRowInfo info = gbitmap_get_data_row_info(fb, y);
+	if (x0 < info.min_x)
+		x0 = info.min_x;
+	if (x1 > info.max_x)
+		x1 = info.max_x;
+	if (x0 <= x1)
+		memset(info.data + x0, color.argb, x1 - x0 + 1);
+}
+#endif
+
+// One span, less any part of it inside the hole
+static void fill_span(Raster *raster, int y, int x0, int x1, GColor color)
+{
+	GRect hole = raster->hole;
+	if (hole.size.w && y >= hole.origin.y &&
+	    y < hole.origin.y + hole.size.h) {
+		int hole_x1 = hole.origin.x + hole.size.w - 1;
+		if (x0 < hole.origin.x && x1 > hole_x1) {
+			fill_span(raster, y, hole_x1 + 1, x1, color);
+			x1 = hole.origin.x - 1;
+		} else if (x0 >= hole.origin.x && x0 <= hole_x1) {
+			x0 = hole_x1 + 1;
+		} else if (x1 >= hole.origin.x && x1 <= hole_x1) {
+			x1 = hole.origin.x - 1;
+		}
+	}
+	if (x0 > x1)
+		return;
+
+	if (!raster->fb) {
+		graphics_context_set_stroke_color(raster->ctx, color);
+		graphics_draw_line(raster->ctx, GPoint(x0, y), GPoint(x1, y));
+	} else {
+		write_span(raster->fb, y, x0, x1, color);
+	}
+}
+
+void raster_fill(Raster *raster, const RasterShape *shape, GPoint origin,
+		 GColor color)
+{
+	for (int i = 0; i < shape->num_spans; i++) {
+		const RasterSpan *s = &shape->spans[i];
+		int y = origin.y + s->dy;
+		int x0 = origin.x + s->x0, x1 = origin.x + s->x1;
+		// Through the GContext, which clips to the layer itself
+		if (raster->fb) {
+			if (y < 0 || y >= raster->size.h)
+				continue;
+			if (x0 < 0)
+				x0 = 0;
+			if (x1 >= raster->size.w)
+				x1 = raster->size.w - 1;
+		}
+		fill_span(raster, y, x0, x1, color);
+	}
+}
@@ -0,0 +1,40 @@
+#pragma once
+
+#include <pebble.h>
+
+// Solid shapes stored as horizontal spans and written straight into the
+// frame buffer, for small things drawn many times per frame. Coordinates
+// are screen coordinates: every moonphase layer covers the whole window.
+
+// Pixels x0..x1 inclusive on row dy, relative to the shape's origin
+typedef struct {
+	int8_t dy;
+	int8_t x0;
+	int8_t x1;
+} RasterSpan;
+
+typedef struct {
+	const RasterSpan *spans;
+	uint8_t num_spans;
+} RasterShape;
+
+typedef struct {
+	GContext *ctx;
+	// NULL when the frame buffer could not be captured; shapes are then
+	// drawn through the GContext instead
+	GBitmap *fb;
+	GSize size;
+	// Pixels later fills leave alone, if not empty
+	GRect hole;
+} Raster;
+
+// Capture the frame buffer; raster_end() must follow before the update proc
+// returns
+void raster_begin(Raster *raster, GContext *ctx);
+void raster_end(Raster *raster);
+
+// Keep later fills out of rect, as if it were drawn on top of them
+void raster_set_hole(Raster *raster, GRect rect);
+
+void raster_fill(Raster *raster, const RasterShape *shape, GPoint origin,
+		 GColor color);
@@ -0,0 +1,90 @@
+// The settings page, in Clay's config format. index.js renders it; the
+// face reads the values in inbox_received_handler() (src/c/moonphase.c).
+module.exports = [
+  {
+    type: 'heading',
+    defaultValue: 'Moon Phase'
+  },
+  {
+    type: 'section',
+    items: [
+      {
+        type: 'heading',
+        defaultValue: 'Hour markers'
+      },
+      {
+        type: 'radiogroup',
+        messageKey: 'MarkerStyle',
+        label: 'Style',
+        defaultValue: '0',
+        options: [
+          { label: 'Numbers', value: '0' },
+          { label: 'Roman numerals', value: '1' },
+          { label: 'Ticks', value: '2' }
+        ]
+      }
+    ]
+  },
+  {
+    type: 'section',
+    items: [
+      {
+        type: 'heading',
+        defaultValue: 'Day and night'
+      },
+      {
+        type: 'slider',
+        messageKey: 'DayStart',
+        label: 'Day starts at',
+        description: 'Hour of the day, 0-23',
+        defaultValue: 6,
+        min: 0,
+        max: 23,
+        step: 1
+      },
+      {
+        type: 'slider',
+        messageKey: 'DayEnd',
+        label: 'Night starts at',
+        description: 'Hour of the day, 1-24; later than the day starts',
+        defaultValue: 20,
+        min: 1,
+        max: 24,
+        step: 1
+      }
+    ]
+  },
+  {
+    type: 'section',
+    items: [
+      {
+        type: 'heading',
+        defaultValue: 'Seconds hand'
+      },
+      {
+        type: 'radiogroup',
+        messageKey: 'SecondsHand',
+        label: 'Show',
+        defaultValue: '0',
+        options: [
+          { label: 'Never', value: '0' },
+          { label: 'After a flick of the wrist', value: '1' }
+        ]
+      },
+      {
+        type: 'slider',
+        messageKey: 'SecondsTimeout',
+        label: 'Hide after',
+        description: 'Seconds without a flick, 10-240',
+        defaultValue: 60,
+        min: 10,
+        max: 240,
+        step: 10
+      }
+    ]
+  },
+  {
+    type: 'submit',
+    defaultValue: 'Save'
+  }
+];
@@ -0,0 +1,125 @@
+// Settings for the face. config.js describes the page in Clay's format;
+// the few item types it uses are rendered here into one self-contained
+// page, so the face needs no npm packages. Saved values go to the watch as
+// one app message of integers, which the face stores with persist, and are
+// kept in localStorage to fill in the page next time.
+
+var config = require('./config');
+
+var STORAGE_KEY = 'settings';
+
+function loadSettings() {
+  try {
+    return JSON.parse(localStorage.getItem(STORAGE_KEY)) || {};
+  } catch (e) {
+    return {};
+  }
+}
+
+function escapeHtml(text) {
+  return String(text).replace(/[&<>"]/g, function(c) {
+    return { '&': '&amp;', '<': '&lt;', '>': '&gt;', '"': '&quot;' }[c];
+  });
+}
+
+function renderItem(item, settings) {
+  var value = item.messageKey in settings ? settings[item.messageKey] :
+    item.defaultValue;
+  var description = item.description ?
+    '<small>' + escapeHtml(item.description) + '</small>' : '';
+
+  switch (item.type) {
+  case 'heading':
+    return '<h2>' + escapeHtml(item.defaultValue) + '</h2>';
+  case 'section':
+    return '<section>' + item.items.map(function(child) {
+      return renderItem(child, settings);
+    }).join('') + '</section>';
+  case 'radiogroup':
+    return '<fieldset><legend>' + escapeHtml(item.label) + '</legend>' +
+      item.options.map(function(option) {
+        var checked = String(option.value) === String(value) ?
+          ' checked' : '';
+        return '<label><input type="radio" name="' + item.messageKey +
+          '" value="' + escapeHtml(option.value) + '"' + checked + '> ' +
+          escapeHtml(option.label) + '</label>';
+      }).join('') + description + '</fieldset>';
+  case 'slider':
+    return '<label>' + escapeHtml(item.label) + ' <output>' +
+      escapeHtml(value) + '</output><input type="range" name="' +
+      item.messageKey + '" min="' + item.min + '" max="' + item.max +
+      '" step="' + (item.step || 1) + '" value="' + escapeHtml(value) +
+      '" oninput="this.previousSibling.value = this.value"></label>' +
+      description;
+  case 'submit':
+    return '<p id="error"></p><button type="submit">' +
+      escapeHtml(item.defaultValue) + '</button>';
+  }
+  return '';
+}
+
+// Runs in the page: every named input as an integer, back to the app
+function saveSettings(form) {
+  var values = {};
+  for (var i = 0; i < form.elements.length; i++) {
+    var input = form.elements[i];
+    if (input.name && (input.type !== 'radio' || input.checked)) {
+      values[input.name] = parseInt(input.value, 10);
+    }
+  }
+  if (values.DayStart >= values.DayEnd) {
+    document.getElementById('error').textContent =
+      'Night has to start later than the day.';
+    return false;
+  }
+  location.href = 'pebblejs://close#' +
+    encodeURIComponent(JSON.stringify(values));
+  return false;
+}
+
+function page(settings) {
+  return '<!DOCTYPE html><html><head><meta charset="utf-8">' +
+    '<meta name="viewport" content="width=device-width, initial-scale=1">' +
+    '<style>' +
+    'body{font-family:sans-serif;background:#333;color:#fff;margin:0;' +
+    'padding:8px}section,fieldset{background:#484848;border:0;' +
+    'border-radius:4px;margin:0 0 12px;padding:8px}label{display:block;' +
+    'margin:8px 0}input[type=range]{width:100%}small{color:#aaa}' +
+    '#error{color:#f66}button{width:100%;padding:12px;font-size:1em;' +
+    'background:#ff4700;color:#fff;border:0;border-radius:4px}' +
+    '</style><script>' + saveSettings.toString() + '</script>' +
+    '</head><body>' +
+    '<form onsubmit="return saveSettings(this)">' +
+    config.map(function(item) {
+      return renderItem(item, settings);
+    }).join('') +
+    '</form></body></html>';
+}
+
+Pebble.addEventListener('showConfiguration', function() {
+  Pebble.openURL('data:text/html;charset=utf-8,' +
+    encodeURIComponent(page(loadSettings())));
+});
+
+Pebble.addEventListener('webviewclosed', function(e) {
+  // Closed without saving
+  if (!e || !e.response) {
+    return;
+  }
+
+  var settings;
+  try {
+    settings = JSON.parse(decodeURIComponent(e.response));
+  } catch (err) {
+    console.log('Settings: bad response ' + e.response);
+    return;
+  }
+  localStorage.setItem(STORAGE_KEY, JSON.stringify(settings));
+
+  // Keys are the messageKeys of package.json, by name
+  Pebble.sendAppMessage(settings, function() {
+    console.log('Settings sent');
+  }, function(err) {
+    console.log('Settings not sent: ' + JSON.stringify(err));
+  });
+});
@@ -0,0 +1,354 @@
+"""Generate per-platform dial geometry tables for the moonphase face.
+
+Everything the face used to derive with sin_lookup/cos_lookup and integer
+division on each redraw depends only on the dial centre, so it is computed
+here once per platform: hour marker anchors, the sun's rays and every
+position of the hands. Rounding copies the watch's integer arithmetic so
+the tables reproduce what it used to draw.
+
+The day sky's clouds are listed here too, with the ordered-dither
+patterns and cloud row masks that 1-bit platforms write straight into the
+frame buffer instead. So are the stars and the sun, as the horizontal
+spans the face's raster module writes into 1-bit frame buffers. They
+cover the same pixels as the non-antialiased fills, circles and lines
+they replace. Colour platforms keep drawing those through the GContext
+for its antialiasing, from the same ray endpoints.
+"""
+
+import math
+
+import genutil
+
+TRIG_MAX_ANGLE = 0x10000
+TRIG_MAX_RATIO = 0xffff
+
+# Hand outlines before rotation, pointing at 12 o'clock
+MINUTE_HAND = [(-4, 12), (4, 12), (0, -62)]
+HOUR_HAND = [(-5, 12), (5, 12), (0, -40)]
+SECOND_HAND = [(0, 14), (0, -64)]
+MINUTE_POSITIONS = 60
+# The hour hand steps every ten minutes
+HOUR_POSITIONS = 12 * 6
+
+# Rectangular dials project numerals onto this box instead of a circle
+RECT_HALF_W = 52
+RECT_HALF_H = 62
+TICK_INNER = 55
+TICK_OUTER = 62
+SUN_RAYS = 8
+# Star sizes in the face's STAR_RADIUS table
+STAR_MAX_RADIUS = 2
+
+# Day sky clouds as (x, y, r) puffs, drawn over the rectangular layout on
+# every platform
+CLOUD_PUFFS = [
+    # Top left
+    (20, 24, 7), (11, 28, 5), (29, 28, 5), (22, 18, 5),
+    # Top right
+    (116, 16, 8), (106, 21, 6), (126, 21, 6), (118, 9, 5),
+    # Right edge, mid-upper
+    (134, 50, 5), (127, 54, 4), (140, 54, 4),
+]
+
+# 1-bit day sky: the share of black pixels in each of the colour sky's four
+# bands, out of 16, laid out by a 4x4 Bayer matrix
+SKY_BAND_INK = [5, 3, 1, 0]
+BAYER_4X4 = [
+    [0, 8, 2, 10],
+    [12, 4, 14, 6],
+    [3, 11, 1, 9],
+    [15, 7, 13, 5],
+]
+# Width of a 1-bit frame buffer row in 32-bit words
+FB_WORDS = 5
+
+
+def _sin(angle):
+    return int(round(math.sin(2 * math.pi * angle / TRIG_MAX_ANGLE) *
+                     TRIG_MAX_RATIO))
+
+
+def _cos(angle):
+    return int(round(math.cos(2 * math.pi * angle / TRIG_MAX_ANGLE) *
+                     TRIG_MAX_RATIO))
+
+
+def _div(a, b):
+    # C integer division truncates towards zero
+    q = abs(a) // abs(b)
+    return q if (a < 0) == (b < 0) else -q
+
+
+def _polar(cx, cy, angle, r):
+    return (_div(_sin(angle) * r, TRIG_MAX_RATIO) + cx,
+            _div(-_cos(angle) * r, TRIG_MAX_RATIO) + cy)
+
+
+def _numeral_anchor(g, angle):
+    cx, cy = g['cx'], g['cy']
+    if g['round']:
+        return _polar(cx, cy, angle, g['numeral_r'])
+
+    sin_a, cos_a = _sin(angle), _cos(angle)
+    abs_sin, abs_cos = abs(sin_a), abs(cos_a)
+    if abs_sin == 0:
+        return cx, cy + (-RECT_HALF_H if cos_a > 0 else RECT_HALF_H)
+    if abs_cos == 0:
+        return cx + (RECT_HALF_W if sin_a > 0 else -RECT_HALF_W), cy
+    if RECT_HALF_W * abs_cos <= RECT_HALF_H * abs_sin:
+        return (cx + (RECT_HALF_W if sin_a > 0 else -RECT_HALF_W),
+                cy - _div(cos_a * RECT_HALF_W, abs_sin))
+    return (cx + _div(sin_a * RECT_HALF_H, abs_cos),
+            cy + (-RECT_HALF_H if cos_a > 0 else RECT_HALF_H))
+
+
+def _rotate(points, angle, cx, cy):
+    # Same arithmetic as gpath_rotate_to() followed by gpath_move_to()
+    c, s = _cos(angle), _sin(angle)
+    return [(_div(x * c, TRIG_MAX_RATIO) - _div(y * s, TRIG_MAX_RATIO) + cx,
+             _div(y * c, TRIG_MAX_RATIO) + _div(x * s, TRIG_MAX_RATIO) + cy)
+            for x, y in points]
+
+
+def _points(points):
+    return ', '.join('{%d, %d}' % p for p in points)
+
+
+def _table(lines, decl, rows):
+    lines.append('static const %s = {' % decl)
+    lines.extend('\t{%s},' % _points(row) for row in rows)
+    lines.append('};')
+
+
+def _sky_dither():
+    # 1-bit frame buffers are LSB first, so bit x of a word is pixel x; a
+    # set bit is white
+    rows = []
+    for ink in SKY_BAND_INK:
+        band = []
+        for y in range(4):
+            word = 0
+            for x in range(32):
+                if BAYER_4X4[y][x % 4] >= ink:
+                    word |= 1 << x
+            band.append(word)
+        rows.append(band)
+    return rows
+
+
+def _cloud_masks():
+    # Same coverage as graphics_fill_circle() without antialiasing
+    top = min(y - r for _, y, r in CLOUD_PUFFS)
+    bottom = max(y + r for _, y, r in CLOUD_PUFFS)
+    rows = []
+    for y in range(top, bottom + 1):
+        words = [0] * FB_WORDS
+        for cx, cy, r in CLOUD_PUFFS:
+            dy = y - cy
+            for x in range(cx - r, cx + r + 1):
+                if 0 <= x < 32 * FB_WORDS and \
+                        (x - cx) ** 2 + dy ** 2 <= r * r + r:
+                    words[x // 32] |= 1 << (x % 32)
+        rows.append(words)
+    return top, rows
+
+
+def _words(lines, decl, rows):
+    lines.append('static const %s = {' % decl)
+    lines.extend('\t{%s},' % ', '.join('0x%08x' % w for w in row)
+                 for row in rows)
+    lines.append('};')
+
+
+def _sky_block():
+    lines = ['#define CLOUD_PUFFS %d' % len(CLOUD_PUFFS), '']
+    lines.append('static const GPoint CLOUD_PUFF_CENTER[CLOUD_PUFFS] = {')
+    for i in range(0, len(CLOUD_PUFFS), 4):
+        lines.append('\t%s,' % _points((x, y) for x, y, _ in
+                                         CLOUD_PUFFS[i:i + 4]))
+    lines.append('};')
+    lines.append('static const uint8_t CLOUD_PUFF_RADIUS[CLOUD_PUFFS] = {')
+    lines.append('\t%s,' % ', '.join(str(r) for _, _, r in CLOUD_PUFFS))
+    lines.append('};')
+
+    top, masks = _cloud_masks()
+    lines += [
+        '',
+        '#ifdef PBL_BW',
+        '#define SKY_FB_WORDS %d' % FB_WORDS,
+        '#define CLOUD_FIRST_ROW %d' % top,
+        '#define CLOUD_ROWS %d' % len(masks),
+        '',
+    ]
+    _words(lines, 'uint32_t SKY_DITHER[4][4]', _sky_dither())
+    _words(lines, 'uint32_t CLOUD_MASK[CLOUD_ROWS][SKY_FB_WORDS]', masks)
+    lines += ['#endif', '']
+    return lines
+
+
+def _disc(r):
+    # graphics_fill_circle()
+    pixels = set()
+    for dy in range(-r, r + 1):
+        dx = 0
+        while (dx + 1) ** 2 + dy ** 2 <= r * r + r:
+            dx += 1
+        if dx * dx + dy * dy <= r * r + r:
+            pixels.update((x, dy) for x in range(-dx, dx + 1))
+    return pixels
+
+
+def _circle(r):
+    # graphics_draw_circle() with a 1-pixel stroke: midpoint circle
+    pixels = set()
+    x, y, err = r, 0, 1 - r
+    while x >= y:
+        for px, py in ((x, y), (y, x)):
+            pixels.update({(px, py), (-px, py), (px, -py), (-px, -py)})
+        y += 1
+        if err < 0:
+            err += 2 * y + 1
+        else:
+            x -= 1
+            err += 2 * (y - x) + 1
+    return pixels
+
+
+def _line(p0, p1):
+    # graphics_draw_line() with a 1-pixel stroke: Bresenham
+    (x0, y0), (x1, y1) = p0, p1
+    dx, sx = abs(x1 - x0), 1 if x0 < x1 else -1
+    dy, sy = -abs(y1 - y0), 1 if y0 < y1 else -1
+    err = dx + dy
+    pixels = set()
+    while True:
+        pixels.add((x0, y0))
+        if (x0, y0) == (x1, y1):
+            return pixels
+        e2 = 2 * err
+        if e2 >= dy:
+            err += dy
+            x0 += sx
+        if e2 <= dx:
+            err += dx
+            y0 += sy
+
+
+def _spans(pixels):
+    spans = []
+    for y in sorted({y for _, y in pixels}):
+        xs = sorted(x for x, py in pixels if py == y)
+        start = prev = xs[0]
+        for x in xs[1:] + [None]:
+            if x != prev + 1:
+                spans.append((y, start, prev))
+                start = x
+            prev = x
+    return spans
+
+
+def _shape(lines, name, pixels):
+    spans = _spans(pixels)
+    lines.append('static const RasterSpan %s_SPANS[%d] = {' %
+                 (name, len(spans)))
+    for i in range(0, len(spans), 6):
+        lines.append('\t%s,' % ', '.join('{%d, %d, %d}' % span
+                                          for span in spans[i:i + 6]))
+    lines.append('};')
+    return '{%s_SPANS, %d}' % (name, len(spans))
+
+
+def _star_block():
+    lines = []
+    shapes = ['{NULL, 0}']
+    for r in range(1, STAR_MAX_RADIUS + 1):
+        shapes.append(_shape(lines, 'STAR_R%d' % r, _disc(r)))
+    lines.append('static const RasterShape STAR_SHAPE[%d] = {' %
+                 (STAR_MAX_RADIUS + 1))
+    lines.append('\t%s,' % ', '.join(shapes))
+    lines += ['};', '']
+    return lines
+
+
+def _platform_block(g):
+    cx, cy = g['cx'], g['cy']
+    lines = [
+        '#define GEOMETRY_CLOCK_CX %d' % cx,
+        '#define GEOMETRY_CLOCK_CY %d' % cy,
+        '#define GEOMETRY_NUMERAL_R %d' % g['numeral_r'],
+        '#define GEOMETRY_MOON_OFFSET_Y %d' % g['moon_offset_y'],
+        '#define GEOMETRY_MOON_RADIUS %d' % g['moon_radius'],
+        '',
+    ]
+
+    hours = [TRIG_MAX_ANGLE * i // 12 for i in range(13)]
+    lines.append('static const GPoint MARKER_ANCHOR[13] = {')
+    lines.extend('\t{%d, %d},' % _numeral_anchor(g, a) for a in hours)
+    lines.append('};')
+    _table(lines, 'GPoint MARKER_TICK[13][2]',
+           [(_polar(cx, cy, a, TICK_INNER), _polar(cx, cy, a, TICK_OUTER))
+            for a in hours])
+
+    # The sun's rays, drawn around it only when the face can afford them
+    r = g['moon_radius']
+    sun_y = cy - g['moon_offset_y']
+    rays = [TRIG_MAX_ANGLE * i // SUN_RAYS for i in range(SUN_RAYS)]
+    _table(lines, 'GPoint SUN_RAY[%d][2]' % SUN_RAYS,
+           [(_polar(cx, sun_y, a, r + 3), _polar(cx, sun_y, a, r + 8))
+            for a in rays])
+
+    # The same sun as spans relative to its centre: a filled and stroked
+    # disc, and the rays
+    lines.append('static const RasterShape SUN_DISC = %s;' %
+                 _shape(lines, 'SUN_DISC', _disc(r) | _circle(r)))
+    ray_pixels = set()
+    for a in rays:
+        ray_pixels |= _line(_polar(0, 0, a, r + 3), _polar(0, 0, a, r + 8))
+    lines.append('static const RasterShape SUN_RAYS = %s;' %
+                 _shape(lines, 'SUN_RAYS', ray_pixels))
+
+    _table(lines, 'GPoint MINUTE_HAND[%d][%d]' %
+           (MINUTE_POSITIONS, len(MINUTE_HAND)),
+           [_rotate(MINUTE_HAND, TRIG_MAX_ANGLE * i // MINUTE_POSITIONS,
+                    cx, cy) for i in range(MINUTE_POSITIONS)])
+    _table(lines, 'GPoint SECOND_HAND[%d][%d]' %
+           (MINUTE_POSITIONS, len(SECOND_HAND)),
+           [_rotate(SECOND_HAND, TRIG_MAX_ANGLE * i // MINUTE_POSITIONS,
+                    cx, cy) for i in range(MINUTE_POSITIONS)])
+    _table(lines, 'GPoint HOUR_HAND[%d][%d]' %
+           (HOUR_POSITIONS, len(HOUR_HAND)),
+           [_rotate(HOUR_HAND, TRIG_MAX_ANGLE * i // HOUR_POSITIONS,
+                    cx, cy) for i in range(HOUR_POSITIONS)])
+    return lines
+
+
+def generate(out_path, platforms):
+    """Write the header for platforms, a {name: geometry} mapping."""
+    lines = [
+        '// Generated by tools/dial_geometry.py from wscript. Do not edit.',
+        '#pragma once',
+        '',
+        '#include <pebble.h>',
+        '',
+        '#include "../raster.h"',
+        '',
+        '#define MINUTE_HAND_POSITIONS %d' % MINUTE_POSITIONS,
+        '#define HOUR_HAND_POSITIONS %d' % HOUR_POSITIONS,
+        '#define HAND_POINTS %d' % len(MINUTE_HAND),
+        '#define SUN_RAY_COUNT %d' % SUN_RAYS,
+        '',
+    ]
+    lines.extend(_sky_block())
+    lines.extend(_star_block())
+    keyword = '#if'
+    for name in sorted(platforms):
+        lines.append('%s defined(PBL_PLATFORM_%s)' % (keyword, name.upper()))
+        lines.extend(_platform_block(platforms[name]))
+        keyword = '#elif'
+    lines += [
+        '#else',
+        '#error "No dial geometry generated for this platform"',
+        '#endif',
+        '',
+    ]
+    genutil.write_if_changed(out_path, '\n'.join(lines).encode())
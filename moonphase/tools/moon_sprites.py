@@ -0,0 +1,77 @@
+"""Pre-render the moon phase subdial as a vertical sprite sheet.
+
+One sprite for each of NUM_PHASES evenly spaced phase angles, stacked
+top to bottom, using the same scanline construction draw_moon() used to
+run on the watch every frame. The outline is left to the watch so it keeps its antialiasing.
+
+A colour sheet and a ~bw variant are emitted; the SDK's bitmap pipeline
+packs each into the smallest format its platforms load.
+"""
+
+import math
+import os
+
+import genutil
+import pngio
+
+NUM_PHASES = 30
+TRIG_MAX_ANGLE = 0x10000
+TRIG_MAX_RATIO = 0xffff
+
+# (sky, unlit disc, lit crescent)
+COLOR_PALETTE = [(0, 0, 0), (0, 0, 85), (255, 255, 170)]
+BW_PALETTE = [(0, 0, 0), (0, 0, 0), (255, 255, 255)]
+SKY, DISC, LIT = range(3)
+
+
+def _isqrt(n):
+    x = 1
+    while x * x <= n:
+        x += 1
+    return x - 1
+
+
+def _cos_lookup(angle):
+    return int(round(math.cos(2 * math.pi * angle / TRIG_MAX_ANGLE) *
+                     TRIG_MAX_RATIO))
+
+
+def _trunc_div(a, b):
+    # C integer division truncates towards zero
+    q = abs(a) // abs(b)
+    return q if (a < 0) == (b < 0) else -q
+
+
+def render_phase(r, phase_angle):
+    size = 2 * r + 1
+    px = [SKY] * (size * size)
+
+    for dy in range(-r, r + 1):
+        for dx in range(-r, r + 1):
+            if dx * dx + dy * dy <= r * r + r:
+                px[(dy + r) * size + dx + r] = DISC
+
+    cos_phase = _cos_lookup(phase_angle)
+    waxing = phase_angle < TRIG_MAX_ANGLE // 2
+    for dy in range(-(r - 1), r):
+        cw = _isqrt(r * r - dy * dy)
+        if cw == 0:
+            continue
+        tx = _trunc_div(cw * cos_phase, TRIG_MAX_RATIO)
+        x1, x2 = (tx, cw) if waxing else (-cw, -tx)
+        for dx in range(x1, x2 + 1):
+            px[(dy + r) * size + dx + r] = LIT
+    return px
+
+
+def generate(out_dir, radius):
+    size = 2 * radius + 1
+    pixels = []
+    for i in range(NUM_PHASES):
+        pixels.extend(render_phase(radius, i * TRIG_MAX_ANGLE // NUM_PHASES))
+
+    height = size * NUM_PHASES
+    for name, palette in (('moon-phases.png', COLOR_PALETTE),
+                          ('moon-phases~bw.png', BW_PALETTE)):
+        png = pngio.encode_palette(size, height, palette, pixels)
+        genutil.write_if_changed(os.path.join(out_dir, name), png)
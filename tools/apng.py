@@ -0,0 +1,191 @@
+"""Re-encode an APNG so the watch decodes as little as possible per frame.
+
+usage: apng.py IN OUT
+
+The firmware decodes each frame of a GBitmapSequence straight into the
+app's bitmap, inflating and unfiltering the frame's whole rectangle at
+the image's bit depth, so its cost follows the frame's area and depth.
+The rewritten animation:
+
+  - is in the colours the display has: every pixel snapped to the
+    nearest of the 64 (and 4 alpha levels), the palette only those
+    used and the bit depth the smallest that holds them
+  - has each frame cropped to the pixels that differ from the frame
+    before it, as the watch shows them, with APNG_DISPOSE_OP_NONE so
+    nothing is restored, and APNG_BLEND_OP_OVER with the pixels in the
+    crop that did not change left clear, which inflate from a few bytes
+    (frames that make a pixel clear are drawn with APNG_BLEND_OP_SOURCE)
+  - folds frames that change nothing into the delay of the one before
+
+Frame 0 stays the whole image, so restarting the sequence needs nothing
+else. Playback looks the same on the watch as the original.
+"""
+
+import os
+import struct
+import sys
+import zlib
+
+import genutil
+import pngio
+
+# fcTL dispose_op and blend_op
+DISPOSE_NONE, DISPOSE_BACKGROUND, DISPOSE_PREVIOUS = range(3)
+BLEND_SOURCE, BLEND_OVER = range(2)
+
+CLEAR = (0, 0, 0, 0)
+
+
+def _blend(dst, src):
+    a = src[3]
+    if a == 255 or a == 0 and dst[3] == 0:
+        return src if a else dst
+    if a == 0:
+        return dst
+    ia = 255 - a
+    out_a = a + dst[3] * ia // 255
+    return tuple((src[k] * a + dst[k] * dst[3] * ia // 255) // out_a
+                 for k in range(3)) + (out_a,)
+
+
+def decode(data):
+    """(width, height, num_plays, frames) of an APNG, each frame a
+    (delay_ms, canvas) pair with canvas the whole image as shown, a flat
+    row-major list of (r, g, b, a) tuples."""
+    header, controls, num_plays = pngio.Header(), [], 0
+    for kind, body in pngio.read_chunks(data):
+        if header.read(kind, body):
+            continue
+        if kind == b'acTL':
+            num_plays = struct.unpack('>II', body)[1]
+        elif kind == b'fcTL':
+            controls.append([struct.unpack('>IIIIIHHBB', body), b''])
+        elif kind == b'IDAT' and controls:
+            controls[-1][1] += body
+        elif kind == b'fdAT':
+            controls[-1][1] += body[4:]
+
+    width, height = header.width, header.height
+    canvas = [CLEAR] * (width * height)
+    frames = []
+    for (_, w, h, x0, y0, num, den, dispose, blend), zdata in controls:
+        saved = list(canvas)
+        pixels = header.decode(zdata, w, h)
+        for y in range(h):
+            for x in range(w):
+                i = (y0 + y) * width + x0 + x
+                src = pixels[y * w + x]
+                canvas[i] = src if blend == BLEND_SOURCE else \
+                    _blend(canvas[i], src)
+        frames.append((num * 1000 // (den or 100), list(canvas)))
+        if dispose == DISPOSE_BACKGROUND:
+            for y in range(y0, y0 + h):
+                canvas[y * width + x0:y * width + x0 + w] = [CLEAR] * w
+        elif dispose == DISPOSE_PREVIOUS:
+            canvas = saved
+    return width, height, num_plays, frames
+
+
+def _native(rgba):
+    """The colour as the display holds it: 4 levels a channel."""
+    if rgba[3] == 0:
+        return CLEAR
+    return tuple((v + 42) // 85 * 85 for v in rgba)
+
+
+def _changed(width, height, before, after):
+    """Bounding box (x, y, w, h) of the pixels that differ, or None."""
+    xs, ys = [], []
+    for y in range(height):
+        row = y * width
+        for x in range(width):
+            if before[row + x] != after[row + x]:
+                xs.append(x)
+                ys.append(y)
+    if not xs:
+        return None
+    return (min(xs), min(ys), max(xs) - min(xs) + 1, max(ys) - min(ys) + 1)
+
+
+def encode(width, height, num_plays, frames):
+    """The optimized APNG of frames, (delay_ms, canvas) pairs as decode()
+    gives them."""
+    frames = [(delay, [_native(p) for p in canvas])
+              for delay, canvas in frames]
+
+    # [x, y, w, h, delay_ms, canvas] of each frame kept
+    kept = []
+    for delay, canvas in frames:
+        box = (0, 0, width, height) if not kept else \
+            _changed(width, height, kept[-1][5], canvas)
+        if box is None:
+            kept[-1][4] += delay
+        else:
+            kept.append(list(box) + [delay, canvas])
+
+    # (blend_op, colours) of each kept frame's crop
+    crops = []
+    for n, (x0, y0, w, h, _, canvas) in enumerate(kept):
+        rows = [range(y * width + x0, y * width + x0 + w)
+                for y in range(y0, y0 + h)]
+        colours = [canvas[i] for row in rows for i in row]
+        before = kept[n - 1][5] if n else None
+        if before is None or any(canvas[i] == CLEAR != before[i]
+                                 for row in rows for i in row):
+            crops.append((BLEND_SOURCE, colours))
+        else:
+            crops.append((BLEND_OVER, [CLEAR if canvas[i] == before[i] else
+                                       canvas[i] for row in rows
+                                       for i in row]))
+
+    counts = {}
+    for _, colours in crops:
+        for c in colours:
+            counts[c] = counts.get(c, 0) + 1
+    palette = sorted(counts, key=lambda c: (-counts[c], c))
+    index = {c: i for i, c in enumerate(palette)}
+    depth = next(d for d in (1, 2, 4, 8) if len(palette) <= 1 << d)
+
+    out = [pngio.SIGNATURE,
+           pngio.chunk(b'IHDR', struct.pack('>IIBBBBB', width, height,
+                                            depth, 3, 0, 0, 0)),
+           pngio.chunk(b'acTL', struct.pack('>II', len(kept), num_plays)),
+           pngio.palette_chunks(palette)]
+    sequence = 0
+    for n, (x0, y0, w, h, delay, _) in enumerate(kept):
+        blend, colours = crops[n]
+        out.append(pngio.chunk(b'fcTL', struct.pack(
+            '>IIIIIHHBB', sequence, w, h, x0, y0, min(delay, 0xffff), 1000,
+            DISPOSE_NONE, blend)))
+        sequence += 1
+        zdata = zlib.compress(pngio.pack_indices(
+            w, h, [index[c] for c in colours], depth), 9)
+        if n == 0:
+            out.append(pngio.chunk(b'IDAT', zdata))
+        else:
+            out.append(pngio.chunk(b'fdAT',
+                                   struct.pack('>I', sequence) + zdata))
+            sequence += 1
+    out.append(pngio.chunk(b'IEND', b''))
+    return b''.join(out)
+
+
+def optimize(data):
+    return encode(*decode(data))
+
+
+def generate(in_path, out_path):
+    if genutil.up_to_date(out_path, in_path, __file__, pngio.__file__):
+        return
+    with open(in_path, 'rb') as f:
+        data = optimize(f.read())
+    # Brought up to date even when unchanged, so it is not redone on every
+    # build after this tool changes
+    if not genutil.write_if_changed(out_path, data):
+        os.utime(out_path)
+
+
+if __name__ == '__main__':
+    if len(sys.argv) != 3:
+        sys.exit(__doc__)
+    generate(*sys.argv[1:])
@@ -0,0 +1,357 @@
+"""Per-platform bitmap variants from one master image, and a size report.
+
+usage: assets.py FACE_DIR
+
+Each variant of a master is scaled to the width it is shown at, cropped
+to the display on round platforms, and reduced to what the platform
+shows: on colour platforms the master's own colours snapped to the 64 the
+display has, every one of them kept; on black-and-white platforms an
+ordered dither. Each is written as the smallest palette PNG that holds
+it, so the SDK loads it in the smallest bitmap format. An APNG master's
+variants are laid out frame by frame and written as apng.py optimizes
+them. Variants are named with the SDK's ~tags, so the build picks the
+right one for each platform.
+
+Run as a script, it prints the size report the faces' wscripts print on
+every build: for each platform, each resource's file size and the heap
+its bitmap takes once loaded.
+"""
+
+import json
+import os
+import sys
+
+import apng
+import genutil
+import pngio
+
+# Display size, colour, round
+PLATFORMS = {
+    'aplite': ((144, 168), False, False),
+    'basalt': ((144, 168), True, False),
+    'chalk': ((180, 180), True, True),
+    'diorite': ((144, 168), False, False),
+    'emery': ((200, 228), True, False),
+    'flint': ((144, 168), False, False),
+}
+
+# Colour platforms have 4 levels (0, 85, 170, 255) per channel
+LEVEL = 85
+
+# Black and white tone range, in luma
+BLACK_POINT = 104
+WHITE_POINT = 176
+BAYER_4X4 = [[0, 8, 2, 10], [12, 4, 14, 6], [3, 11, 1, 9], [15, 7, 13, 5]]
+
+CLEAR = (0, 0, 0, 0)
+
+
+# ---- Resource resolution ----
+
+def platform_tags(platform):
+    _, colour, round_ = PLATFORMS[platform]
+    return {
+        platform,
+        'color' if colour else 'bw',
+        'round' if round_ else 'rect',
+    }
+
+
+def resolve(resources_dir, file_name, platform):
+    """Most specific ~tagged variant of file_name that applies."""
+    stem, ext = os.path.splitext(file_name)
+    directory = os.path.join(resources_dir, os.path.dirname(stem))
+    base = os.path.basename(stem)
+    tags = platform_tags(platform)
+
+    best, best_tags = os.path.join(resources_dir, file_name), -1
+    for name in sorted(os.listdir(directory)):
+        name_stem, name_ext = os.path.splitext(name)
+        parts = name_stem.split('~')
+        if name_ext != ext or parts[0] != base:
+            continue
+        if set(parts[1:]) <= tags and len(parts) - 1 > best_tags:
+            best, best_tags = os.path.join(directory, name), len(parts) - 1
+    return best
+
+
+# ---- Geometry ----
+
+def _weights(src, dst):
+    """For each of dst output samples, the (source index, weight) pairs of
+    the source span it covers."""
+    out = []
+    for i in range(dst):
+        lo, hi = i * src / float(dst), (i + 1) * src / float(dst)
+        taps, j = [], int(lo)
+        while j < hi and j < src:
+            overlap = min(hi, j + 1) - max(lo, j)
+            if overlap > 0:
+                taps.append((j, overlap))
+            j += 1
+        total = sum(w for _, w in taps)
+        out.append([(j, w / total) for j, w in taps])
+    return out
+
+
+def scale(width, height, pixels, new_width, new_height):
+    """Area-average resample, with alpha premultiplied so clear pixels do
+    not darken edges."""
+    if (new_width, new_height) == (width, height):
+        return pixels
+    pre = [(r * a, g * a, b * a, a) for r, g, b, a in pixels]
+
+    rows = []
+    xw = _weights(width, new_width)
+    for y in range(height):
+        row = pre[y * width:(y + 1) * width]
+        rows.append([tuple(sum(row[j][c] * w for j, w in taps)
+                           for c in range(4)) for taps in xw])
+
+    out = []
+    for taps in _weights(height, new_height):
+        for x in range(new_width):
+            r, g, b, a = (sum(rows[j][x][c] * w for j, w in taps)
+                          for c in range(4))
+            if a < 1:
+                out.append(CLEAR)
+            else:
+                out.append((int(r / a + 0.5), int(g / a + 0.5),
+                            int(b / a + 0.5), int(a + 0.5)))
+    return out
+
+
+def crop_round(width, height, pixels, origin, diameter):
+    """Clear the pixels that fall outside a round display, the image's top
+    left corner being at origin on it."""
+    r2 = diameter * diameter
+    out = list(pixels)
+    for y in range(height):
+        dy = 2 * (origin[1] + y) + 1 - diameter
+        for x in range(width):
+            dx = 2 * (origin[0] + x) + 1 - diameter
+            if dx * dx + dy * dy > r2:
+                out[y * width + x] = CLEAR
+    return out
+
+
+# ---- Colour ----
+
+def _level(v):
+    return (v + LEVEL // 2) // LEVEL
+
+
+def _to_levels(rgba):
+    """Nearest colour platform colour as levels, or CLEAR."""
+    if rgba[3] < 128:
+        return CLEAR
+    return tuple(_level(v) for v in rgba[:3]) + (3,)
+
+
+def _distance(a, b):
+    return sum((x - y) * (x - y) for x, y in zip(a[:3], b[:3]))
+
+
+def colour_palette(pixels):
+    """Every colour of pixels as levels, the most used first. Colours the
+    display cannot tell apart are one colour here, and no others fold, so
+    no pixel changes."""
+    counts = {}
+    for c in (_to_levels(p) for p in pixels):
+        counts[c] = counts.get(c, 0) + 1
+    counts.pop(CLEAR, None)
+    return sorted(counts, key=lambda c: (-counts[c], c))
+
+
+def snap(pixels, palette):
+    """(palette, indices) of pixels snapped to the nearest of palette, in
+    levels, keeping only the colours used, most used first. Ties go to
+    the colour earlier in palette."""
+    nearest, counts, levels = {}, {}, []
+    rank = {q: i for i, q in enumerate(palette)}
+    for p in pixels:
+        c = _to_levels(p)
+        if c not in nearest:
+            nearest[c] = c if c == CLEAR else \
+                min(palette, key=lambda q: (_distance(c, q), rank[q]))
+        c = nearest[c]
+        levels.append(c)
+        counts[c] = counts.get(c, 0) + 1
+
+    used = sorted(counts, key=lambda c: (-counts[c], c))
+    index = {c: i for i, c in enumerate(used)}
+    rgba = [CLEAR if c == CLEAR else tuple(v * LEVEL for v in c[:3]) + (255,)
+            for c in used]
+    return rgba, [index[c] for c in levels]
+
+
+# ---- Black and white ----
+
+def dither_bw(width, pixels):
+    """(palette, indices) of an ordered dither to black and white, with
+    clear kept clear.
+
+    Luma at or above WHITE_POINT is plain white and at or below
+    BLACK_POINT plain black, so flat light backgrounds and dark outlines
+    stay solid and only the mid tones get a pattern, as the moonphase sky
+    does.
+    """
+    out = []
+    for i, (r, g, b, a) in enumerate(pixels):
+        if a < 128:
+            out.append(2)
+            continue
+        luma = (r * 299 + g * 587 + b * 114) // 1000
+        level = (luma - BLACK_POINT) * 16 // (WHITE_POINT - BLACK_POINT)
+        x, y = i % width, i // width
+        out.append(1 if level > BAYER_4X4[y % 4][x % 4] else 0)
+    palette = [(0, 0, 0, 255), (255, 255, 255, 255)]
+    if 2 in out:
+        palette.append(CLEAR)
+    return palette, out
+
+
+# ---- Variants ----
+
+def _depth(colours):
+    return next(d for d in (1, 2, 4, 8) if colours <= 1 << d)
+
+
+def _lay_out(width, height, pixels, platform, new_width):
+    """(new_height, pixels) of an image scaled to new_width, keeping its
+    aspect, and laid out at the bottom of platform's display, centred,
+    which is where round displays crop it."""
+    (display_w, display_h), _, round_ = PLATFORMS[platform]
+    new_height = (height * new_width + width // 2) // width
+    pixels = scale(width, height, pixels, new_width, new_height)
+    if round_:
+        pixels = crop_round(new_width, new_height, pixels,
+                            ((display_w - new_width) // 2,
+                             display_h - new_height), display_w)
+    return new_height, pixels
+
+
+def _out_path(out_dir, name, tag):
+    return os.path.join(out_dir, name + ('~' + tag if tag else '') + '.png')
+
+
+def generate(master_path, out_dir, name, variants):
+    """Write name~tag.png for each (tag, platform, width) in variants, the
+    master laid out on platform's display at width. An empty tag is the
+    untagged default.
+    """
+    with open(master_path, 'rb') as f:
+        width, height, master = pngio.decode(f.read())
+
+    for tag, platform, new_width in variants:
+        colour = PLATFORMS[platform][1]
+        new_height, pixels = _lay_out(width, height, master, platform,
+                                      new_width)
+        if colour:
+            rgba, indices = snap(pixels, colour_palette(pixels))
+        else:
+            rgba, indices = dither_bw(new_width, pixels)
+        genutil.write_if_changed(
+            _out_path(out_dir, name, tag),
+            pngio.encode_palette(new_width, new_height, rgba, indices,
+                                 _depth(len(rgba))))
+
+
+def generate_animation(master_path, out_dir, name, variants):
+    """Like generate(), for an APNG master and colour platforms: every
+    frame is laid out the same way and the result re-encoded as
+    apng.optimize() does. Scaling every frame is slow, so the variants
+    are only remade when the master or these tools change, and by one
+    build at a time.
+    """
+    tools = (__file__, apng.__file__, pngio.__file__)
+    paths = [_out_path(out_dir, name, tag) for tag, _, _ in variants]
+    with genutil.lock(os.path.join(out_dir, name + '.lock')):
+        if all(genutil.up_to_date(path, master_path, *tools)
+               for path in paths):
+            return
+        with open(master_path, 'rb') as f:
+            width, height, num_plays, frames = apng.decode(f.read())
+
+        for path, (_, platform, new_width) in zip(paths, variants):
+            assert PLATFORMS[platform][1], 'animations are colour only'
+            laid_out = [(delay, _lay_out(width, height, canvas, platform,
+                                         new_width))
+                        for delay, canvas in frames]
+            data = apng.encode(new_width, laid_out[0][1][0], num_plays,
+                               [(delay, pixels)
+                                for delay, (_, pixels) in laid_out])
+            # Touched when unchanged too, or up_to_date() would fail and
+            # every later build would rescale it
+            if not genutil.write_if_changed(path, data):
+                os.utime(path)
+
+
+# ---- Size report ----
+
+def _native(rgba, colour):
+    """A pixel as the platform stores it."""
+    if colour:
+        return _to_levels(rgba)
+    if rgba[3] < 128:
+        return CLEAR
+    return (rgba[0] * 299 + rgba[1] * 587 + rgba[2] * 114) // 1000 >= 128
+
+
+def bitmap_format(path, colour):
+    """(format, heap bytes) the SDK's smallest format gives a PNG, pixel
+    data and palette, as host/src/bitmap.c picks it."""
+    with open(path, 'rb') as f:
+        width, height, pixels = pngio.decode(f.read())
+    colours = set(_native(p, colour) for p in pixels)
+    if not colour and CLEAR not in colours:
+        return '1Bit', (width + 31) // 32 * 4 * height
+    if len(colours) > 16:
+        return '8Bit', width * height
+    depth = _depth(len(colours))
+    return ('%dBitPalette' % depth,
+            (width * depth + 7) // 8 * height + (1 << depth))
+
+
+def resource_sizes(face_dir, platform):
+    """(path, file bytes, heap bytes, format) of each resource that goes
+    into the face's build for platform, path relative to its resources
+    directory. Heap bytes and format are None for raw resources."""
+    with open(os.path.join(face_dir, 'package.json')) as f:
+        media = json.load(f)['pebble']['resources']['media']
+    resources_dir = os.path.join(face_dir, 'resources')
+    colour = PLATFORMS[platform][1]
+
+    rows = []
+    for entry in media:
+        targets = entry.get('targetPlatforms')
+        if targets and platform not in targets:
+            continue
+        path = resolve(resources_dir, entry['file'], platform)
+        fmt, heap = None, None
+        if entry['type'] in ('bitmap', 'png'):
+            fmt, heap = bitmap_format(path, colour)
+        rows.append((os.path.relpath(path, resources_dir),
+                     os.path.getsize(path), heap, fmt or entry['type']))
+    return rows
+
+
+def report(face_dir, out=sys.stdout):
+    with open(os.path.join(face_dir, 'package.json')) as f:
+        pebble = json.load(f)['pebble']
+
+    for platform in pebble['targetPlatforms']:
+        out.write('%s resources on %s:\n' % (pebble['displayName'], platform))
+        out.write('  %-32s %7s %7s  %s\n' % ('', 'file', 'heap', 'format'))
+        rows = resource_sizes(face_dir, platform)
+        for path, size, heap, fmt in rows:
+            out.write('  %-32s %7d %7s  %s\n' % (
+                path, size, '-' if heap is None else heap, fmt))
+        out.write('  %-32s %7d %7d\n' % (
+            'total', sum(r[1] for r in rows),
+            sum(r[2] or 0 for r in rows)))
+
+if __name__ == '__main__':
+    if len(sys.argv) != 2:
+        sys.exit(__doc__)
+    report(sys.argv[1])
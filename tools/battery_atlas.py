@@ -0,0 +1,38 @@
+"""Stack the battery icons in common/resources into one atlas resource.
+
+Both faces show the same five 20x20 icons. Stacked top to bottom in
+ICONS order they are one resource, loaded once; the status bar picks an
+icon by moving a sub-bitmap over the atlas (see status_bar.c).
+"""
+
+import os
+
+import genutil
+import pngio
+
+# Must match StatusBarIcon in common/src/c/status_bar.c
+ICONS = ['battery-charge', 'battery', 'battery-healthy', 'half-battery',
+         'low-battery']
+ICON_SIZE = 20
+
+
+def generate(icon_dir, out_path):
+    palette, index, pixels = [], {}, []
+    for name in ICONS:
+        with open(os.path.join(icon_dir, name + '.png'), 'rb') as f:
+            width, height, icon = pngio.decode(f.read())
+        if (width, height) != (ICON_SIZE, ICON_SIZE):
+            raise ValueError('%s.png is %dx%d, expected %dx%d' %
+                             (name, width, height, ICON_SIZE, ICON_SIZE))
+        for rgba in icon:
+            if rgba[3] == 0:
+                rgba = (0, 0, 0, 0)
+            if rgba not in index:
+                index[rgba] = len(palette)
+                palette.append(rgba)
+            pixels.append(index[rgba])
+    if len(palette) > 256:
+        raise ValueError('battery icons use %d colours, at most 256 fit' %
+                         len(palette))
+    genutil.write_if_changed(out_path, pngio.encode_palette(
+        ICON_SIZE, ICON_SIZE * len(ICONS), palette, pixels))
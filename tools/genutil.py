@@ -0,0 +1,48 @@
+"""Helpers shared by the build-time generators."""
+
+import contextlib
+import fcntl
+import os
+
+
+def write_if_changed(path, data):
+    """Write data to path unless it already holds exactly that.
+
+    Leaving unchanged outputs alone keeps incremental builds incremental.
+    """
+    if os.path.exists(path):
+        with open(path, 'rb') as f:
+            if f.read() == data:
+                return False
+    os.makedirs(os.path.dirname(path), exist_ok=True)
+    # Renamed into place, as parallel host builds of one face run its
+    # generators side by side
+    tmp = '%s.%d.tmp' % (path, os.getpid())
+    with open(tmp, 'wb') as f:
+        f.write(data)
+    os.replace(tmp, path)
+    return True
+
+
+def up_to_date(path, *inputs):
+    """Whether path exists and is newer than every one of inputs.
+
+    For generators too slow to rerun on every build.
+    """
+    if not os.path.exists(path):
+        return False
+    mtime = os.path.getmtime(path)
+    return all(os.path.getmtime(i) <= mtime for i in inputs)
+
+
+@contextlib.contextmanager
+def lock(path):
+    """Hold an exclusive lock on path, created if need be, for the block,
+    so generators that parallel builds share run one at a time."""
+    os.makedirs(os.path.dirname(path), exist_ok=True)
+    with open(path, 'a') as f:
+        fcntl.flock(f, fcntl.LOCK_EX)
+        try:
+            yield
+        finally:
+            fcntl.flock(f, fcntl.LOCK_UN)
@@ -0,0 +1,188 @@
+"""Minimal PNG reader and writer for build-time generated resources.
+
+Only what the resource generators need: writing palette images, and
+reading non-interlaced 8-bit-or-less images of any colour type. Kept
+dependency-free so it runs under the Python that ships with the Pebble
+SDK. The chunk and pixel helpers are shared with apng.py.
+"""
+
+import struct
+import zlib
+
+SIGNATURE = b'\x89PNG\r\n\x1a\n'
+
+
+def chunk(kind, data):
+    body = kind + data
+    return struct.pack('>I', len(data)) + body + \
+        struct.pack('>I', zlib.crc32(body) & 0xffffffff)
+
+
+def read_chunks(data):
+    """(kind, body) of each chunk up to IEND."""
+    if data[:8] != SIGNATURE:
+        raise ValueError('not a PNG')
+    pos = 8
+    while pos < len(data):
+        length, kind = struct.unpack('>I4s', data[pos:pos + 8])
+        yield kind, data[pos + 8:pos + 8 + length]
+        pos += 12 + length
+        if kind == b'IEND':
+            break
+
+
+def palette_chunks(palette):
+    """PLTE, and tRNS if any entry is not opaque."""
+    out = chunk(b'PLTE', b''.join(struct.pack('BBB', *c[:3])
+                                  for c in palette))
+    if any(len(c) == 4 and c[3] != 255 for c in palette):
+        out += chunk(b'tRNS', bytes(c[3] if len(c) == 4 else 255
+                                    for c in palette))
+    return out
+
+
+def pack_indices(width, height, pixels, depth):
+    """Unfiltered scanlines of palette indices at depth bits per pixel."""
+    per_byte = 8 // depth
+    raw = bytearray()
+    for y in range(height):
+        raw.append(0)
+        row = pixels[y * width:(y + 1) * width]
+        for x in range(0, width, per_byte):
+            byte = 0
+            for i, index in enumerate(row[x:x + per_byte]):
+                byte |= index << (8 - depth * (i + 1))
+            raw.append(byte)
+    return bytes(raw)
+
+
+def encode_palette(width, height, palette, pixels, depth=8):
+    """Encode a palettized PNG of 1, 2, 4 or 8 bits per pixel.
+
+    palette is a list of (r, g, b) or (r, g, b, a) tuples, pixels a flat
+    list of palette indices in row-major order.
+    """
+    if len(palette) > 1 << depth:
+        raise ValueError('%d colours do not fit in %d bits' %
+                         (len(palette), depth))
+    ihdr = struct.pack('>IIBBBBB', width, height, depth, 3, 0, 0, 0)
+    raw = pack_indices(width, height, pixels, depth)
+    return SIGNATURE + chunk(b'IHDR', ihdr) + palette_chunks(palette) + \
+        chunk(b'IDAT', zlib.compress(raw, 9)) + chunk(b'IEND', b'')
+
+
+# Samples per pixel of each colour type
+_CHANNELS = {0: 1, 2: 3, 3: 1, 4: 2, 6: 4}
+
+
+def _paeth(a, b, c):
+    p = a + b - c
+    pa, pb, pc = abs(p - a), abs(p - b), abs(p - c)
+    if pa <= pb and pa <= pc:
+        return a
+    return b if pb <= pc else c
+
+
+def _unfilter(raw, height, stride, bpp):
+    rows, prev, pos = [], bytearray(stride), 0
+    for _ in range(height):
+        kind = raw[pos]
+        row = bytearray(raw[pos + 1:pos + 1 + stride])
+        pos += 1 + stride
+        for i in range(stride):
+            a = row[i - bpp] if i >= bpp else 0
+            b = prev[i]
+            c = prev[i - bpp] if i >= bpp else 0
+            if kind == 1:
+                row[i] = (row[i] + a) & 0xff
+            elif kind == 2:
+                row[i] = (row[i] + b) & 0xff
+            elif kind == 3:
+                row[i] = (row[i] + (a + b) // 2) & 0xff
+            elif kind == 4:
+                row[i] = (row[i] + _paeth(a, b, c)) & 0xff
+        rows.append(row)
+        prev = row
+    return rows
+
+
+class Header(object):
+    """What decoding pixels needs from IHDR, PLTE and tRNS."""
+
+    def __init__(self):
+        self.width = self.height = self.depth = self.color = None
+        self.palette, self.trns = [], None
+
+    def read(self, kind, body):
+        """Take in a chunk, returning whether it was one of those."""
+        if kind == b'IHDR':
+            self.width, self.height, self.depth, self.color, _, _, \
+                interlace = struct.unpack('>IIBBBBB', body)
+            if self.depth > 8 or interlace:
+                raise ValueError('unsupported PNG: depth %d, interlace %d'
+                                 % (self.depth, interlace))
+        elif kind == b'PLTE':
+            self.palette = [tuple(body[i:i + 3]) + (255,)
+                            for i in range(0, len(body), 3)]
+        elif kind == b'tRNS':
+            self.trns = body
+        else:
+            return False
+        return True
+
+    def decode(self, zdata, width, height):
+        """A flat row-major list of (r, g, b, a) tuples."""
+        depth, color, trns = self.depth, self.color, self.trns
+        channels = _CHANNELS[color]
+        stride = (width * channels * depth + 7) // 8
+        rows = _unfilter(zlib.decompress(zdata), height, stride,
+                         max(1, channels * depth // 8))
+
+        palette = self.palette
+        if trns and color == 3:
+            palette = [c[:3] + (trns[i] if i < len(trns) else 255,)
+                       for i, c in enumerate(palette)]
+        key = struct.unpack('>%dH' % (len(trns) // 2), trns) if trns and \
+            color in (0, 2) else None
+        scale = 255 // ((1 << depth) - 1)
+
+        pixels = []
+        for row in rows:
+            if depth < 8:
+                per_byte = 8 // depth
+                mask = (1 << depth) - 1
+                samples = [(row[i // per_byte] >>
+                            (8 - depth * (i % per_byte + 1))) & mask
+                           for i in range(width * channels)]
+            else:
+                samples = row
+            for x in range(width):
+                s = samples[x * channels:(x + 1) * channels]
+                if color == 3:
+                    pixels.append(palette[s[0]])
+                    continue
+                alpha = 255
+                if key is not None and tuple(s) == key:
+                    alpha = 0
+                if color in (0, 4):
+                    v = s[0] * (scale if color == 0 else 1)
+                    pixels.append((v, v, v, s[1] if color == 4 else alpha))
+                else:
+                    pixels.append((s[0], s[1], s[2],
+                                   s[3] if color == 6 else alpha))
+        return pixels
+
+
+def decode(data):
+    """Decode a PNG to (width, height, pixels).
+
+    pixels is a flat row-major list of (r, g, b, a) tuples.
+    """
+    header, idat = Header(), b''
+    for kind, body in read_chunks(data):
+        if kind == b'IDAT':
+            idat += body
+        else:
+            header.read(kind, body)
+    return header.width, header.height, \
+        header.decode(idat, header.width, header.height)
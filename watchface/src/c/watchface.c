@@ -1,12 +1,173 @@
 #include <pebble.h>
 
+#include "heap_trace.h"
+#include "profile.h"
+#include "status_bar.h"
+
 static Window *s_window;
-static GBitmap *s_bitmap;
-static BitmapLayer *s_bitmap_layer;
+static Layer *s_hero_layer;
 static TextLayer *s_time_layer;
-static TextLayer *s_battery_layer;
-static GBitmap *s_battery_icon = NULL;
-static BitmapLayer *s_battery_icon_layer;
+
+// ---- Hero cache ----
+//
+// The hero is composited over the background once and drawn with
+// GCompOpAssign on every later frame, so the minute's redraw is a copy
+// rather than a blend. On colour displays the artwork is composited in
+// place: its clear pixels, or clear palette entries, take the background
+// colour, so the cache takes no heap beyond the artwork's own. On
+// black-and-white displays it is copied out of the frame buffer in the
+// display's own format instead, and the artwork is only loaded while that
+// copy is made. If the cache cannot be made, the artwork stays loaded and
+// is blended every frame as before.
+
+#define HERO_HEAP_RESERVE 4096
+
+// A theme would change this and mark the hero layer dirty
+static GColor s_background;
+static GBitmap *s_hero;
+#ifdef PBL_BW
+static GBitmap *s_hero_cache;
+#endif
+// The background the cache was built over; clear while it holds nothing
+static GColor s_hero_cache_background;
+// Where the artwork goes in the layer, and the part of the layer cached.
+// On black-and-white displays the cached part is widened to whole bytes.
+static GRect s_hero_rect;
+static GRect s_cache_rect;
+
+static void hero_load() {
+  if (!s_hero) {
+    s_hero = gbitmap_create_with_resource(RESOURCE_ID_ff34a9607b6df8921e81c1f2722fc55b);
+  }
+}
+
+static void hero_cache_create(GRect layer_frame) {
+  GSize size = gbitmap_get_bounds(s_hero).size;
+  s_hero_rect = GRect((layer_frame.size.w - size.w) / 2,
+                      (layer_frame.size.h - size.h) / 2, size.w, size.h);
+  s_cache_rect = s_hero_rect;
+  s_hero_cache_background = GColorClear;
+#ifdef PBL_BW
+  int x0 = (layer_frame.origin.x + s_hero_rect.origin.x) / 8 * 8;
+  int x1 = (layer_frame.origin.x + s_hero_rect.origin.x + size.w + 7) / 8 * 8;
+  s_cache_rect.origin.x = x0 - layer_frame.origin.x;
+  s_cache_rect.size.w = x1 - x0;
+
+  // 1-bit rows are padded to a 32-bit word
+  size_t bytes = (s_cache_rect.size.w + 31) / 32 * 4 * s_cache_rect.size.h;
+  s_hero_cache = NULL;
+  if (heap_bytes_free() >= bytes + HERO_HEAP_RESERVE) {
+    s_hero_cache = gbitmap_create_blank(s_cache_rect.size, GBitmapFormat1Bit);
+  }
+#endif
+}
+
+#ifdef PBL_COLOR
+// Composite the artwork over the background in place. Leaves it as it was
+// and returns false if it has partly transparent colours.
+static bool hero_composite(void) {
+  GColor *colours;
+  int count;
+  switch (gbitmap_get_format(s_hero)) {
+    case GBitmapFormat8Bit:
+      colours = (GColor *)gbitmap_get_data(s_hero);
+      count = gbitmap_get_bytes_per_row(s_hero) * s_hero_rect.size.h;
+      break;
+    case GBitmapFormat1BitPalette:
+      colours = gbitmap_get_palette(s_hero);
+      count = 2;
+      break;
+    case GBitmapFormat2BitPalette:
+      colours = gbitmap_get_palette(s_hero);
+      count = 4;
+      break;
+    case GBitmapFormat4BitPalette:
+      colours = gbitmap_get_palette(s_hero);
+      count = 16;
+      break;
+    default:
+      return false;
+  }
+
+  for (int i = 0; i < count; i++) {
+    if (colours[i].a != 0 && colours[i].a != 3) {
+      return false;
+    }
+  }
+  for (int i = 0; i < count; i++) {
+    if (colours[i].a == 0) {
+      colours[i] = s_background;
+    }
+  }
+  s_hero_cache_background = s_background;
+  return true;
+}
+#else
+static void hero_cache_save(GContext *ctx, GPoint origin) {
+  GBitmap *fb = graphics_capture_frame_buffer(ctx);
+  if (!fb) {
+    return;
+  }
+
+  int x0 = origin.x + s_cache_rect.origin.x;
+  int y0 = origin.y + s_cache_rect.origin.y;
+  uint8_t *dst = gbitmap_get_data(s_hero_cache);
+  uint16_t dst_stride = gbitmap_get_bytes_per_row(s_hero_cache);
+  for (int y = 0; y < s_cache_rect.size.h; y++) {
+    uint8_t *src = gbitmap_get_data(fb) + (y0 + y) * gbitmap_get_bytes_per_row(fb);
+    memcpy(dst + y * dst_stride, src + x0 / 8, s_cache_rect.size.w / 8);
+  }
+  graphics_release_frame_buffer(ctx, fb);
+  s_hero_cache_background = s_background;
+
+  // Loaded again only if the background changes
+  gbitmap_destroy(s_hero);
+  s_hero = NULL;
+}
+#endif
+
+static void hero_update_proc(Layer *layer, GContext *ctx) {
+#ifdef PBL_COLOR
+  if (s_hero && !gcolor_equal(s_hero_cache_background, GColorClear)) {
+    if (gcolor_equal(s_hero_cache_background, s_background)) {
+      graphics_context_set_compositing_mode(ctx, GCompOpAssign);
+      graphics_draw_bitmap_in_rect(ctx, s_hero, s_hero_rect);
+      return;
+    }
+    // Composited over another background: start again from the resource
+    gbitmap_destroy(s_hero);
+    s_hero = NULL;
+    s_hero_cache_background = GColorClear;
+  }
+#else
+  if (s_hero_cache && gcolor_equal(s_hero_cache_background, s_background)) {
+    graphics_context_set_compositing_mode(ctx, GCompOpAssign);
+    graphics_draw_bitmap_in_rect(ctx, s_hero_cache, s_cache_rect);
+    return;
+  }
+#endif
+
+  hero_load();
+#ifdef PBL_COLOR
+  if (s_hero && hero_composite()) {
+    graphics_context_set_compositing_mode(ctx, GCompOpAssign);
+    graphics_draw_bitmap_in_rect(ctx, s_hero, s_hero_rect);
+    return;
+  }
+#endif
+  graphics_context_set_fill_color(ctx, s_background);
+  graphics_fill_rect(ctx, s_cache_rect, 0, GCornerNone);
+  if (!s_hero) {
+    return;
+  }
+  graphics_context_set_compositing_mode(ctx, GCompOpSet);
+  graphics_draw_bitmap_in_rect(ctx, s_hero, s_hero_rect);
+#ifdef PBL_BW
+  if (s_hero_cache) {
+    hero_cache_save(ctx, layer_get_frame(layer).origin);
+  }
+#endif
+}
 
 static void update_time() {
   // Get a tm structure
@@ -25,36 +186,6 @@ static void tick_handler(struct tm *tick_time, TimeUnits units_changed) {
   update_time();
 }
 
-static void battery_callback(BatteryChargeState state) {
-  // Write the battery percentage into a buffer
-  static char battery_buffer[16];
-  snprintf(battery_buffer, sizeof(battery_buffer), "%d%%", state.charge_percent);
-
-  // Display this on the battery layer
-  text_layer_set_text(s_battery_layer, battery_buffer);
-
-  // Destroy old battery icon if it exists
-  if (s_battery_icon) {
-    gbitmap_destroy(s_battery_icon);
-  }
-
-  // Load the appropriate battery icon based on state
-  if (state.is_charging) {
-    s_battery_icon = gbitmap_create_with_resource(RESOURCE_ID_BATTERY_CHARGING);
-  } else if (state.charge_percent == 100) {
-    s_battery_icon = gbitmap_create_with_resource(RESOURCE_ID_BATTERY_FULL);
-  } else if (state.charge_percent >= 60) {
-    s_battery_icon = gbitmap_create_with_resource(RESOURCE_ID_BATTERY_HEALTHY);
-  } else if (state.charge_percent >= 40) {
-    s_battery_icon = gbitmap_create_with_resource(RESOURCE_ID_BATTERY_HALF);
-  } else {
-    s_battery_icon = gbitmap_create_with_resource(RESOURCE_ID_BATTERY_LOW);
-  }
-
-  // Update the battery icon layer
-  bitmap_layer_set_bitmap(s_battery_icon_layer, s_battery_icon);
-}
-
 static void init() {
   // Create main window
   s_window = window_create();
@@ -64,19 +195,23 @@ static void init() {
   Layer *window_layer = window_get_root_layer(s_window);
   GRect bounds = layer_get_bounds(window_layer);
 
-  // Load the bitmap from resources
-  s_bitmap = gbitmap_create_with_resource(RESOURCE_ID_ff34a9607b6df8921e81c1f2722fc55b);
+  s_background = GColorWhite;
+  window_set_background_color(s_window, s_background);
 
-  // Create smaller BitmapLayer centered below the time
-  int image_size = 144;
-  int image_x = 0;
-  int image_y = 36;
-  s_bitmap_layer = bitmap_layer_create(GRect(image_x, image_y, image_size, image_size));
-  bitmap_layer_set_bitmap(s_bitmap_layer, s_bitmap);
-  bitmap_layer_set_compositing_mode(s_bitmap_layer, GCompOpSet);
+  // Create the hero layer along the bottom, below the time, the artwork
+  // centered in it. Each platform gets artwork sized for its display.
+  // Without the artwork the layer is empty and nothing is cached.
+  hero_load();
+  int image_height = s_hero ? gbitmap_get_bounds(s_hero).size.h : 0;
+  GRect image_frame = GRect(0, bounds.size.h - image_height, bounds.size.w, image_height);
+  if (s_hero) {
+    hero_cache_create(image_frame);
+  }
+  s_hero_layer = layer_create(image_frame);
+  layer_set_update_proc(s_hero_layer, hero_update_proc);
 
-  // Add the bitmap layer to the window
-  layer_add_child(window_layer, bitmap_layer_get_layer(s_bitmap_layer));
+  // Add the hero layer to the window
+  layer_add_child(window_layer, s_hero_layer);
 
   // Create time TextLayer
   s_time_layer = text_layer_create(GRect(0, 10, bounds.size.w, 50));
@@ -94,54 +229,44 @@ static void init() {
   // Make sure the time is displayed from the start
   update_time();
 
-  // Create battery icon layer in top right corner
+  // Battery icon in top right corner, the percentage next to it; the
+  // status bar keeps both up to date
   int icon_size = 20;
   int icon_x = bounds.size.w - 50;
   int icon_y = 0;
-  s_battery_icon_layer = bitmap_layer_create(GRect(icon_x, icon_y, icon_size, icon_size));
-  bitmap_layer_set_compositing_mode(s_battery_icon_layer, GCompOpSet);
-  layer_add_child(window_layer, bitmap_layer_get_layer(s_battery_icon_layer));
-
-  // Create battery TextLayer next to the icon
   int battery_width = 45;
   int battery_height = 20;
   int battery_x = bounds.size.w - 50;
   int battery_y = 0;
-  s_battery_layer = text_layer_create(GRect(battery_x, battery_y, battery_width, battery_height));
-  text_layer_set_background_color(s_battery_layer, GColorClear);
-  text_layer_set_text_color(s_battery_layer, GColorBlack);
-  text_layer_set_font(s_battery_layer, fonts_get_system_font(FONT_KEY_GOTHIC_14_BOLD));
-  text_layer_set_text_alignment(s_battery_layer, GTextAlignmentRight);
-
-  // Add battery layer to the window
-  layer_add_child(window_layer, text_layer_get_layer(s_battery_layer));
-
-  // Register for battery level updates
-  battery_state_service_subscribe(battery_callback);
-
-  // Ensure battery level is displayed from the start
-  battery_callback(battery_state_service_peek());
+  status_bar_init(window_layer, GRect(icon_x, icon_y, icon_size, icon_size),
+                  GRect(battery_x, battery_y, battery_width, battery_height));
 }
 
 static void deinit() {
   // Unsubscribe from services
   tick_timer_service_unsubscribe();
-  battery_state_service_unsubscribe();
 
   // Destroy layers
-  text_layer_destroy(s_battery_layer);
+  status_bar_deinit();
   text_layer_destroy(s_time_layer);
-  bitmap_layer_destroy(s_battery_icon_layer);
-  bitmap_layer_destroy(s_bitmap_layer);
+  layer_destroy(s_hero_layer);
 
   // Destroy bitmaps
-  if (s_battery_icon) {
-    gbitmap_destroy(s_battery_icon);
+#ifdef PBL_BW
+  if (s_hero_cache) {
+    gbitmap_destroy(s_hero_cache);
+  }
+  s_hero_cache = NULL;
+#endif
+  if (s_hero) {
+    gbitmap_destroy(s_hero);
   }
-  gbitmap_destroy(s_bitmap);
+  s_hero = NULL;
 
   // Destroy window
   window_destroy(s_window);
+  profile_dump();
+  heap_trace_dump();
 }
 
 int main(void) {